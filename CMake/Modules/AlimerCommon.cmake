@@ -147,6 +147,9 @@ if( PLATFORM_WINDOWS OR PLATFORM_UWP )
 
 	# Force specific warnings as errors
 	add_compile_options(/we4101)
+elseif (ALIMER_AVX)
+	# Enable AVX instructions on GCC and Clang
+	add_compile_options(-mavx)
 endif ()
 
 # Initialize the development configuration using release configuration
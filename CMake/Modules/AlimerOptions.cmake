@@ -181,7 +181,9 @@ set (ALIMER_AVX OFF CACHE BOOL "Enable AVX instructions set support.")
 option (ALIMER_SDL "USE SDL2" ${ALIMER_SDL_DEFAULT})
 option (ALIMER_LOGGING "Enable logging" ${ALIMER_LOGGING_DEFAULT})
 option (ALIMER_PROFILING "Enable performance profiling" ${ALIMER_PROFILING_DEFAULT})
+option (ALIMER_ALLOCATION_TRACKING "Count heap allocations per profiler block. Replaces global operator new and delete" OFF)
 option (ALIMER_THREADING "Enable multithreading" ${ALIMER_THREADS_DEFAULT})
+option (ALIMER_ATOMIC_REFCOUNT "Use atomic reference counts, so that SharedPtr and WeakPtr can be used from several threads" OFF)
 option (ALIMER_SIMD "Enable SIMD (SSE, NEON) instructions" ${ALIMER_SIMD_DEFAULT})
 option (ALIMER_D3D11 "Enable D3D11 backend" ${ALIMER_D3D11_DEFAULT})
 option (ALIMER_D3D12 "Enable D3D12 backend" ${ALIMER_D3D12_DEFAULT})
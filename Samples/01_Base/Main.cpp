@@ -27,8 +27,11 @@
 #include <crtdbg.h>
 #endif
 
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
+#include <thread>
+#include <vector>
 
 using namespace Alimer;
 
@@ -60,7 +63,19 @@ public:
     }
 };
 
+class BenchmarkRefCounted : public RefCounted
+{
+};
+
 const size_t NUM_ITEMS = 10000;
+const size_t NUM_ITERATIONS = 1000000;
+const size_t NUM_THREADS = 4;
+
+/// Print the average cost of one iteration.
+void PrintTime(const char* name, const Timer& timer, size_t iterations)
+{
+    printf("%-32s %8.2f ns\n", name, timer.GetMicroseconds() * 1000.0 / iterations);
+}
 
 int main()
 {
@@ -87,6 +102,93 @@ int main()
         delete object;
         printf("Number of weak refs: %d expired: %d\n", ptr1.WeakRefs(), ptr1.IsExpired());
     }
-    
+
+    {
+        #ifdef ALIMER_ATOMIC_REFCOUNT
+        printf("\nTesting reference counting performance (atomic)\n");
+        #else
+        printf("\nTesting reference counting performance (non-atomic)\n");
+        #endif
+
+        Timer timer;
+        {
+            std::vector<SharedPtr<BenchmarkRefCounted> > objects;
+            objects.reserve(NUM_ITEMS);
+            timer.Reset();
+            for (size_t i = 0; i < NUM_ITEMS; ++i)
+                objects.push_back(SharedPtr<BenchmarkRefCounted>(new BenchmarkRefCounted()));
+            objects.clear();
+            PrintTime("Create and destroy object", timer, NUM_ITEMS);
+        }
+
+        SharedPtr<BenchmarkRefCounted> object(new BenchmarkRefCounted());
+        timer.Reset();
+        for (size_t i = 0; i < NUM_ITERATIONS; ++i)
+            SharedPtr<BenchmarkRefCounted> copy(object);
+        PrintTime("SharedPtr copy", timer, NUM_ITERATIONS);
+
+        timer.Reset();
+        for (size_t i = 0; i < NUM_ITERATIONS; ++i)
+        {
+            WeakPtr<BenchmarkRefCounted> weak(object);
+            if (weak.IsExpired())
+                break;
+        }
+        PrintTime("WeakPtr copy", timer, NUM_ITERATIONS);
+
+        WeakPtr<BenchmarkRefCounted> weakObject(object);
+        timer.Reset();
+        for (size_t i = 0; i < NUM_ITERATIONS; ++i)
+        {
+            SharedPtr<BenchmarkRefCounted> locked = weakObject.Lock();
+            if (!locked)
+                break;
+        }
+        PrintTime("WeakPtr lock", timer, NUM_ITERATIONS);
+
+        #ifdef ALIMER_ATOMIC_REFCOUNT
+        // All threads copy the same pointer, so that the reference count cache line is contended
+        std::vector<std::thread> threads;
+        timer.Reset();
+        for (size_t i = 0; i < NUM_THREADS; ++i)
+        {
+            threads.emplace_back([&object]()
+            {
+                for (size_t j = 0; j < NUM_ITERATIONS; ++j)
+                    SharedPtr<BenchmarkRefCounted> copy(object);
+            });
+        }
+        for (size_t i = 0; i < NUM_THREADS; ++i)
+            threads[i].join();
+        PrintTime("SharedPtr copy, 4 threads", timer, NUM_ITERATIONS);
+
+        // Lock weak pointers from other threads while the main thread releases the last strong reference. A locked
+        // object must never be one that is already being destroyed
+        std::atomic<size_t> revived(0);
+        for (size_t i = 0; i < NUM_ITEMS / 10; ++i)
+        {
+            SharedPtr<BenchmarkRefCounted> shared(new BenchmarkRefCounted());
+            WeakPtr<BenchmarkRefCounted> weak(shared);
+            threads.clear();
+            for (size_t j = 0; j < NUM_THREADS; ++j)
+            {
+                threads.emplace_back([&weak, &revived]()
+                {
+                    for (size_t k = 0; k < 100; ++k)
+                    {
+                        SharedPtr<BenchmarkRefCounted> locked = weak.Lock();
+                        if (locked && weak.IsExpired())
+                            ++revived;
+                    }
+                });
+            }
+            shared.Reset();
+            for (size_t j = 0; j < NUM_THREADS; ++j)
+                threads[j].join();
+        }
+        printf("WeakPtr lock during release, revived objects: %zu\n", revived.load());
+        #endif
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Alimer.h"
+#include "Renderer/Batch.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Alimer;
+
+const size_t NUM_BATCHES = 50000;
+const size_t NUM_ITERATIONS = 20;
+
+/// Fill batches with random sort keys and distances.
+void CreateBatches(std::vector<Batch>& batches, BatchSortMode mode)
+{
+    batches.resize(NUM_BATCHES);
+    for (size_t i = 0; i < NUM_BATCHES; ++i)
+    {
+        Batch& batch = batches[i];
+        batch.geometry = nullptr;
+        batch.pass = nullptr;
+        batch.lights = nullptr;
+        batch.type = GEOM_STATIC;
+        batch.worldMatrix = nullptr;
+        if (mode == SORT_STATE)
+        {
+            // Few distinct shader and material combinations, like in a real scene
+            batch.sortKey = ((uint64_t)(rand() & 0x3f) << 48) | ((uint64_t)(rand() & 0xf) << 32) | ((uint64_t)(rand() & 0xff) << 16) |
+                (uint64_t)(rand() & 0xffff);
+        }
+        else
+            batch.distance = Random(0.1f, 1000.0f);
+    }
+}
+
+/// Sort the same batches repeatedly and return the average time in microseconds.
+uint64_t Benchmark(const std::vector<Batch>& source, std::vector<Batch>& result, BatchSortMode mode, bool radixSort)
+{
+    BatchQueue queue;
+    queue.SetRadixSort(mode, radixSort);
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < NUM_ITERATIONS; ++i)
+    {
+        result = source;
+        Timer timer;
+        queue.SortBatches(result, mode);
+        total += timer.GetMicroseconds();
+    }
+
+    return total / NUM_ITERATIONS;
+}
+
+int main()
+{
+    const char* modeNames[] = { "None", "State", "Back to front", "Front to back" };
+    std::vector<Batch> source;
+    std::vector<Batch> comparisonResult;
+    std::vector<Batch> radixResult;
+    bool success = true;
+
+    printf("Sorting %zu batches, average of %zu iterations\n\n", NUM_BATCHES, NUM_ITERATIONS);
+
+    for (int mode = SORT_STATE; mode <= SORT_FRONT_TO_BACK; ++mode)
+    {
+        BatchSortMode sortMode = static_cast<BatchSortMode>(mode);
+        CreateBatches(source, sortMode);
+
+        uint64_t comparisonTime = Benchmark(source, comparisonResult, sortMode, false);
+        uint64_t radixTime = Benchmark(source, radixResult, sortMode, true);
+
+        // Both sorts must produce the same key order
+        bool match = true;
+        for (size_t i = 0; i < NUM_BATCHES; ++i)
+        {
+            if ((sortMode == SORT_STATE && comparisonResult[i].sortKey != radixResult[i].sortKey) ||
+                (sortMode != SORT_STATE && comparisonResult[i].distance != radixResult[i].distance))
+            {
+                match = false;
+                break;
+            }
+        }
+
+        printf("%-14s comparison sort %6llu us, radix sort %6llu us, speedup %.2fx%s\n", modeNames[mode],
+            (unsigned long long)comparisonTime, (unsigned long long)radixTime,
+            radixTime ? (float)comparisonTime / (float)radixTime : 0.0f, match ? "" : " ORDER MISMATCH");
+        success &= match;
+    }
+
+    return success ? 0 : 1;
+}
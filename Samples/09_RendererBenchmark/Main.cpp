@@ -0,0 +1,430 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Alimer.h"
+#include "Graphics/Null/NullGraphics.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+using namespace Alimer;
+
+/// Benchmark scene and run configuration.
+struct BenchmarkSettings
+{
+    uint32_t objects = 2000;
+    uint32_t shadowCasters = 1000;
+    uint32_t pointLights = 8;
+    uint32_t spotLights = 4;
+    uint32_t directionalLights = 1;
+    uint32_t frames = 200;
+    uint32_t warmupFrames = 10;
+    uint32_t seed = 1;
+    std::string output;
+    std::string trace;
+};
+
+/// Renderer phases reported separately in addition to the full block tree.
+const char* phaseNames[] =
+{
+    "PrepareView",
+    "CollectObjects",
+    "CollectLightInteractions",
+    "CollectBatches",
+    "RenderShadowMaps",
+    "RenderBatches"
+};
+
+void PrintUsage()
+{
+    printf("Usage: 09_RendererBenchmark [options]\n"
+        "  -objects N      Number of static models (default 2000)\n"
+        "  -casters N      Number of static models that cast shadows (default 1000)\n"
+        "  -point N        Number of shadowed point lights (default 8)\n"
+        "  -spot N         Number of shadowed spot lights (default 4)\n"
+        "  -directional N  Number of shadowed directional lights (default 1)\n"
+        "  -frames N       Number of measured frames (default 200)\n"
+        "  -warmup N       Number of frames to run before measuring (default 10)\n"
+        "  -seed N         Random seed for the scene layout (default 1)\n"
+        "  -output FILE    Write the JSON report to a file instead of stdout\n"
+        "  -trace FILE     Capture the measured frames in Chrome trace event format\n"
+        "\n"
+        "Rendering goes to the null graphics backend, so shader compilation and texture upload are not measured.\n");
+}
+
+bool ParseArguments(int argc, char** argv, BenchmarkSettings& settings)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        if (!strcmp(arg, "-help") || !strcmp(arg, "-h"))
+            return false;
+        if (i + 1 >= argc)
+        {
+            printf("Missing value for %s\n", arg);
+            return false;
+        }
+
+        const char* value = argv[++i];
+        uint32_t number = (uint32_t)strtoul(value, nullptr, 10);
+        if (!strcmp(arg, "-objects"))
+            settings.objects = number;
+        else if (!strcmp(arg, "-casters"))
+            settings.shadowCasters = number;
+        else if (!strcmp(arg, "-point"))
+            settings.pointLights = number;
+        else if (!strcmp(arg, "-spot"))
+            settings.spotLights = number;
+        else if (!strcmp(arg, "-directional"))
+            settings.directionalLights = number;
+        else if (!strcmp(arg, "-frames"))
+            settings.frames = number;
+        else if (!strcmp(arg, "-warmup"))
+            settings.warmupFrames = number;
+        else if (!strcmp(arg, "-seed"))
+            settings.seed = number;
+        else if (!strcmp(arg, "-output"))
+            settings.output = value;
+        else if (!strcmp(arg, "-trace"))
+            settings.trace = value;
+        else
+        {
+            printf("Unknown option %s\n", arg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Fill the scene with a ground plane, static models and lights. Object density stays constant regardless of the object count.
+Camera* CreateScene(Scene* scene, const BenchmarkSettings& settings)
+{
+    ResourceCache* cache = Object::GetSubsystem<ResourceCache>();
+    SetRandomSeed(settings.seed);
+
+    const float halfSize = Max(sqrtf((float)settings.objects) * 2.5f, 25.0f);
+
+    scene->CreateChild<Octree>();
+    Camera* camera = scene->CreateChild<Camera>();
+    camera->SetAmbientColor(Color(0.1f, 0.1f, 0.1f));
+    camera->SetFarClip(halfSize * 4.0f);
+
+    int groundTiles = (int)(halfSize / 10.0f);
+    for (int y = -groundTiles; y <= groundTiles; ++y)
+    {
+        for (int x = -groundTiles; x <= groundTiles; ++x)
+        {
+            StaticModel* object = scene->CreateChild<StaticModel>();
+            object->SetPosition(Vector3(10.0f * x, -0.1f, 10.0f * y));
+            object->SetScale(Vector3(10.0f, 0.1f, 10.0f));
+            object->SetModel(cache->LoadResource<Model>("Box.mdl"));
+            object->SetMaterial(cache->LoadResource<Material>("Stone.json"));
+        }
+    }
+
+    for (uint32_t i = 0; i < settings.objects; ++i)
+    {
+        StaticModel* object = scene->CreateChild<StaticModel>();
+        object->SetPosition(Vector3(Random(-halfSize, halfSize), 1.0f, Random(-halfSize, halfSize)));
+        object->SetRotation(Quaternion(0.0f, Random(360.0f), 0.0f));
+        object->SetScale(Random(1.0f, 2.0f));
+        // Mix two models so that both instanced and non-instanced batches are generated
+        if (i & 1)
+        {
+            object->SetModel(cache->LoadResource<Model>("Mushroom.mdl"));
+            object->SetMaterial(cache->LoadResource<Material>("Mushroom.json"));
+        }
+        else
+        {
+            object->SetModel(cache->LoadResource<Model>("Box.mdl"));
+            object->SetMaterial(cache->LoadResource<Material>("Stone.json"));
+        }
+        object->SetCastShadows(i < settings.shadowCasters);
+    }
+
+    for (uint32_t i = 0; i < settings.pointLights + settings.spotLights + settings.directionalLights; ++i)
+    {
+        Light* light = scene->CreateChild<Light>();
+        Vector3 colorVec = 2.0f * Vector3(Random(), Random(), Random()).Normalized();
+        light->SetColor(Color(colorVec.x, colorVec.y, colorVec.z));
+        light->SetCastShadows(true);
+
+        if (i < settings.pointLights)
+        {
+            light->SetLightType(LIGHT_POINT);
+            light->SetRange(20.0f);
+            light->SetShadowMapSize(256);
+            light->SetPosition(Vector3(Random(-halfSize, halfSize), 7.0f, Random(-halfSize, halfSize)));
+        }
+        else if (i < settings.pointLights + settings.spotLights)
+        {
+            light->SetLightType(LIGHT_SPOT);
+            light->SetFov(60.0f);
+            light->SetRange(30.0f);
+            light->SetShadowMapSize(512);
+            light->SetPosition(Vector3(Random(-halfSize, halfSize), 15.0f, Random(-halfSize, halfSize)));
+            light->SetDirection(Vector3(Random(-0.5f, 0.5f), -1.0f, Random(-0.5f, 0.5f)));
+        }
+        else
+        {
+            light->SetLightType(LIGHT_DIRECTIONAL);
+            light->SetShadowMapSize(1024);
+            light->SetDirection(Vector3(Random(-1.0f, 1.0f), -1.0f, Random(-1.0f, 1.0f)));
+        }
+    }
+
+    return camera;
+}
+
+/// Convert a profiler block and its children to JSON. Times are in milliseconds over the measured interval.
+json BlockToJSON(const ProfilerBlock* block, uint32_t frames)
+{
+    json result;
+    result["name"] = block->name;
+    result["calls"] = block->intervalCount;
+    result["totalMs"] = block->intervalTime / 1000.0;
+    result["frameMs"] = frames ? block->intervalTime / 1000.0 / frames : 0.0;
+    result["callMs"] = block->intervalCount ? block->intervalTime / 1000.0 / block->intervalCount : 0.0;
+    result["maxCallMs"] = block->_intervalMaxTime / 1000.0;
+#ifdef ALIMER_ALLOCATION_TRACKING
+    result["allocationsPerFrame"] = frames ? (double)block->_intervalAllocations / frames : 0.0;
+    result["allocatedBytesPerFrame"] = frames ? (double)block->_intervalAllocatedBytes / frames : 0.0;
+#endif
+
+    json children = json::array();
+    for (auto it = block->_children.begin(); it != block->_children.end(); ++it)
+    {
+        if ((*it)->intervalCount)
+            children.push_back(BlockToJSON(*it, frames));
+    }
+    if (!children.empty())
+        result["children"] = children;
+
+    return result;
+}
+
+/// Sum the interval time of all blocks with the given name, as some phases are entered from several places.
+void FindPhaseTime(const ProfilerBlock* block, const char* name, long long& time, unsigned& count)
+{
+    if (!strcmp(block->name, name))
+    {
+        time += block->intervalTime;
+        count += block->intervalCount;
+        // Do not count recursive entries twice
+        return;
+    }
+
+    for (auto it = block->_children.begin(); it != block->_children.end(); ++it)
+        FindPhaseTime(*it, name, time, count);
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkSettings settings;
+    if (!ParseArguments(argc, argv, settings))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    Log log;
+    log.SetLevel(LogLevel::Warn);
+    Profiler profiler;
+    JobSystem jobSystem;
+    ResourceCache cache;
+    Renderer renderer;
+
+    RegisterGraphicsLibrary();
+    RegisterResourceLibrary();
+    RegisterRendererLibrary();
+
+    const std::string executableDir = GetExecutableDir();
+    if (DirectoryExists(executableDir + "Data"))
+        cache.AddResourceDir(executableDir + "Data");
+    if (DirectoryExists(GetParentPath(executableDir) + "Data"))
+        cache.AddResourceDir(GetParentPath(executableDir) + "Data");
+
+    // Render against the null backend, so that only the CPU side of the renderer is measured
+    std::unique_ptr<Graphics> graphics(Graphics::Create(GraphicsDeviceType::Null));
+    if (!graphics || graphics->GetDeviceType() != GraphicsDeviceType::Null)
+    {
+        ALIMER_LOGERROR("Null graphics backend is not available");
+        return 1;
+    }
+
+    NullGraphics* nullGraphics = static_cast<NullGraphics*>(graphics.get());
+    nullGraphics->SetRecordCommands(false);
+
+    GraphicsSettings graphicsSettings = {};
+    graphicsSettings.window = nullptr;
+    if (!graphics->Initialize(graphicsSettings))
+    {
+        ALIMER_LOGERROR("Error while initializing graphics system");
+        return 1;
+    }
+
+    renderer.SetupShadowMaps(1, 2048, PixelFormat::Depth16UNorm);
+
+    std::unique_ptr<Scene> scene(new Scene());
+    Camera* camera = CreateScene(scene.get(), settings);
+    camera->SetAspectRatio((float)graphics->GetWidth() / (float)graphics->GetHeight());
+
+    std::vector<PassDesc> passes;
+    passes.emplace_back("opaque", SORT_STATE, true);
+    passes.emplace_back("alpha", SORT_BACK_TO_FRONT, true);
+
+    NullGraphicsStats totalStats;
+    const float orbitRadius = Max(sqrtf((float)settings.objects) * 2.5f, 25.0f);
+    const uint32_t numFrames = settings.warmupFrames + settings.frames;
+
+    for (uint32_t i = 0; i < numFrames; ++i)
+    {
+        // Start measuring after the warmup, which lets the renderer's vectors and instance buffer grow to their steady state
+        // size. The null backend never compiles the shader variations
+        if (i == settings.warmupFrames)
+        {
+            profiler.EndFrame();
+            profiler.BeginInterval();
+            if (!settings.trace.empty())
+                profiler.CaptureTrace(settings.frames);
+            totalStats.Reset();
+        }
+
+        // Orbit the camera so that the visible set changes between frames in a repeatable way
+        float yaw = 360.0f * i / numFrames;
+        camera->SetRotation(Quaternion(30.0f, yaw, 0.0f));
+        camera->SetPosition(Vector3(0.0f, orbitRadius * 0.5f, 0.0f) - camera->WorldDirection() * orbitRadius * 0.5f);
+
+        if (!graphics->BeginFrame())
+            continue;
+
+        profiler.BeginFrame();
+        {
+            ALIMER_PROFILE(PrepareView);
+            renderer.PrepareView(scene.get(), camera, passes);
+        }
+
+        renderer.RenderShadowMaps();
+        graphics->ResetRenderTargets();
+        graphics->ResetViewport();
+        graphics->Clear(ClearFlagsBits::Color | ClearFlagsBits::Depth, Color::BLACK);
+        renderer.RenderBatches(passes);
+        profiler.EndFrame();
+
+        const NullGraphicsStats& stats = nullGraphics->GetStats();
+        totalStats.numDraws += stats.numDraws;
+        totalStats.numInstancedDraws += stats.numInstancedDraws;
+        totalStats.numInstances += stats.numInstances;
+        totalStats.numElements += stats.numElements;
+        totalStats.numStateChanges += stats.numStateChanges;
+        totalStats.numShaderChanges += stats.numShaderChanges;
+        totalStats.numBufferUpdates += stats.numBufferUpdates;
+        totalStats.bufferUpdateBytes += stats.bufferUpdateBytes;
+
+        graphics->Present();
+    }
+
+    const uint32_t frames = settings.frames ? settings.frames : 1;
+    json report;
+    report["settings"] = {
+        { "objects", settings.objects },
+        { "shadowCasters", settings.shadowCasters },
+        { "pointLights", settings.pointLights },
+        { "spotLights", settings.spotLights },
+        { "directionalLights", settings.directionalLights },
+        { "frames", settings.frames },
+        { "warmupFrames", settings.warmupFrames },
+        { "seed", settings.seed },
+        { "threads", jobSystem.GetNumThreads() }
+    };
+    report["notMeasured"] = { "shaderCompilation", "textureUpload" };
+
+#ifndef ALIMER_PROFILING
+    ALIMER_LOGWARN("Built without ALIMER_PROFILING, only the frame totals are reported");
+#endif
+
+    json phases = json::object();
+    for (size_t i = 0; i < sizeof(phaseNames) / sizeof(phaseNames[0]); ++i)
+    {
+        long long time = 0;
+        unsigned count = 0;
+        FindPhaseTime(profiler.GetRootBlock(), phaseNames[i], time, count);
+        phases[phaseNames[i]] = {
+            { "calls", count },
+            { "totalMs", time / 1000.0 },
+            { "frameMs", time / 1000.0 / frames }
+        };
+    }
+    report["phases"] = phases;
+
+    json blocks = json::array();
+    const ProfilerBlock* root = profiler.GetRootBlock();
+    for (auto it = root->_children.begin(); it != root->_children.end(); ++it)
+    {
+        if ((*it)->intervalCount)
+            blocks.push_back(BlockToJSON(*it, frames));
+    }
+    report["blocks"] = blocks;
+
+    report["graphics"] = {
+        { "drawsPerFrame", (double)totalStats.numDraws / frames },
+        { "instancedDrawsPerFrame", (double)totalStats.numInstancedDraws / frames },
+        { "instancesPerFrame", (double)totalStats.numInstances / frames },
+        { "elementsPerFrame", (double)totalStats.numElements / frames },
+        { "stateChangesPerFrame", (double)totalStats.numStateChanges / frames },
+        { "shaderChangesPerFrame", (double)totalStats.numShaderChanges / frames },
+        { "bufferUpdatesPerFrame", (double)totalStats.numBufferUpdates / frames },
+        { "bufferUpdateBytesPerFrame", (double)totalStats.bufferUpdateBytes / frames }
+    };
+
+    if (!settings.trace.empty())
+    {
+        profiler.StopTrace();
+        File traceFile(settings.trace, FileMode::Write);
+        if (!traceFile.IsOpen() || !profiler.SaveTrace(traceFile))
+        {
+            ALIMER_LOGERROR("Could not write trace to " + settings.trace);
+            return 1;
+        }
+    }
+
+    const std::string text = report.dump(4);
+    if (!settings.output.empty())
+    {
+        std::ofstream file(settings.output);
+        if (!file)
+        {
+            ALIMER_LOGERROR("Could not open " + settings.output + " for writing");
+            return 1;
+        }
+        file << text << std::endl;
+    }
+    else
+        printf("%s\n", text.c_str());
+
+    scene.reset();
+    return 0;
+}
@@ -0,0 +1,209 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Alimer.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+using namespace Alimer;
+
+const size_t SCOPES_PER_FRAME = 16384;
+const size_t NUM_FRAMES = 100;
+
+/// Work inside each measured scope, so that the loop is not optimized away.
+volatile uint32_t counter = 0;
+
+/// Scope variants to measure.
+enum ScopeMode
+{
+    SCOPE_NONE = 0,
+    SCOPE_STATIC,
+    SCOPE_NAMED
+};
+
+/// Run one frame of scopes and return the time in nanoseconds.
+uint64_t RunScopes(ScopeMode mode)
+{
+    Profiler* profiler = Profiler::GetInstance();
+    uint64_t start = Profiler::GetTimestamp();
+
+    for (size_t i = 0; i < SCOPES_PER_FRAME; ++i)
+    {
+        switch (mode)
+        {
+        case SCOPE_NONE:
+            counter = counter + 1;
+            break;
+
+        case SCOPE_STATIC:
+        {
+            ALIMER_PROFILE(StaticScope);
+            counter = counter + 1;
+            break;
+        }
+
+        case SCOPE_NAMED:
+            profiler->BeginBlock("NamedScope");
+            counter = counter + 1;
+            profiler->EndBlock();
+            break;
+        }
+    }
+
+    return Profiler::GetTimestamp() - start;
+}
+
+/// Persistent worker thread that runs one frame of scopes each time it is signaled.
+class ScopeWorker
+{
+public:
+    /// Construct and start the thread.
+    ScopeWorker() :
+        _thread(&ScopeWorker::Run, this)
+    {
+    }
+
+    /// Stop and join the thread.
+    ~ScopeWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _exit = true;
+        }
+        _signal.notify_all();
+        _thread.join();
+    }
+
+    /// Run one frame of scopes on the worker and wait for it to finish. Return the time in nanoseconds.
+    uint64_t RunFrame(ScopeMode mode)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _mode = mode;
+        _pending = true;
+        _signal.notify_all();
+        _signal.wait(lock, [this]() { return !_pending; });
+        return _time;
+    }
+
+private:
+    /// Thread entry point.
+    void Run()
+    {
+        // Register with the profiler before the first frame, so that the registration is not measured
+        {
+            ALIMER_PROFILE(RegisterWorker);
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;)
+        {
+            _signal.wait(lock, [this]() { return _pending || _exit; });
+            if (_exit)
+                return;
+
+            lock.unlock();
+            uint64_t time = RunScopes(_mode);
+            lock.lock();
+
+            _time = time;
+            _pending = false;
+            _signal.notify_all();
+        }
+    }
+
+    /// Mutex for the frame request.
+    std::mutex _mutex;
+    /// Signal for frame requests and completions.
+    std::condition_variable _signal;
+    /// Scope mode of the requested frame.
+    ScopeMode _mode{ SCOPE_NONE };
+    /// Time of the last frame in nanoseconds.
+    uint64_t _time{ 0 };
+    /// Frame requested flag.
+    bool _pending{ false };
+    /// Exit requested flag.
+    bool _exit{ false };
+    /// Worker thread. Started last so that the other members are initialized.
+    std::thread _thread;
+};
+
+/// Measure scopes on the main thread, or on a worker thread if given. Return the average cost per scope in nanoseconds, excluding the loop itself.
+double Benchmark(Profiler& profiler, ScopeMode mode, ScopeWorker* worker, double baseline, double& processTime)
+{
+    uint64_t scopeTime = 0;
+    uint64_t frameEndTime = 0;
+
+    for (size_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        profiler.BeginFrame();
+        if (worker)
+            scopeTime += worker->RunFrame(mode);
+        else
+            scopeTime += RunScopes(mode);
+
+        uint64_t start = Profiler::GetTimestamp();
+        profiler.EndFrame();
+        frameEndTime += Profiler::GetTimestamp() - start;
+    }
+
+    double scopes = (double)SCOPES_PER_FRAME * NUM_FRAMES;
+    processTime = frameEndTime / scopes;
+    return scopeTime / scopes - baseline;
+}
+
+int main()
+{
+#ifndef ALIMER_PROFILING
+    printf("Built without ALIMER_PROFILING, profiler scopes compile to nothing\n");
+#endif
+
+    Profiler profiler;
+    double processTime;
+
+    printf("%zu scopes per frame, %zu frames\n\n", SCOPES_PER_FRAME, NUM_FRAMES);
+
+    double baseline = Benchmark(profiler, SCOPE_NONE, nullptr, 0.0, processTime);
+    printf("Empty loop                       %8.2f ns per iteration\n", baseline);
+
+    double staticTime = Benchmark(profiler, SCOPE_STATIC, nullptr, baseline, processTime);
+    printf("ALIMER_PROFILE, main thread      %8.2f ns per scope, %8.2f ns per scope in EndFrame\n", staticTime, processTime);
+
+    double namedTime = Benchmark(profiler, SCOPE_NAMED, nullptr, baseline, processTime);
+    printf("BeginBlock(name), main thread    %8.2f ns per scope, %8.2f ns per scope in EndFrame\n", namedTime, processTime);
+
+    ScopeWorker worker;
+    double workerTime = Benchmark(profiler, SCOPE_STATIC, &worker, baseline, processTime);
+    printf("ALIMER_PROFILE, worker thread    %8.2f ns per scope, %8.2f ns per scope in EndFrame\n", workerTime, processTime);
+
+    uint32_t dropped = 0;
+    for (size_t i = 0; i < profiler.GetNumThreads(); ++i)
+        dropped += profiler.GetThread(i)->GetNumDroppedEvents();
+    if (dropped)
+        printf("\n%u events dropped\n", dropped);
+
+    return 0;
+}
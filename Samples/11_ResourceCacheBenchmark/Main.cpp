@@ -0,0 +1,101 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Alimer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+
+using namespace Alimer;
+
+const size_t NUM_LOOKUPS = 1000000;
+
+/// Pointer sum of the looked up resources, so that the lookups are not optimized away.
+volatile uintptr_t checksum = 0;
+
+/// Return the average time of one lookup in nanoseconds.
+template <class T> double Benchmark(const T& function)
+{
+    uintptr_t sum = 0;
+    Timer timer;
+    for (size_t i = 0; i < NUM_LOOKUPS; ++i)
+        sum += reinterpret_cast<uintptr_t>(function(i));
+    double time = timer.GetMicroseconds() * 1000.0 / NUM_LOOKUPS;
+    checksum = checksum + sum;
+    return time;
+}
+
+void RunBenchmark(size_t numResources)
+{
+    ResourceCache cache;
+    StringHash type = JSONFile::GetTypeStatic();
+
+    // The tree map the cache used before, for comparison
+    std::map<std::pair<StringHash, StringHash>, SharedPtr<Resource> > treeMap;
+
+    std::vector<std::string> names;
+    std::vector<std::string> unsanitatedNames;
+    std::vector<StringHash> nameHashes;
+    for (size_t i = 0; i < numResources; ++i)
+    {
+        std::string name = "Level" + std::to_string(i % 64) + "/Resource" + std::to_string(i) + ".json";
+        JSONFile* resource = new JSONFile();
+        resource->SetName(name);
+        cache.AddManualResource(resource);
+        treeMap[std::make_pair(type, StringHash(name))] = resource;
+
+        names.push_back(name);
+        unsanitatedNames.push_back("./" + name);
+        nameHashes.push_back(StringHash(name));
+    }
+
+    // Look up in random order, so that the access pattern does not follow insertion order
+    std::vector<size_t> order(NUM_LOOKUPS);
+    std::mt19937 random(1);
+    for (size_t i = 0; i < NUM_LOOKUPS; ++i)
+        order[i] = random() % numResources;
+
+    double treeTime = Benchmark([&](size_t i) { return treeMap.find(std::make_pair(type, nameHashes[order[i]]))->second.Get(); });
+    double nameTime = Benchmark([&](size_t i) { return cache.LoadResource(type, names[order[i]]); });
+    double sanitateTime = Benchmark([&](size_t i) { return cache.LoadResource(type, unsanitatedNames[order[i]]); });
+    double hashTime = Benchmark([&](size_t i) { return cache.LoadResource(type, nameHashes[order[i]]); });
+
+    printf("%zu resources\n", numResources);
+    printf("  std::map lookup by hash          %8.2f ns\n", treeTime);
+    printf("  LoadResource(name)               %8.2f ns\n", nameTime);
+    printf("  LoadResource(unsanitated name)   %8.2f ns\n", sanitateTime);
+    printf("  LoadResource(name hash)          %8.2f ns\n\n", hashTime);
+}
+
+int main()
+{
+    RunBenchmark(1000);
+    RunBenchmark(10000);
+    RunBenchmark(100000);
+
+    return 0;
+}
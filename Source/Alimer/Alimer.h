@@ -35,12 +35,16 @@
 #include "Graphics/ShaderVariation.h"
 #include "Graphics/Texture.h"
 #include "Graphics/VertexBuffer.h"
+#include "IO/Compression.h"
 #include "IO/Console.h"
 #include "IO/File.h"
 #include "IO/FileSystem.h"
+#include "IO/MappedFile.h"
 #include "IO/MemoryBuffer.h"
+#include "IO/PackageFile.h"
 #include "IO/VectorBuffer.h"
 #include "Math/Frustum.h"
+#include "Math/FrustumSoA.h"
 #include "Math/Polyhedron.h"
 #include "Math/Random.h"
 #include "Math/Ray.h"
@@ -56,6 +60,7 @@
 #include "Resource/JSONFile.h"
 #include "Resource/ResourceCache.h"
 #include "Scene/Scene.h"
+#include "Threading/JobSystem.h"
 #include "Window/Input.h"
 #include "Window/Window.h"
 #include "Application/Time.h"
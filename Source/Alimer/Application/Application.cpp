@@ -29,6 +29,7 @@
 #include "IO/FileSystem.h"
 #include "Graphics/Graphics.h"
 #include "Renderer/Renderer.h"
+#include "Threading/JobSystem.h"
 using namespace std;
 
 #if defined(__i386__)
@@ -89,6 +90,7 @@ namespace Alimer
 #endif
 
 		_time = make_unique<Time>();
+		_jobSystem = make_unique<JobSystem>();
 		_cache = make_unique<ResourceCache>();
 		_renderer = make_unique<Renderer>();
 
@@ -164,6 +166,7 @@ namespace Alimer
 	void Application::RunFrame()
 	{
 		_time->Update();
+		_cache->Update();
 		Render();
 	}
 
@@ -32,6 +32,7 @@ namespace Alimer
 	class Graphics;
 	class Renderer;
 	class Profiler;
+	class JobSystem;
 
 	struct ApplicationSettings
 	{
@@ -93,6 +94,9 @@ namespace Alimer
 		/// Time module.
 		inline Time* GetTime() { return _time.get(); }
 
+		/// JobSystem module.
+		inline JobSystem* GetJobSystem() { return _jobSystem.get(); }
+
 		/// ResourceCache module.
 		inline ResourceCache* GetCache() { return _cache.get(); }
 
@@ -151,6 +155,9 @@ namespace Alimer
 		/// Time module.
 		std::unique_ptr<Time> _time;
 
+		/// JobSystem module.
+		std::unique_ptr<JobSystem> _jobSystem;
+
 		/// ResourceCache module.
 		std::unique_ptr<ResourceCache> _cache;
 
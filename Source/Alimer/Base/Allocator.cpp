@@ -23,6 +23,8 @@
 
 #include "Allocator.h"
 
+#include <algorithm>
+
 namespace Alimer
 {
 
@@ -35,6 +37,8 @@ static AllocatorBlock* AllocatorGetBlock(AllocatorBlock* allocator, size_t nodeS
     AllocatorBlock* newBlock = reinterpret_cast<AllocatorBlock*>(blockPtr);
     newBlock->nodeSize = nodeSize;
     newBlock->capacity = capacity;
+    newBlock->blockCapacity = capacity;
+    newBlock->used = 0;
     newBlock->free = nullptr;
     newBlock->next = nullptr;
     
@@ -100,6 +104,7 @@ void* AllocatorGet(AllocatorBlock* allocator)
     void* ptr = (reinterpret_cast<unsigned char*>(freeNode)) + sizeof(AllocatorNode);
     allocator->free = freeNode->next;
     freeNode->next = nullptr;
+    ++allocator->used;
     
     return ptr;
 }
@@ -115,6 +120,353 @@ void AllocatorFree(AllocatorBlock* allocator, void* ptr)
     // Chain the node back to free nodes
     node->next = allocator->free;
     allocator->free = node;
+    --allocator->used;
+}
+
+size_t AllocatorTrim(AllocatorBlock* allocator)
+{
+    if (!allocator || !allocator->next)
+        return 0;
+
+    size_t stride = sizeof(AllocatorNode) + allocator->nodeSize;
+
+    // The first block is the allocator handle and is never freed
+    std::vector<AllocatorBlock*> blocks;
+    for (AllocatorBlock* block = allocator->next; block; block = block->next)
+        blocks.push_back(block);
+
+    // Find the block of each free node and count free nodes per block
+    std::vector<size_t> freeCounts(blocks.size());
+    std::vector<size_t> nodeBlocks;
+    for (AllocatorNode* node = allocator->free; node; node = node->next)
+    {
+        size_t index = blocks.size();
+        unsigned char* nodePtr = reinterpret_cast<unsigned char*>(node);
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            unsigned char* start = reinterpret_cast<unsigned char*>(blocks[i]) + sizeof(AllocatorBlock);
+            if (nodePtr >= start && nodePtr < start + blocks[i]->blockCapacity * stride)
+            {
+                index = i;
+                ++freeCounts[i];
+                break;
+            }
+        }
+        nodeBlocks.push_back(index);
+    }
+
+    std::vector<bool> release(blocks.size());
+    size_t numReleased = 0;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        release[i] = freeCounts[i] == blocks[i]->blockCapacity;
+        if (release[i])
+            ++numReleased;
+    }
+
+    if (!numReleased)
+        return 0;
+
+    // Rechain the free nodes that remain, preserving their order
+    AllocatorNode* node = allocator->free;
+    AllocatorNode** link = &allocator->free;
+    for (size_t i = 0; node; ++i)
+    {
+        AllocatorNode* next = node->next;
+        if (nodeBlocks[i] == blocks.size() || !release[nodeBlocks[i]])
+        {
+            *link = node;
+            link = &node->next;
+        }
+        node = next;
+    }
+    *link = nullptr;
+
+    // Unlink and free the empty blocks
+    AllocatorBlock* previous = allocator;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        if (release[i])
+        {
+            previous->next = blocks[i]->next;
+            allocator->capacity -= blocks[i]->blockCapacity;
+            delete[] reinterpret_cast<unsigned char*>(blocks[i]);
+        }
+        else
+            previous = blocks[i];
+    }
+
+    return numReleased;
+}
+
+AllocatorStats AllocatorGetStats(AllocatorBlock* allocator)
+{
+    AllocatorStats stats = {};
+    if (!allocator)
+        return stats;
+
+    stats.liveObjects = allocator->used;
+    stats.capacity = allocator->capacity;
+    for (AllocatorBlock* block = allocator; block; block = block->next)
+    {
+        ++stats.blocks;
+        stats.bytes += sizeof(AllocatorBlock) + block->blockCapacity * (sizeof(AllocatorNode) + allocator->nodeSize);
+    }
+
+    return stats;
+}
+
+const size_t ThreadCachedPool::BATCH_SIZE;
+
+/// Source of unique pool ids.
+static std::atomic<uint32_t> nextPoolId(0);
+/// Calling thread's free lists, indexed by pool id. A plain pointer, so that it stays valid to read when objects are freed during static destruction, after the thread's thread_local objects have been destroyed.
+static thread_local std::vector<void*>* threadCaches = nullptr;
+
+/// Deletes the calling thread's free list table on thread exit.
+struct ThreadCachesDeleter
+{
+    ~ThreadCachesDeleter()
+    {
+        delete threadCaches;
+        threadCaches = nullptr;
+    }
+};
+
+static thread_local ThreadCachesDeleter threadCachesDeleter;
+
+ThreadCachedPool::ThreadCachedPool(size_t nodeSize, size_t initialCapacity) :
+    _id(nextPoolId++),
+    _initialCapacity(initialCapacity ? initialCapacity : BATCH_SIZE)
+{
+    // Free nodes store the link in the node itself, so the node must fit a pointer. Keep nodes aligned like heap allocations
+    const size_t alignment = alignof(std::max_align_t);
+    _nodeSize = (std::max(nodeSize, sizeof(FreeNode)) + alignment - 1) & ~(alignment - 1);
+}
+
+ThreadCachedPool::~ThreadCachedPool()
+{
+    for (auto it = _blocks.begin(); it != _blocks.end(); ++it)
+        delete[] it->data;
+}
+
+void* ThreadCachedPool::Allocate()
+{
+    ThreadCache* cache = GetThreadCache();
+    if (!cache->head)
+        Refill(cache);
+
+    FreeNode* node = cache->head;
+    cache->head = node->next;
+    --cache->count;
+    cache->live.store(cache->live.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    return node;
+}
+
+void ThreadCachedPool::Free(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    ThreadCache* cache = GetThreadCache();
+    FreeNode* node = static_cast<FreeNode*>(ptr);
+    node->next = cache->head;
+    cache->head = node;
+    ++cache->count;
+    cache->live.store(cache->live.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+
+    // Keep one batch for the next allocations and return the rest, so that a thread which only frees does not hoard nodes
+    if (cache->count >= 2 * BATCH_SIZE)
+        Release(cache);
+}
+
+void ThreadCachedPool::Reset()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto it = _blocks.begin(); it != _blocks.end(); ++it)
+        delete[] it->data;
+    _blocks.clear();
+    _batches.clear();
+    _capacity = 0;
+
+    for (auto it = _caches.begin(); it != _caches.end(); ++it)
+    {
+        (*it)->head = nullptr;
+        (*it)->count = 0;
+        (*it)->live.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t ThreadCachedPool::Trim()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Gather all free nodes from the shared pool and the threads
+    std::vector<FreeNode*> freeNodes;
+    for (auto it = _batches.begin(); it != _batches.end(); ++it)
+    {
+        for (FreeNode* node = it->head; node; node = node->next)
+            freeNodes.push_back(node);
+    }
+    for (auto it = _caches.begin(); it != _caches.end(); ++it)
+    {
+        for (FreeNode* node = (*it)->head; node; node = node->next)
+            freeNodes.push_back(node);
+        (*it)->head = nullptr;
+        (*it)->count = 0;
+    }
+    _batches.clear();
+
+    // Count free nodes per block by address
+    std::sort(_blocks.begin(), _blocks.end(), [](const Block& lhs, const Block& rhs) { return lhs.data < rhs.data; });
+    std::sort(freeNodes.begin(), freeNodes.end());
+
+    std::vector<size_t> freeCounts(_blocks.size());
+    size_t blockIndex = 0;
+    for (auto it = freeNodes.begin(); it != freeNodes.end(); ++it)
+    {
+        uint8_t* nodePtr = reinterpret_cast<uint8_t*>(*it);
+        while (nodePtr >= _blocks[blockIndex].data + _blocks[blockIndex].capacity * _nodeSize)
+            ++blockIndex;
+        ++freeCounts[blockIndex];
+    }
+
+    // Free the empty blocks, and return the other free nodes to the shared pool
+    std::vector<Block> keptBlocks;
+    size_t numReleased = 0;
+    Batch batch = { nullptr, 0 };
+    blockIndex = 0;
+    for (auto it = freeNodes.begin(); it != freeNodes.end(); ++it)
+    {
+        uint8_t* nodePtr = reinterpret_cast<uint8_t*>(*it);
+        while (nodePtr >= _blocks[blockIndex].data + _blocks[blockIndex].capacity * _nodeSize)
+            ++blockIndex;
+        if (freeCounts[blockIndex] == _blocks[blockIndex].capacity)
+            continue;
+
+        (*it)->next = batch.head;
+        batch.head = *it;
+        if (++batch.count == BATCH_SIZE)
+        {
+            _batches.push_back(batch);
+            batch = { nullptr, 0 };
+        }
+    }
+    if (batch.count)
+        _batches.push_back(batch);
+
+    for (size_t i = 0; i < _blocks.size(); ++i)
+    {
+        if (freeCounts[i] == _blocks[i].capacity)
+        {
+            _capacity -= _blocks[i].capacity;
+            delete[] _blocks[i].data;
+            ++numReleased;
+        }
+        else
+            keptBlocks.push_back(_blocks[i]);
+    }
+    _blocks.swap(keptBlocks);
+
+    return numReleased;
+}
+
+AllocatorStats ThreadCachedPool::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    AllocatorStats stats = {};
+    int64_t live = 0;
+    for (auto it = _caches.begin(); it != _caches.end(); ++it)
+        live += (*it)->live.load(std::memory_order_relaxed);
+
+    stats.liveObjects = live > 0 ? static_cast<size_t>(live) : 0;
+    stats.blocks = _blocks.size();
+    stats.capacity = _capacity;
+    stats.bytes = _capacity * _nodeSize;
+    return stats;
+}
+
+ThreadCachedPool::ThreadCache* ThreadCachedPool::GetThreadCache()
+{
+    if (threadCaches && _id < threadCaches->size() && (*threadCaches)[_id])
+        return static_cast<ThreadCache*>((*threadCaches)[_id]);
+
+    ThreadCache* cache = new ThreadCache();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _caches.emplace_back(cache);
+    }
+
+    if (!threadCaches)
+    {
+        // Register the deleter for this thread. If the thread's thread_local objects have already been destroyed, the table leaks at exit
+        (void)threadCachesDeleter;
+        threadCaches = new std::vector<void*>();
+    }
+    if (threadCaches->size() <= _id)
+        threadCaches->resize(_id + 1);
+    (*threadCaches)[_id] = cache;
+    return cache;
+}
+
+void ThreadCachedPool::Refill(ThreadCache* cache)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_batches.empty())
+    {
+        // Grow by 50% like the single-threaded allocator
+        AddBlock(_capacity ? std::max((_capacity + 1) >> 1, BATCH_SIZE) : _initialCapacity);
+    }
+
+    Batch batch = _batches.back();
+    _batches.pop_back();
+    cache->head = batch.head;
+    cache->count = batch.count;
+}
+
+void ThreadCachedPool::Release(ThreadCache* cache)
+{
+    Batch batch;
+    batch.head = cache->head;
+    batch.count = BATCH_SIZE;
+
+    FreeNode* last = cache->head;
+    for (size_t i = 1; i < BATCH_SIZE; ++i)
+        last = last->next;
+    cache->head = last->next;
+    cache->count -= BATCH_SIZE;
+    last->next = nullptr;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _batches.push_back(batch);
+}
+
+void ThreadCachedPool::AddBlock(size_t capacity)
+{
+    Block block;
+    block.data = new uint8_t[capacity * _nodeSize];
+    block.capacity = capacity;
+    _blocks.push_back(block);
+    _capacity += capacity;
+
+    // Split into batches. Chain the nodes in address order so that consecutive allocations are adjacent in memory
+    for (size_t start = 0; start < capacity; start += BATCH_SIZE)
+    {
+        size_t count = std::min(BATCH_SIZE, capacity - start);
+        Batch batch;
+        batch.head = reinterpret_cast<FreeNode*>(block.data + start * _nodeSize);
+        batch.count = count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            FreeNode* node = reinterpret_cast<FreeNode*>(block.data + (start + i) * _nodeSize);
+            node->next = i + 1 < count ? reinterpret_cast<FreeNode*>(block.data + (start + i + 1) * _nodeSize) : nullptr;
+        }
+        _batches.push_back(batch);
+    }
 }
 
 }
@@ -4,8 +4,13 @@
 
 #include "../AlimerConfig.h"
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <new>
+#include <vector>
 
 namespace Alimer
 {
@@ -18,8 +23,12 @@ namespace Alimer
 	{
 		/// Size of a node.
 		size_t nodeSize;
-		/// Number of nodes in this block.
+		/// Number of nodes in this block. In the first block, number of nodes in the whole chain.
 		size_t capacity;
+		/// Number of nodes in this block, also for the first block.
+		size_t blockCapacity;
+		/// Number of allocated nodes in the whole chain. Only tracked in the first block.
+		size_t used;
 		/// First free node.
 		AllocatorNode* free;
 		/// Next allocator block.
@@ -35,6 +44,19 @@ namespace Alimer
 		/// Data follows.
 	};
 
+	/// %Allocator statistics.
+	struct ALIMER_API AllocatorStats
+	{
+		/// Number of allocated objects.
+		size_t liveObjects;
+		/// Number of memory blocks.
+		size_t blocks;
+		/// Number of nodes in all blocks.
+		size_t capacity;
+		/// Bytes reserved by all blocks.
+		size_t bytes;
+	};
+
 	/// Initialize a fixed-size allocator with the node size and initial capacity.
 	ALIMER_API AllocatorBlock* AllocatorInitialize(size_t nodeSize, size_t initialCapacity = 1);
 	/// Uninitialize a fixed-size allocator. Frees all blocks in the chain.
@@ -43,6 +65,107 @@ namespace Alimer
 	ALIMER_API void* AllocatorGet(AllocatorBlock* allocator);
 	/// Free a node. Does not free any blocks.
 	ALIMER_API void AllocatorFree(AllocatorBlock* allocator, void* node);
+	/// Free blocks other than the first whose nodes are all free. Return number of blocks freed.
+	ALIMER_API size_t AllocatorTrim(AllocatorBlock* allocator);
+	/// Return allocator statistics.
+	ALIMER_API AllocatorStats AllocatorGetStats(AllocatorBlock* allocator);
+
+	/// Thread-safe fixed-size allocator. Each thread allocates from and frees to its own free list without locking; nodes move between the threads and a shared pool in batches.
+	class ALIMER_API ThreadCachedPool
+	{
+	public:
+		/// Number of nodes moved at a time between a thread's free list and the shared pool.
+		static const size_t BATCH_SIZE = 32;
+
+		/// Construct with node size and optional initial capacity.
+		ThreadCachedPool(size_t nodeSize, size_t initialCapacity = 0);
+		/// Destruct. Frees all blocks.
+		~ThreadCachedPool();
+
+		/// Allocate a node. Can be called from any thread.
+		void* Allocate();
+		/// Free a node. Can be called from any thread, also other than the one that allocated it.
+		void Free(void* node);
+		/// Free all blocks. All nodes must have been freed, and no other thread may use the pool at the same time.
+		void Reset();
+		/// Free blocks whose nodes are all free, including nodes cached by threads. No other thread may use the pool at the same time. Return number of blocks freed.
+		size_t Trim();
+
+		/// Return statistics. The live object count is approximate while other threads are allocating.
+		AllocatorStats GetStats() const;
+		/// Return node size.
+		size_t GetNodeSize() const { return _nodeSize; }
+
+	private:
+		/// Prevent copy construction.
+		ThreadCachedPool(const ThreadCachedPool&) = delete;
+		/// Prevent assignment.
+		ThreadCachedPool& operator = (const ThreadCachedPool&) = delete;
+
+		/// Free node.
+		struct FreeNode
+		{
+			/// Next free node.
+			FreeNode* next;
+		};
+
+		/// Chain of free nodes in the shared pool.
+		struct Batch
+		{
+			/// First node.
+			FreeNode* head;
+			/// Number of nodes.
+			size_t count;
+		};
+
+		/// Free list of one thread.
+		struct ThreadCache
+		{
+			/// First free node.
+			FreeNode* head{};
+			/// Number of free nodes.
+			size_t count{};
+			/// Allocations minus frees made by the thread. Only written by the owning thread.
+			std::atomic<int64_t> live{ 0 };
+			/// Padding to keep the threads' free lists on separate cache lines.
+			uint8_t padding[64];
+		};
+
+		/// Memory block.
+		struct Block
+		{
+			/// Node memory.
+			uint8_t* data;
+			/// Number of nodes.
+			size_t capacity;
+		};
+
+		/// Return the calling thread's free list, creating it on first use.
+		ThreadCache* GetThreadCache();
+		/// Move a batch of nodes from the shared pool to a thread's free list, allocating a new block if necessary.
+		void Refill(ThreadCache* cache);
+		/// Move a batch of nodes from a thread's free list to the shared pool.
+		void Release(ThreadCache* cache);
+		/// Allocate a block and split it into batches. The mutex must be held.
+		void AddBlock(size_t capacity);
+
+		/// Node size rounded up for alignment.
+		size_t _nodeSize;
+		/// Unique pool id, used to index the thread-local free list table.
+		uint32_t _id;
+		/// Memory blocks.
+		std::vector<Block> _blocks;
+		/// Number of nodes in all blocks.
+		size_t _capacity{};
+		/// Initial capacity for the first block.
+		size_t _initialCapacity;
+		/// Free node batches in the shared pool.
+		std::vector<Batch> _batches;
+		/// Per-thread free lists.
+		std::vector<std::unique_ptr<ThreadCache>> _caches;
+		/// Mutex for the blocks, the shared pool and registering threads.
+		mutable std::mutex _mutex;
+	};
 
 	/// %Allocator template class. Allocates objects of a specific class.
 	template <class T> class Allocator
@@ -105,6 +228,11 @@ namespace Alimer
 			allocator = nullptr;
 		}
 
+		/// Free blocks whose objects have all been freed. The first block is kept. Return number of blocks freed.
+		size_t Trim() { return AllocatorTrim(allocator); }
+		/// Return statistics.
+		AllocatorStats GetStats() const { return AllocatorGetStats(allocator); }
+
 	private:
 		/// Prevent copy construction.
 		Allocator(const Allocator<T>&) = delete;
@@ -115,4 +243,56 @@ namespace Alimer
 		AllocatorBlock* allocator;
 	};
 
+	/// Thread-safe %Allocator template class. Allocates objects of a specific class from a ThreadCachedPool.
+	template <class T> class ThreadCachedAllocator
+	{
+	public:
+		/// Construct with optional initial capacity.
+		ThreadCachedAllocator(size_t capacity = 0) :
+			pool(sizeof(T), capacity)
+		{
+		}
+
+		/// Allocate and default-construct an object.
+		T* Allocate()
+		{
+			T* newObject = static_cast<T*>(pool.Allocate());
+			new(newObject) T();
+
+			return newObject;
+		}
+
+		/// Allocate and copy-construct an object.
+		T* Allocate(const T& object)
+		{
+			T* newObject = static_cast<T*>(pool.Allocate());
+			new(newObject) T(object);
+
+			return newObject;
+		}
+
+		/// Destruct and free an object.
+		void Free(T* object)
+		{
+			(object)->~T();
+			pool.Free(object);
+		}
+
+		/// Free all memory. All objects should be freed before this is called, and no other thread may use the allocator at the same time.
+		void Reset() { pool.Reset(); }
+		/// Free blocks whose objects have all been freed. No other thread may use the allocator at the same time. Return number of blocks freed.
+		size_t Trim() { return pool.Trim(); }
+		/// Return statistics.
+		AllocatorStats GetStats() const { return pool.GetStats(); }
+
+	private:
+		/// Prevent copy construction.
+		ThreadCachedAllocator(const ThreadCachedAllocator<T>&) = delete;
+		/// Prevent assignment.
+		ThreadCachedAllocator<T>& operator = (const ThreadCachedAllocator<T>&) = delete;
+
+		/// Node pool.
+		ThreadCachedPool pool;
+	};
+
 }
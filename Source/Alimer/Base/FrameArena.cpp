@@ -0,0 +1,101 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "FrameArena.h"
+#include <algorithm>
+
+namespace Alimer
+{
+	LinearArena::LinearArena(size_t blockSize)
+		: _blockSize(blockSize ? blockSize : 1)
+	{
+	}
+
+	LinearArena::~LinearArena()
+	{
+		for (auto it = _blocks.begin(); it != _blocks.end(); ++it)
+			delete[] it->data;
+	}
+
+	void* LinearArena::Allocate(size_t size, size_t alignment)
+	{
+		if (!size)
+			size = 1;
+
+		if (!_blocks.empty())
+		{
+			Block& block = _blocks.back();
+			uintptr_t address = reinterpret_cast<uintptr_t>(block.data) + _offset;
+			size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+			if (_offset + padding + size <= block.size)
+			{
+				_offset += padding + size;
+				_usedBytes += padding + size;
+				_peakBytes = std::max(_peakBytes, _usedBytes);
+				return reinterpret_cast<void*>(address + padding);
+			}
+		}
+
+		// Grow geometrically so that the number of blocks stays small until the next reset merges them
+		AddBlock(std::max(size + alignment, std::max(_blockSize, _capacity)));
+		return Allocate(size, alignment);
+	}
+
+	void LinearArena::Reset()
+	{
+		if (_blocks.size() > 1)
+		{
+			size_t capacity = _capacity;
+			for (auto it = _blocks.begin(); it != _blocks.end(); ++it)
+				delete[] it->data;
+			_blocks.clear();
+			_capacity = 0;
+			AddBlock(capacity);
+		}
+
+		_offset = 0;
+		_usedBytes = 0;
+	}
+
+	void LinearArena::AddBlock(size_t size)
+	{
+		Block block;
+		block.data = new uint8_t[size];
+		block.size = size;
+		_blocks.push_back(block);
+		_capacity += size;
+		_offset = 0;
+	}
+
+	FrameArena::FrameArena(size_t blockSize)
+		: _arenas{ { blockSize }, { blockSize } }
+	{
+	}
+
+	void FrameArena::BeginFrame()
+	{
+		_current ^= 1;
+		_arenas[_current].Reset();
+	}
+}
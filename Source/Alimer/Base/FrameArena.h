@@ -0,0 +1,174 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../AlimerConfig.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace Alimer
+{
+	/// Linear (bump) allocator. Allocations are freed all at once by Reset(). Not thread-safe.
+	class ALIMER_API LinearArena
+	{
+	public:
+		/// Construct with initial block size in bytes.
+		LinearArena(size_t blockSize = 64 * 1024);
+		/// Destruct. Frees all blocks.
+		~LinearArena();
+
+		/// Allocate memory with the given alignment, which must be a power of two. Grows by adding a new block if necessary.
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+		/// Free all allocations. If several blocks were used, they are replaced with a single block large enough for all of them, so that steady-state usage does not allocate.
+		void Reset();
+
+		/// Return bytes allocated since the last reset, including alignment padding.
+		size_t GetUsedBytes() const { return _usedBytes; }
+		/// Return largest usage since construction.
+		size_t GetPeakBytes() const { return _peakBytes; }
+		/// Return total capacity of the blocks.
+		size_t GetCapacity() const { return _capacity; }
+		/// Return number of blocks.
+		size_t GetNumBlocks() const { return _blocks.size(); }
+
+	private:
+		/// Prevent copy construction.
+		LinearArena(const LinearArena&) = delete;
+		/// Prevent assignment.
+		LinearArena& operator = (const LinearArena&) = delete;
+
+		/// Add a block of at least the given size and make it current.
+		void AddBlock(size_t size);
+
+		/// Memory block.
+		struct Block
+		{
+			/// Block memory.
+			uint8_t* data;
+			/// Block size in bytes.
+			size_t size;
+		};
+
+		/// Blocks in allocation order. The last one is current.
+		std::vector<Block> _blocks;
+		/// Offset within the current block.
+		size_t _offset{};
+		/// Minimum size for new blocks.
+		size_t _blockSize;
+		/// Bytes allocated since the last reset.
+		size_t _usedBytes{};
+		/// Largest usage since construction.
+		size_t _peakBytes{};
+		/// Total capacity.
+		size_t _capacity{};
+	};
+
+	/// Double-buffered linear arena for per-frame data. Allocations stay valid until the end of the frame after the one they were made in, so data can be consumed one frame later without copying. Not thread-safe.
+	class ALIMER_API FrameArena
+	{
+	public:
+		/// Construct with initial block size in bytes for each buffer.
+		FrameArena(size_t blockSize = 64 * 1024);
+
+		/// Begin a new frame. Switches to the other buffer and frees its allocations, which were made two frames ago.
+		void BeginFrame();
+		/// Allocate memory from the current frame's buffer.
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return _arenas[_current].Allocate(size, alignment); }
+
+		/// Return the current frame's buffer.
+		LinearArena& GetCurrent() { return _arenas[_current]; }
+		/// Return the previous frame's buffer.
+		LinearArena& GetPrevious() { return _arenas[_current ^ 1]; }
+
+	private:
+		/// Prevent copy construction.
+		FrameArena(const FrameArena&) = delete;
+		/// Prevent assignment.
+		FrameArena& operator = (const FrameArena&) = delete;
+
+		/// Arena buffers.
+		LinearArena _arenas[2];
+		/// Index of the current buffer.
+		size_t _current{};
+	};
+
+	/// STL allocator that allocates from a FrameArena. Deallocation is a no-op; memory is reclaimed when the arena moves past the frame. Containers using it must be cleared before their memory is reused, i.e. at least once per frame. Without an arena, falls back to the heap.
+	template <class T> class ArenaAllocator
+	{
+	public:
+		typedef T value_type;
+
+		/// Construct with arena.
+		ArenaAllocator(FrameArena* arena = nullptr) noexcept :
+			_arena(arena)
+		{
+		}
+
+		/// Copy-construct from an allocator of another type.
+		template <class U> ArenaAllocator(const ArenaAllocator<U>& other) noexcept :
+			_arena(other.GetArena())
+		{
+		}
+
+		/// Allocate memory for n objects.
+		T* allocate(size_t n)
+		{
+			if (_arena)
+				return static_cast<T*>(_arena->Allocate(n * sizeof(T), alignof(T)));
+
+			void* ptr = malloc(n * sizeof(T));
+			if (!ptr)
+			{
+#if !defined(__GNUC__) || __EXCEPTIONS
+				throw std::bad_alloc();
+#else
+				abort();
+#endif
+			}
+			return static_cast<T*>(ptr);
+		}
+
+		/// Free memory. Only heap fallback allocations are actually freed.
+		void deallocate(T* ptr, size_t) noexcept
+		{
+			if (!_arena)
+				free(ptr);
+		}
+
+		/// Return the arena.
+		FrameArena* GetArena() const { return _arena; }
+
+	private:
+		/// Arena to allocate from.
+		FrameArena* _arena;
+	};
+
+	template <class T, class U> bool operator == (const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) { return lhs.GetArena() == rhs.GetArena(); }
+	template <class T, class U> bool operator != (const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) { return lhs.GetArena() != rhs.GetArena(); }
+}
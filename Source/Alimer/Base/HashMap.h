@@ -26,6 +26,7 @@
 #include "../PlatformDef.h"
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace Alimer
 {
@@ -42,6 +43,249 @@ namespace Alimer
 	template <typename T>
 	using HashMap = std::unordered_map<Hash, T, UnityHasher>;
 
+	/// Open addressing hash map from 64-bit hashes to values, using linear probing. Entries are stored contiguously, so lookups touch far less memory than HashMap. Erased entries leave a tombstone until the next rehash, so erasing while iterating is safe.
+	template <typename T>
+	class OpenHashMap
+	{
+	public:
+		/// Key-value pair. Named like std::pair for drop-in use.
+		struct Entry
+		{
+			/// Key.
+			Hash first;
+			/// Value.
+			T second;
+		};
+
+		/// Iterator over the used entries.
+		template <typename MapType, typename EntryType>
+		class IteratorBase
+		{
+		public:
+			/// Construct at a slot index, advancing to the first used slot.
+			IteratorBase(MapType* map, size_t index) :
+				_map(map),
+				_index(index)
+			{
+				SkipUnused();
+			}
+
+			/// Advance to the next used entry.
+			IteratorBase& operator ++ ()
+			{
+				++_index;
+				SkipUnused();
+				return *this;
+			}
+
+			/// Advance to the next used entry, postfix version.
+			IteratorBase operator ++ (int)
+			{
+				IteratorBase ret = *this;
+				++*this;
+				return ret;
+			}
+
+			/// Point to the entry.
+			EntryType* operator -> () const { return &_map->_entries[_index]; }
+			/// Dereference the entry.
+			EntryType& operator * () const { return _map->_entries[_index]; }
+			/// Test for equality with another iterator.
+			bool operator == (const IteratorBase& rhs) const { return _index == rhs._index; }
+			/// Test for inequality with another iterator.
+			bool operator != (const IteratorBase& rhs) const { return _index != rhs._index; }
+
+			/// Return slot index.
+			size_t GetIndex() const { return _index; }
+
+		private:
+			/// Skip empty and erased slots.
+			void SkipUnused()
+			{
+				while (_index < _map->_states.size() && _map->_states[_index] != SLOT_USED)
+					++_index;
+			}
+
+			/// Map.
+			MapType* _map;
+			/// Slot index.
+			size_t _index;
+		};
+
+		typedef IteratorBase<OpenHashMap<T>, Entry> Iterator;
+		typedef IteratorBase<const OpenHashMap<T>, const Entry> ConstIterator;
+
+		/// Return iterator to the first entry.
+		Iterator begin() { return Iterator(this, 0); }
+		/// Return iterator to the end.
+		Iterator end() { return Iterator(this, _states.size()); }
+		/// Return const iterator to the first entry.
+		ConstIterator begin() const { return ConstIterator(this, 0); }
+		/// Return const iterator to the end.
+		ConstIterator end() const { return ConstIterator(this, _states.size()); }
+
+		/// Find an entry. Return end() if not found.
+		Iterator find(Hash key) { return Iterator(this, FindIndex(key)); }
+		/// Find an entry, const version. Return end() if not found.
+		ConstIterator find(Hash key) const { return ConstIterator(this, FindIndex(key)); }
+
+		/// Return the value for a key, inserting a default-constructed value if not found.
+		T& operator [] (Hash key)
+		{
+			size_t index = FindIndex(key);
+			if (index != _states.size())
+				return _entries[index].second;
+
+			// Keep at most three quarters of the slots occupied by live or erased entries
+			if ((_size + _numErased + 1) * 4 > _states.size() * 3)
+				Rehash(_size + 1 > _states.size() / 2 ? _states.size() * 2 : _states.size());
+
+			index = SlotIndex(key);
+			while (_states[index] == SLOT_USED)
+				index = (index + 1) & (_states.size() - 1);
+
+			if (_states[index] == SLOT_ERASED)
+				--_numErased;
+			_states[index] = SLOT_USED;
+			_entries[index].first = key;
+			++_size;
+			return _entries[index].second;
+		}
+
+		/// Erase an entry by key. Return true if was found.
+		bool erase(Hash key)
+		{
+			size_t index = FindIndex(key);
+			if (index == _states.size())
+				return false;
+
+			EraseIndex(index);
+			return true;
+		}
+
+		/// Erase an entry by iterator. Return iterator to the next entry.
+		Iterator erase(const Iterator& it)
+		{
+			EraseIndex(it.GetIndex());
+			return Iterator(this, it.GetIndex() + 1);
+		}
+
+		/// Erase all entries. Keep the allocated slots.
+		void clear()
+		{
+			for (size_t i = 0; i < _states.size(); ++i)
+			{
+				if (_states[i] == SLOT_USED)
+					_entries[i].second = T();
+				_states[i] = SLOT_EMPTY;
+			}
+			_size = 0;
+			_numErased = 0;
+		}
+
+		/// Reserve slots for a number of entries without rehashing.
+		void reserve(size_t count)
+		{
+			size_t slots = MIN_SLOTS;
+			while (slots * 3 < count * 4)
+				slots <<= 1;
+			if (slots > _states.size())
+				Rehash(slots);
+		}
+
+		/// Return number of entries.
+		size_t size() const { return _size; }
+		/// Return whether has no entries.
+		bool empty() const { return _size == 0; }
+		/// Return number of slots.
+		size_t GetNumSlots() const { return _states.size(); }
+
+	private:
+		/// Slot state.
+		enum SlotState : uint8_t
+		{
+			SLOT_EMPTY = 0,
+			SLOT_USED,
+			SLOT_ERASED
+		};
+
+		/// Minimum number of slots.
+		static const size_t MIN_SLOTS = 16;
+
+		/// Return the home slot of a key. Fibonacci hashing spreads keys whose entropy is only in some bits.
+		size_t SlotIndex(Hash key) const
+		{
+			return static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> _shift);
+		}
+
+		/// Return the slot index of a key, or the number of slots if not found.
+		size_t FindIndex(Hash key) const
+		{
+			size_t numSlots = _states.size();
+			if (!_size)
+				return numSlots;
+
+			for (size_t index = SlotIndex(key);; index = (index + 1) & (numSlots - 1))
+			{
+				if (_states[index] == SLOT_EMPTY)
+					return numSlots;
+				if (_states[index] == SLOT_USED && _entries[index].first == key)
+					return index;
+			}
+		}
+
+		/// Erase the entry at a slot.
+		void EraseIndex(size_t index)
+		{
+			_entries[index].second = T();
+			_states[index] = SLOT_ERASED;
+			--_size;
+			++_numErased;
+		}
+
+		/// Reallocate the slots and reinsert the live entries, dropping the tombstones.
+		void Rehash(size_t numSlots)
+		{
+			if (numSlots < MIN_SLOTS)
+				numSlots = MIN_SLOTS;
+
+			std::vector<Entry> oldEntries(numSlots);
+			std::vector<uint8_t> oldStates(numSlots, SLOT_EMPTY);
+			oldEntries.swap(_entries);
+			oldStates.swap(_states);
+
+			_shift = 64;
+			for (size_t slots = numSlots; slots > 1; slots >>= 1)
+				--_shift;
+
+			for (size_t i = 0; i < oldStates.size(); ++i)
+			{
+				if (oldStates[i] != SLOT_USED)
+					continue;
+
+				size_t index = SlotIndex(oldEntries[i].first);
+				while (_states[index] == SLOT_USED)
+					index = (index + 1) & (numSlots - 1);
+				_states[index] = SLOT_USED;
+				_entries[index].first = oldEntries[i].first;
+				_entries[index].second = std::move(oldEntries[i].second);
+			}
+
+			_numErased = 0;
+		}
+
+		/// Entries.
+		std::vector<Entry> _entries;
+		/// Slot states.
+		std::vector<uint8_t> _states;
+		/// Number of live entries.
+		size_t _size = 0;
+		/// Number of erased entries.
+		size_t _numErased = 0;
+		/// Shift for the home slot calculation.
+		uint32_t _shift = 64;
+	};
+
 	class Hasher
 	{
 	public:
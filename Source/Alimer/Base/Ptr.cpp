@@ -21,11 +21,43 @@
 // THE SOFTWARE.
 //
 
+#include "Allocator.h"
 #include "Ptr.h"
 
 namespace Alimer
 {
 
+#ifdef ALIMER_ATOMIC_REFCOUNT
+	/// Return the reference count pool. Pooled, because every object that is pointed to allocates one, often from several threads. Never destroyed, as static objects such as the default material release their reference counts during static destruction.
+	static ThreadCachedAllocator<RefCount>& GetRefCountAllocator()
+	{
+		static auto* allocator = new ThreadCachedAllocator<RefCount>();
+		return *allocator;
+	}
+
+	RefCount* RefCount::Allocate()
+	{
+		return GetRefCountAllocator().Allocate();
+	}
+
+	void RefCount::ReleaseWeakRef()
+	{
+		if (--weakRefs == 0)
+			GetRefCountAllocator().Free(this);
+	}
+#else
+	RefCount* RefCount::Allocate()
+	{
+		return new RefCount();
+	}
+
+	void RefCount::ReleaseWeakRef()
+	{
+		if (--weakRefs == 0)
+			delete this;
+	}
+#endif
+
 	RefCounted::RefCounted() :
 		refCount(nullptr)
 	{
@@ -33,38 +65,44 @@ namespace Alimer
 
 	RefCounted::~RefCounted()
 	{
-		if (refCount)
+		RefCount* count = refCount;
+		if (count)
 		{
-			assert(refCount->refs == 0);
-			if (refCount->weakRefs == 0)
-				delete refCount;
-			else
-				refCount->expired = true;
+			assert(count->refs == 0);
+			count->expired = true;
+			count->ReleaseWeakRef();
 		}
 	}
 
 	void RefCounted::AddRef()
 	{
-		if (!refCount)
-			refCount = new RefCount();
-
-		++(refCount->refs);
+		++(RefCountPtr()->refs);
 	}
 
 	void RefCounted::ReleaseRef()
 	{
-		assert(refCount && refCount->refs > 0);
-		--(refCount->refs);
-		if (refCount->refs == 0)
+		RefCount* count = refCount;
+		assert(count && count->refs > 0);
+		if (--(count->refs) == 0)
 			delete this;
 	}
 
-	RefCount* RefCounted::RefCountPtr()
+	RefCount* RefCounted::AllocateRefCount()
 	{
-		if (!refCount)
-			refCount = new RefCount();
+		RefCount* count = RefCount::Allocate();
+
+#ifdef ALIMER_ATOMIC_REFCOUNT
+		RefCount* expected = nullptr;
+		if (!refCount.compare_exchange_strong(expected, count))
+		{
+			count->ReleaseWeakRef();
+			return expected;
+		}
+#else
+		refCount = count;
+#endif
 
-		return refCount;
+		return count;
 	}
 
 }
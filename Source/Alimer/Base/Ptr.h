@@ -6,6 +6,9 @@
 
 #include <cassert>
 #include <cstddef>
+#ifdef ALIMER_ATOMIC_REFCOUNT
+#include <atomic>
+#endif
 
 namespace Alimer
 {
@@ -13,23 +16,62 @@ namespace Alimer
 	class RefCounted;
 	template <class T> class WeakPtr;
 
+#ifdef ALIMER_ATOMIC_REFCOUNT
+	/// Reference count value. Atomic, so that references can be added and released from any thread.
+	typedef std::atomic<unsigned> RefCountValue;
+	/// Reference count flag.
+	typedef std::atomic<bool> RefCountFlag;
+#else
+	/// Reference count value.
+	typedef unsigned RefCountValue;
+	/// Reference count flag.
+	typedef bool RefCountFlag;
+#endif
+
 	/// Reference count structure. Used in both intrusive and non-intrusive reference counting.
 	struct ALIMER_API RefCount
 	{
-		/// Construct with zero refcounts.
+		/// Construct with zero strong refcount. The object holds one weak reference to the structure until it is destroyed.
 		RefCount() :
 			refs(0),
-			weakRefs(0),
+			weakRefs(1),
 			expired(false)
 		{
 		}
 
+		/// Allocate a reference count structure. Uses a thread-caching pool when reference counting is atomic.
+		static RefCount* Allocate();
+		/// Add a weak reference.
+		void AddWeakRef() { ++weakRefs; }
+		/// Release a weak reference. Free the structure when the last one is gone.
+		void ReleaseWeakRef();
+		/// Add a strong reference only if the object still has strong references, so that an object already being destroyed is not revived. Return true on success.
+		bool TryAddRef()
+		{
+#ifdef ALIMER_ATOMIC_REFCOUNT
+			unsigned count = refs.load(std::memory_order_relaxed);
+			do
+			{
+				if (!count)
+					return false;
+			} while (!refs.compare_exchange_weak(count, count + 1));
+			return true;
+#else
+			if (!refs)
+				return false;
+			++refs;
+			return true;
+#endif
+		}
+		/// Return the number of weak references, excluding the one held by the object itself.
+		unsigned WeakRefs() const { unsigned count = weakRefs; return expired ? count : count - 1; }
+
 		/// Number of strong references. These keep the object alive.
-		unsigned refs;
-		/// Number of weak references.
-		unsigned weakRefs;
+		RefCountValue refs;
+		/// Number of weak references, including the object's own while it is alive.
+		RefCountValue weakRefs;
 		/// Expired flag. The object is no longer safe to access after this is set true.
-		bool expired;
+		RefCountFlag expired;
 	};
 
 	/// Base class for intrusively reference counted objects that can be pointed to with SharedPtr and WeakPtr. These are not copy-constructible and not assignable.
@@ -39,7 +81,7 @@ namespace Alimer
 		/// Construct. The reference count is not allocated yet; it will be allocated on demand.
 		RefCounted();
 
-		/// Destruct. If no weak references, destroy also the reference count, else mark it expired.
+		/// Destruct. Mark the reference count expired, and destroy it if there are no weak references.
 		virtual ~RefCounted();
 
 		/// Add a strong reference. Allocate the reference count structure first if necessary.
@@ -48,11 +90,15 @@ namespace Alimer
 		void ReleaseRef();
 
 		/// Return the number of strong references.
-		unsigned Refs() const { return refCount ? refCount->refs : 0; }
+		unsigned Refs() const { RefCount* count = refCount; return count ? static_cast<unsigned>(count->refs) : 0; }
 		/// Return the number of weak references.
-		unsigned WeakRefs() const { return refCount ? refCount->weakRefs : 0; }
+		unsigned WeakRefs() const { RefCount* count = refCount; return count ? count->WeakRefs() : 0; }
 		/// Return pointer to the reference count structure. Allocate if not allocated yet.
-		RefCount* RefCountPtr();
+		RefCount* RefCountPtr()
+		{
+			RefCount* count = refCount;
+			return count ? count : AllocateRefCount();
+		}
 
 	private:
 		/// Prevent copy construction and assignment.
@@ -62,8 +108,16 @@ namespace Alimer
 		RefCounted(const RefCounted&&) = delete;
 		RefCounted& operator=(const RefCounted&&) = delete;
 
+		/// Allocate the reference count structure. If another thread allocated it first, use that one.
+		RefCount* AllocateRefCount();
+
+#ifdef ALIMER_ATOMIC_REFCOUNT
+		/// Reference count structure, allocated on demand.
+		std::atomic<RefCount*> refCount;
+#else
 		/// Reference count structure, allocated on demand.
 		RefCount* refCount;
+#endif
 	};
 
 	/// Pointer which holds a strong reference to a RefCounted subclass and allows shared ownership.
@@ -138,11 +192,12 @@ namespace Alimer
 			*this = static_cast<T*>(rhs.ptr);
 		}
 
-		/// Perform a dynamic cast from a weak pointer of another type.
+		/// Perform a dynamic cast from a weak pointer of another type. Results in null if the object has been destroyed.
 		template <class U> void DynamicCast(const WeakPtr<U>& rhs)
 		{
 			Reset();
-			T* rhsObject = dynamic_cast<T*>(rhs.ptr);
+			SharedPtr<U> rhsLocked = rhs.Lock();
+			T* rhsObject = dynamic_cast<T*>(rhsLocked.Get());
 			if (rhsObject)
 				*this = rhsObject;
 		}
@@ -243,7 +298,7 @@ namespace Alimer
 			ptr = rhs.ptr;
 			refCount = rhs.refCount;
 			if (refCount)
-				++(refCount->weakRefs);
+				refCount->AddWeakRef();
 			return *this;
 		}
 
@@ -257,7 +312,7 @@ namespace Alimer
 			ptr = rhs.Get();
 			refCount = ptr ? ptr->RefCountPtr() : nullptr;
 			if (refCount)
-				++(refCount->weakRefs);
+				refCount->AddWeakRef();
 			return *this;
 		}
 
@@ -271,7 +326,7 @@ namespace Alimer
 			ptr = rhs;
 			refCount = ptr ? ptr->RefCountPtr() : nullptr;
 			if (refCount)
-				++(refCount->weakRefs);
+				refCount->AddWeakRef();
 			return *this;
 		}
 
@@ -280,10 +335,8 @@ namespace Alimer
 		{
 			if (refCount)
 			{
-				--(refCount->weakRefs);
-				// If expired and no more weak references, destroy the reference count
-				if (refCount->expired && refCount->weakRefs == 0)
-					delete refCount;
+				// Destroys the reference count if the object is gone and this was the last weak reference
+				refCount->ReleaseWeakRef();
 				ptr = nullptr;
 				refCount = nullptr;
 			}
@@ -323,7 +376,7 @@ namespace Alimer
 		/// Convert to the object.
 		operator T* () const { return Get(); }
 
-		/// Return the object or null if it has been destroyed.
+		/// Return the object or null if it has been destroyed. Another thread may destroy the object after this returns; use Lock() instead when the object is shared between threads.
 		T* Get() const
 		{
 			if (refCount && !refCount->expired)
@@ -332,10 +385,23 @@ namespace Alimer
 				return nullptr;
 		}
 
+		/// Return a shared pointer to the object, or null if it has been destroyed or is being destroyed. Safe against another thread releasing the last strong reference at the same time.
+		SharedPtr<T> Lock() const
+		{
+			SharedPtr<T> ret;
+			if (refCount && refCount->TryAddRef())
+			{
+				// The reference added above keeps the object alive while the shared pointer takes its own
+				ret = ptr;
+				ptr->ReleaseRef();
+			}
+			return ret;
+		}
+
 		/// Return the number of strong references.
-		unsigned Refs() const { return refCount ? refCount->refs : 0; }
+		unsigned Refs() const { return refCount ? static_cast<unsigned>(refCount->refs) : 0; }
 		/// Return the number of weak references.
-		unsigned WeakRefs() const { return refCount ? refCount->weakRefs : 0; }
+		unsigned WeakRefs() const { return refCount ? refCount->WeakRefs() : 0; }
 		/// Return whether is a null pointer.
 		bool IsNull() const { return ptr == nullptr; }
 		/// Return whether the object has been destroyed. Returns false if is a null pointer.
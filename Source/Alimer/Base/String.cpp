@@ -127,25 +127,18 @@ namespace Alimer
 
 	bool str::StartsWith(const string& str, const string& value, bool caseSensitive)
 	{
-		if (caseSensitive)
-			return str.find(value) != string::npos;
+		if (value.length() > str.length())
+			return false;
 
-		return str::ToLower(str).find(str::ToLower(value)) != string::npos;
+		return !str::Compare(str.substr(0, value.length()), value, caseSensitive);
 	}
 
 	bool str::EndsWith(const std::string& str, const std::string& value, bool caseSensitive)
 	{
-		size_t pos;
-		if (caseSensitive)
-		{
-			pos = str.find_last_of(value);
-		}
-		else
-		{
-			pos = str::ToLower(str).find_last_of(str::ToLower(value));
-		}
+		if (value.length() > str.length())
+			return false;
 
-		return pos != string::npos && pos == str.length() - str.length();
+		return !str::Compare(str.substr(str.length() - value.length()), value, caseSensitive);
 	}
 
 	bool str::ToBool(const char* str)
@@ -21,22 +21,105 @@
 // THE SOFTWARE.
 //
 
+
 #include "../Base/Utils.h"
+#include "../IO/Stream.h"
+#include "Log.h"
 #include "Profiler.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
+#ifdef ALIMER_ALLOCATION_TRACKING
+#include <cstdlib>
+#include <new>
+#endif
 using namespace std;
 
+#ifdef ALIMER_ALLOCATION_TRACKING
+namespace Alimer
+{
+	/// Heap allocations made by the calling thread.
+	static thread_local uint64_t threadAllocations = 0;
+	/// Bytes allocated by the calling thread.
+	static thread_local uint64_t threadAllocatedBytes = 0;
+
+	static void* TrackedAllocate(size_t size)
+	{
+		++threadAllocations;
+		threadAllocatedBytes += size;
+
+		void* ptr = malloc(size ? size : 1);
+		if (!ptr)
+		{
+#if !defined(__GNUC__) || __EXCEPTIONS
+			throw std::bad_alloc();
+#else
+			abort();
+#endif
+		}
+		return ptr;
+	}
+}
+
+// Replace the global allocation functions to count allocations per thread. Deallocation is not tracked
+void* operator new(size_t size) { return Alimer::TrackedAllocate(size); }
+void* operator new[](size_t size) { return Alimer::TrackedAllocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { ++Alimer::threadAllocations; Alimer::threadAllocatedBytes += size; return malloc(size ? size : 1); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { ++Alimer::threadAllocations; Alimer::threadAllocatedBytes += size; return malloc(size ? size : 1); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+#endif
+
 namespace Alimer
 {
 	static const int LINE_MAX_LENGTH = 256;
 	static const int NAME_MAX_LENGTH = 30;
+	static const size_t DEFAULT_TRACE_BUFFER_SIZE = 1024 * 1024;
+
+	/// Source of profiler instance ids.
+	static atomic<uint32_t> profilerGeneration(0);
+	/// Calling thread's profiling data, if it has recorded blocks.
+	static thread_local ProfilerThread* threadData = nullptr;
+	/// Id of the profiler instance the calling thread's data belongs to.
+	static thread_local uint32_t threadGeneration = 0;
 
-	ProfilerBlock::ProfilerBlock(ProfilerBlock* parent_, const char* name_) 
-		: name(name_)
+	/// Releases the calling thread's profiling data slot when the thread exits.
+	struct ProfilerThreadExit
+	{
+		~ProfilerThreadExit()
+		{
+			Profiler::ReleaseThreadData();
+		}
+	};
+
+	/// Return registered scope names indexed by id.
+	static vector<const char*>& GetScopeNames()
+	{
+		static vector<const char*> scopeNames;
+		return scopeNames;
+	}
+
+	/// Return mutex for the scope names.
+	static mutex& GetScopeMutex()
+	{
+		static mutex scopeMutex;
+		return scopeMutex;
+	}
+
+	Profiler* Profiler::_instance = nullptr;
+
+	ProfilerBlock::ProfilerBlock(ProfilerBlock* parent_, uint32_t id_, const char* name_)
+		: id(id_)
+		, name(name_)
 		, parent(parent_)
 		, count(0)
+		, _frameTime(0)
+		, _frameMaxTime(0)
 		, frameCount(0)
 		, intervalTime(0)
 		, intervalCount(0)
@@ -54,22 +137,6 @@ namespace Alimer
 		_children.clear();
 	}
 
-	void ProfilerBlock::Begin()
-	{
-		timer.Reset();
-		++count;
-	}
-
-	void ProfilerBlock::End()
-	{
-		uint64_t currentTime = timer.GetMilliseconds();
-		if (currentTime > _maxTime)
-		{
-			_maxTime = currentTime;
-		}
-		_time += currentTime;
-	}
-
 	void ProfilerBlock::EndFrame()
 	{
 		_frameTime = _time;
@@ -85,9 +152,17 @@ namespace Alimer
 			_totalMaxTime = _maxTime;
 		}
 		totalCount += count;
+		_frameAllocations = _allocations;
+		_frameAllocatedBytes = _allocatedBytes;
+		_intervalAllocations += _allocations;
+		_intervalAllocatedBytes += _allocatedBytes;
+		_totalAllocations += _allocations;
+		_totalAllocatedBytes += _allocatedBytes;
 		_time = 0;
 		_maxTime = 0;
 		count = 0;
+		_allocations = 0;
+		_allocatedBytes = 0;
 
 		for (auto it = _children.begin(); it != _children.end(); ++it)
 			(*it)->EndFrame();
@@ -98,65 +173,124 @@ namespace Alimer
 		intervalTime = 0;
 		_intervalMaxTime = 0;
 		intervalCount = 0;
+		_intervalAllocations = 0;
+		_intervalAllocatedBytes = 0;
 
 		for (auto it = _children.begin(); it != _children.end(); ++it)
 			(*it)->BeginInterval();
 	}
 
-	ProfilerBlock* ProfilerBlock::FindOrCreateChild(const char* name_)
+	ProfilerBlock* ProfilerBlock::FindOrCreateChild(uint32_t id_)
 	{
-		// First check using string pointers only, then resort to actual strcmp
 		for (auto it = _children.begin(); it != _children.end(); ++it)
 		{
-			if ((*it)->name == name_)
+			if ((*it)->id == id_)
 				return *it;
 		}
 
-		for (auto it = _children.begin(); it != _children.end(); ++it)
+		ProfilerBlock* newBlock = new ProfilerBlock(this, id_, Profiler::GetScopeName(id_));
+		_children.push_back(newBlock);
+
+		return newBlock;
+	}
+
+	ProfilerThread::ProfilerThread(uint32_t index)
+		: _index(index)
+		, _events(new ProfilerEvent[EVENT_BUFFER_SIZE])
+		, _writeIndex(0)
+		, _readIndex(0)
+		, _droppedEvents(0)
+	{
+		_current = _root = new ProfilerBlock(nullptr, PROFILER_END_EVENT, "Root");
+	}
+
+	ProfilerThread::~ProfilerThread()
+	{
+		SafeDelete(_root);
+	}
+
+	void ProfilerThread::BeginBlock(uint32_t id, uint64_t time)
+	{
+		// Drop the whole block, including its children, if its begin event did not fit
+		if (_skippedBlocks)
 		{
-			if (!str::Compare((*it)->name, name_))
-				return *it;
+			++_skippedBlocks;
+			_droppedEvents.fetch_add(1, memory_order_relaxed);
+			return;
 		}
 
-		ProfilerBlock* newBlock = new ProfilerBlock(this, name_);
-		_children.push_back(newBlock);
+		uint32_t writeIndex = _writeIndex.load(memory_order_relaxed);
+		uint32_t readIndex = _readIndex.load(memory_order_acquire);
+		// Keep room for the end events of all open blocks so that the recorded blocks always stay balanced
+		if (writeIndex - readIndex + _openBlocks + 2 > EVENT_BUFFER_SIZE)
+		{
+			++_skippedBlocks;
+			_droppedEvents.fetch_add(1, memory_order_relaxed);
+			return;
+		}
 
-		return newBlock;
+		ProfilerEvent& event = _events[writeIndex & (EVENT_BUFFER_SIZE - 1)];
+		event.id = id;
+		event.time = time;
+#ifdef ALIMER_ALLOCATION_TRACKING
+		event.allocations = threadAllocations;
+		event.allocatedBytes = threadAllocatedBytes;
+#endif
+		_writeIndex.store(writeIndex + 1, memory_order_release);
+		++_openBlocks;
+	}
+
+	void ProfilerThread::EndBlock(uint64_t time)
+	{
+		if (_skippedBlocks)
+		{
+			--_skippedBlocks;
+			_droppedEvents.fetch_add(1, memory_order_relaxed);
+			return;
+		}
+
+		if (!_openBlocks)
+			return;
+
+		uint32_t writeIndex = _writeIndex.load(memory_order_relaxed);
+		ProfilerEvent& event = _events[writeIndex & (EVENT_BUFFER_SIZE - 1)];
+		event.id = PROFILER_END_EVENT;
+		event.time = time;
+#ifdef ALIMER_ALLOCATION_TRACKING
+		event.allocations = threadAllocations;
+		event.allocatedBytes = threadAllocatedBytes;
+#endif
+		_writeIndex.store(writeIndex + 1, memory_order_release);
+		--_openBlocks;
 	}
 
 	Profiler::Profiler() 
+		: _startTime(GetTimestamp())
+		, _generation(++profilerGeneration)
+		, _traceBufferSize(DEFAULT_TRACE_BUFFER_SIZE)
 	{
 		_threadId = this_thread::get_id();
-		_current = _root = new ProfilerBlock(nullptr, "Root");
+		_instance = this;
+		// Register the main thread first so that it gets index 0
+		GetThreadData();
 		RegisterSubsystem(this);
 	}
 
 	Profiler::~Profiler()
 	{
-		SafeDelete(_root);
+		if (_instance == this)
+			_instance = nullptr;
 		RemoveSubsystem(this);
 	}
 
-	void Profiler::BeginBlock(const char* name)
+	void Profiler::BeginBlock(uint32_t id)
 	{
-		// Currently profiling is a no-op if attempted from outside main thread
-		if (_threadId != this_thread::get_id())
-			return;
-
-		_current = _current->FindOrCreateChild(name);
-		_current->Begin();
+		GetThreadData()->BeginBlock(id, GetTimestamp());
 	}
 
 	void Profiler::EndBlock()
 	{
-		if (_threadId != this_thread::get_id())
-			return;
-
-		if (_current != _root)
-		{
-			_current->End();
-			_current = _current->parent;
-		}
+		GetThreadData()->EndBlock(GetTimestamp());
 	}
 
 	void Profiler::BeginFrame()
@@ -164,31 +298,333 @@ namespace Alimer
 		// End the previous frame if any
 		EndFrame();
 
-		BeginBlock("RunFrame");
+		// Advance the trace capture on frame boundaries, so that it always contains whole frames
+		if (_traceFramesLeft)
+		{
+			if (_traceCapturing)
+			{
+				if (!--_traceFramesLeft)
+					_traceCapturing = false;
+			}
+			else if (_traceDelayFrames)
+				--_traceDelayFrames;
+			else
+			{
+				_traceWriteIndex = 0;
+				_traceCapturing = true;
+			}
+		}
+
+		static const uint32_t runFrameScope = RegisterScope("RunFrame");
+		BeginBlock(runFrameScope);
+		_inFrame = true;
 	}
 
 	void Profiler::EndFrame()
 	{
-		if (_current != _root)
+		if (_threadId != this_thread::get_id() || !_inFrame)
+			return;
+
+		EndBlock();
+		_inFrame = false;
+		++_intervalFrames;
+		++_totalFrames;
+
+		lock_guard<mutex> lock(_threadsMutex);
+		for (auto it = _threads.begin(); it != _threads.end(); ++it)
 		{
-			EndBlock();
-			++_intervalFrames;
-			++_totalFrames;
-			_root->EndFrame();
-			_current = _root;
+			ProcessEvents(it->get());
+			(*it)->_root->EndFrame();
 		}
 	}
 
 	void Profiler::BeginInterval()
 	{
-		_root->BeginInterval();
 		_intervalFrames = 0;
+
+		lock_guard<mutex> lock(_threadsMutex);
+		for (auto it = _threads.begin(); it != _threads.end(); ++it)
+			(*it)->_root->BeginInterval();
+	}
+
+	void Profiler::SetTraceBufferSize(size_t numEvents)
+	{
+		if (IsTraceCapturing())
+		{
+			ALIMER_LOGERROR("Can not resize the trace buffer during a capture");
+			return;
+		}
+
+		_traceBufferSize = std::max(numEvents, (size_t)1);
+		_traceEvents.reset();
+	}
+
+	void Profiler::CaptureTrace(uint32_t numFrames, uint32_t delayFrames)
+	{
+		StopTrace();
+
+		if (!_traceEvents)
+			_traceEvents.reset(new ProfilerTraceEvent[_traceBufferSize]);
+
+		_traceWriteIndex = 0;
+		_traceDelayFrames = delayFrames;
+		_traceFramesLeft = numFrames;
+	}
+
+	void Profiler::StopTrace()
+	{
+		_traceCapturing = false;
+		_traceFramesLeft = 0;
+		_traceDelayFrames = 0;
+	}
+
+	string Profiler::OutputTrace() const
+	{
+		string output;
+		char line[LINE_MAX_LENGTH];
+
+		uint64_t numEvents = _traceEvents ? std::min(_traceWriteIndex, (uint64_t)_traceBufferSize) : 0;
+		uint64_t firstEvent = _traceWriteIndex - numEvents;
+
+		output += "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"overwrittenEvents\":" + to_string(firstEvent) + "},\"traceEvents\":[\n";
+
+		// Name the threads
+		size_t numThreads = GetNumThreads() + 1;
+		for (size_t i = 0; i < numThreads; ++i)
+		{
+			string threadName = i ? "Thread " + to_string(i) : string("Main thread");
+			output += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" + to_string(i) + ",\"args\":{\"name\":\"" + threadName + "\"}},\n";
+		}
+
+		// Skip end events whose begin was overwritten, and close blocks that were still open when the capture stopped
+		vector<uint32_t> depths(numThreads);
+		uint64_t lastTime = _startTime;
+		for (uint64_t i = firstEvent; i < _traceWriteIndex; ++i)
+		{
+			const ProfilerTraceEvent& event = _traceEvents[i % _traceBufferSize];
+			if (event.threadIndex >= depths.size())
+				depths.resize(event.threadIndex + 1);
+
+			double time = (event.time - _startTime) / 1000.0;
+			uint32_t& depth = depths[event.threadIndex];
+			if (event.id != PROFILER_END_EVENT)
+			{
+				++depth;
+				string name;
+				for (const char* c = GetScopeName(event.id); *c; ++c)
+				{
+					if (*c == '"' || *c == '\\')
+						name += '\\';
+					name += *c;
+				}
+				// Scope names have no length limit, so append them directly instead of formatting them into the line buffer
+				output += "{\"name\":\"" + name + "\",";
+				snprintf(line, sizeof line, "\"ph\":\"B\",\"ts\":%.3f,\"pid\":0,\"tid\":%u},\n", time, event.threadIndex);
+			}
+			else if (depth)
+			{
+				--depth;
+				snprintf(line, sizeof line, "{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%u},\n", time, event.threadIndex);
+			}
+			else
+				continue;
+
+			output += line;
+			lastTime = std::max(lastTime, event.time);
+		}
+
+		for (size_t i = 0; i < depths.size(); ++i)
+		{
+			for (uint32_t j = 0; j < depths[i]; ++j)
+			{
+				snprintf(line, sizeof line, "{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%u},\n", (lastTime - _startTime) / 1000.0, (unsigned)i);
+				output += line;
+			}
+		}
+
+		// Remove the trailing comma
+		if (output.size() >= 2 && output[output.size() - 2] == ',')
+			output.erase(output.size() - 2, 1);
+
+		output += "]}\n";
+		return output;
+	}
+
+	bool Profiler::SaveTrace(Stream& dest) const
+	{
+		string output = OutputTrace();
+		return dest.Write(output.data(), output.size()) == output.size();
+	}
+
+	const ProfilerBlock* Profiler::GetRootBlock() const
+	{
+		lock_guard<mutex> lock(_threadsMutex);
+		return _threads[0]->_root;
+	}
+
+	size_t Profiler::GetNumThreads() const
+	{
+		lock_guard<mutex> lock(_threadsMutex);
+		return _threads.size() - 1;
+	}
+
+	const ProfilerThread* Profiler::GetThread(size_t index) const
+	{
+		lock_guard<mutex> lock(_threadsMutex);
+		return index + 1 < _threads.size() ? _threads[index + 1].get() : nullptr;
+	}
+
+	void Profiler::GetThreadAllocations(uint64_t& allocations, uint64_t& allocatedBytes)
+	{
+#ifdef ALIMER_ALLOCATION_TRACKING
+		allocations = threadAllocations;
+		allocatedBytes = threadAllocatedBytes;
+#else
+		allocations = 0;
+		allocatedBytes = 0;
+#endif
+	}
+
+	void Profiler::ReleaseThreadData()
+	{
+		Profiler* profiler = _instance;
+		ProfilerThread* thread = threadData;
+		if (!thread)
+			return;
+
+		if (!profiler || threadGeneration != profiler->_generation)
+		{
+			threadData = nullptr;
+			return;
+		}
+
+		// The main thread's slot is never released
+		if (!thread->_index)
+			return;
+
+		// End the blocks left open, so that the next thread using the slot starts from the root
+		uint64_t time = GetTimestamp();
+		while (thread->_openBlocks || thread->_skippedBlocks)
+			thread->EndBlock(time);
+
+		threadData = nullptr;
+		lock_guard<mutex> lock(profiler->_threadsMutex);
+		profiler->_freeThreads.push_back(thread);
+	}
+
+	uint32_t Profiler::RegisterScope(const char* name)
+	{
+		lock_guard<mutex> lock(GetScopeMutex());
+		vector<const char*>& scopeNames = GetScopeNames();
+
+		// First check using string pointers only, then resort to actual strcmp
+		for (size_t i = 0; i < scopeNames.size(); ++i)
+		{
+			if (scopeNames[i] == name)
+				return static_cast<uint32_t>(i);
+		}
+
+		for (size_t i = 0; i < scopeNames.size(); ++i)
+		{
+			if (!str::Compare(scopeNames[i], name))
+				return static_cast<uint32_t>(i);
+		}
+
+		scopeNames.push_back(name);
+		return static_cast<uint32_t>(scopeNames.size() - 1);
+	}
+
+	const char* Profiler::GetScopeName(uint32_t id)
+	{
+		lock_guard<mutex> lock(GetScopeMutex());
+		vector<const char*>& scopeNames = GetScopeNames();
+		return id < scopeNames.size() ? scopeNames[id] : "";
+	}
+
+	ProfilerThread* Profiler::GetThreadData()
+	{
+		if (threadData && threadGeneration == _generation)
+			return threadData;
+
+		// Release the slot when the thread exits
+		static thread_local ProfilerThreadExit threadExit;
+
+		lock_guard<mutex> lock(_threadsMutex);
+		if (!_freeThreads.empty())
+		{
+			threadData = _freeThreads.back();
+			_freeThreads.pop_back();
+		}
+		else
+		{
+			_threads.emplace_back(new ProfilerThread(static_cast<uint32_t>(_threads.size())));
+			threadData = _threads.back().get();
+		}
+		threadGeneration = _generation;
+		return threadData;
+	}
+
+	void Profiler::ProcessEvents(ProfilerThread* thread)
+	{
+		uint32_t readIndex = thread->_readIndex.load(memory_order_relaxed);
+		uint32_t writeIndex = thread->_writeIndex.load(memory_order_acquire);
+		ProfilerBlock* root = thread->_root;
+		ProfilerBlock* current = thread->_current;
+
+		for (; readIndex != writeIndex; ++readIndex)
+		{
+			const ProfilerEvent& event = thread->_events[readIndex & (ProfilerThread::EVENT_BUFFER_SIZE - 1)];
+			if (event.id != PROFILER_END_EVENT)
+			{
+				current = current->FindOrCreateChild(event.id);
+				current->startTime = event.time;
+				++current->count;
+#ifdef ALIMER_ALLOCATION_TRACKING
+				current->startAllocations = event.allocations;
+				current->startAllocatedBytes = event.allocatedBytes;
+#endif
+			}
+			else if (current != root)
+			{
+				uint64_t time = (event.time - current->startTime) / 1000;
+				if (time > current->_maxTime)
+					current->_maxTime = time;
+				current->_time += time;
+#ifdef ALIMER_ALLOCATION_TRACKING
+				current->_allocations += event.allocations - current->startAllocations;
+				current->_allocatedBytes += event.allocatedBytes - current->startAllocatedBytes;
+#endif
+				current = current->parent;
+			}
+			else
+				continue;
+
+			if (_traceCapturing)
+			{
+				ProfilerTraceEvent& traceEvent = _traceEvents[_traceWriteIndex++ % _traceBufferSize];
+				traceEvent.id = event.id;
+				traceEvent.threadIndex = thread->_index;
+				traceEvent.time = event.time;
+			}
+		}
+
+		thread->_current = current;
+		thread->_readIndex.store(readIndex, memory_order_release);
 	}
 
 	string Profiler::OutputResults(bool showUnused, bool showTotal, size_t maxDepth) const
 	{
 		string output;
 
+#ifdef ALIMER_ALLOCATION_TRACKING
+		if (!showTotal)
+			output += string("Block                            Cnt     Avg      Max     Frame     Total   Allocs/f     KB/f\n\n");
+		else
+		{
+			output += string("Block                                       Last frame                                         Whole execution time\n\n");
+			output += string("                                 Cnt     Avg      Max      Total   Allocs       KB      Cnt      Avg       Max        Total     Allocs         KB\n\n");
+		}
+#else
 		if (!showTotal)
 			output += string("Block                            Cnt     Avg      Max     Frame     Total\n\n");
 		else
@@ -196,16 +632,74 @@ namespace Alimer
 			output += string("Block                                       Last frame                       Whole execution time\n\n");
 			output += string("                                 Cnt     Avg      Max      Total      Cnt      Avg       Max        Total\n\n");
 		}
+#endif
 
 		if (!maxDepth)
 			maxDepth = 1;
 
-		OutputResults(_root, output, 0, maxDepth, showUnused, showTotal);
+		lock_guard<mutex> lock(_threadsMutex);
+		const ProfilerBlock* mainRoot = _threads[0]->_root;
+		OutputResults(mainRoot, mainRoot, output, 0, maxDepth, showUnused, showTotal);
+
+		if (_threads.size() == 1)
+			return output;
+
+		ProfilerBlock aggregate(nullptr, PROFILER_END_EVENT, "Root");
+		for (size_t i = 1; i < _threads.size(); ++i)
+		{
+			OutputTree(_threads[i]->_root, "Thread " + to_string(i), output, maxDepth, showUnused, showTotal);
+			MergeBlocks(&aggregate, _threads[i]->_root);
+		}
+
+		OutputTree(&aggregate, "All threads", output, maxDepth, showUnused, showTotal);
 
 		return output;
 	}
 
-	void Profiler::OutputResults(ProfilerBlock* block, string& output, size_t depth, size_t maxDepth, bool showUnused, bool showTotal) const
+	void Profiler::OutputTree(const ProfilerBlock* root, const string& title, string& output, size_t maxDepth, bool showUnused, bool showTotal) const
+	{
+		bool hasData = false;
+		for (auto it = root->_children.begin(); it != root->_children.end(); ++it)
+		{
+			if (showUnused || (*it)->intervalCount || (showTotal && (*it)->totalCount))
+				hasData = true;
+		}
+
+		if (!hasData)
+			return;
+
+		output += "\n" + title + "\n\n";
+		OutputResults(root, root, output, 0, maxDepth, showUnused, showTotal);
+	}
+
+	void Profiler::MergeBlocks(ProfilerBlock* dest, const ProfilerBlock* source)
+	{
+		for (auto it = source->_children.begin(); it != source->_children.end(); ++it)
+		{
+			const ProfilerBlock* child = *it;
+			ProfilerBlock* destChild = dest->FindOrCreateChild(child->id);
+
+			destChild->_frameTime += child->_frameTime;
+			destChild->_frameMaxTime = std::max(destChild->_frameMaxTime, child->_frameMaxTime);
+			destChild->frameCount += child->frameCount;
+			destChild->intervalTime += child->intervalTime;
+			destChild->_intervalMaxTime = std::max(destChild->_intervalMaxTime, child->_intervalMaxTime);
+			destChild->intervalCount += child->intervalCount;
+			destChild->_totalTime += child->_totalTime;
+			destChild->_totalMaxTime = std::max(destChild->_totalMaxTime, child->_totalMaxTime);
+			destChild->totalCount += child->totalCount;
+			destChild->_frameAllocations += child->_frameAllocations;
+			destChild->_frameAllocatedBytes += child->_frameAllocatedBytes;
+			destChild->_intervalAllocations += child->_intervalAllocations;
+			destChild->_intervalAllocatedBytes += child->_intervalAllocatedBytes;
+			destChild->_totalAllocations += child->_totalAllocations;
+			destChild->_totalAllocatedBytes += child->_totalAllocatedBytes;
+
+			MergeBlocks(destChild, child);
+		}
+	}
+
+	void Profiler::OutputResults(const ProfilerBlock* block, const ProfilerBlock* root, string& output, size_t depth, size_t maxDepth, bool showUnused, bool showTotal) const
 	{
 		char line[LINE_MAX_LENGTH];
 		char indentedName[LINE_MAX_LENGTH];
@@ -218,7 +712,7 @@ namespace Alimer
 			return;
 
 		// Do not print the root block as it does not collect any actual data
-		if (block != _root)
+		if (block != root)
 		{
 			if (showUnused || block->intervalCount || (showTotal && block->totalCount))
 			{
@@ -235,8 +729,14 @@ namespace Alimer
 					float frame = block->intervalTime / currentInterval / 1000.0f;
 					float all = block->intervalTime / 1000.0f;
 
+#ifdef ALIMER_ALLOCATION_TRACKING
+					sprintf(line, "%s %5u %8.3f %8.3f %8.3f %9.3f %10.1f %8.1f\n", indentedName, Min(block->intervalCount, 99999),
+						avg, max, frame, all, (double)block->_intervalAllocations / currentInterval,
+						block->_intervalAllocatedBytes / 1024.0 / currentInterval);
+#else
 					sprintf(line, "%s %5u %8.3f %8.3f %8.3f %9.3f\n", indentedName, Min(block->intervalCount, 99999),
 						avg, max, frame, all);
+#endif
 				}
 				else
 				{
@@ -248,8 +748,15 @@ namespace Alimer
 					float totalMax = block->_totalMaxTime / 1000.0f;
 					float totalAll = block->_totalTime / 1000.0f;
 
+#ifdef ALIMER_ALLOCATION_TRACKING
+					sprintf(line, "%s %5u %8.3f %8.3f %9.3f %8llu %8.1f  %7u %9.3f %9.3f %11.3f %10llu %10.1f\n", indentedName,
+						Min(block->frameCount, 99999), avg, max, all, (unsigned long long)block->_frameAllocations,
+						block->_frameAllocatedBytes / 1024.0, Min(block->totalCount, 99999), totalAvg, totalMax, totalAll,
+						(unsigned long long)block->_totalAllocations, block->_totalAllocatedBytes / 1024.0);
+#else
 					sprintf(line, "%s %5u %8.3f %8.3f %9.3f  %7u %9.3f %9.3f %11.3f\n", indentedName, Min(block->frameCount, 99999),
 						avg, max, all, Min(block->totalCount, 99999), totalAvg, totalMax, totalAll);
+#endif
 				}
 
 				output += line;
@@ -260,7 +767,7 @@ namespace Alimer
 
 		for (auto it = block->_children.begin(); it != block->_children.end(); ++it)
 		{
-			OutputResults(*it, output, depth, maxDepth, showUnused, showTotal);
+			OutputResults(*it, root, output, depth, maxDepth, showUnused, showTotal);
 		}
 	}
 
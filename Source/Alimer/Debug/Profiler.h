@@ -21,40 +21,41 @@
 // THE SOFTWARE.
 //
 
+
 #pragma once
 
 #include "../Math/Math.h"
 #include "../Object/Object.h"
-#include "../Base/Timer.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <thread>
 #include <memory>
 
 namespace Alimer
 {
+	class Stream;
+
 	/// Profiling data for one block in the profiling tree.
 	class ALIMER_API ProfilerBlock
 	{
 	public:
-		/// Construct-
-		ProfilerBlock(ProfilerBlock* parent, const char* name);
+		/// Construct.
+		ProfilerBlock(ProfilerBlock* parent, uint32_t id, const char* name);
 		/// Destruct.
 		~ProfilerBlock();
 
-		/// Start time measurement and increment call count.
-		void Begin();
-		/// End time measurement.
-		void End();
 		/// Process stats at the end of frame.
 		void EndFrame();
 		/// Begin an interval lasting several frames.
 		void BeginInterval();
-		/// Return a child block; create if necessary.
-		ProfilerBlock* FindOrCreateChild(const char* name);
+		/// Return a child block by scope id; create if necessary.
+		ProfilerBlock* FindOrCreateChild(uint32_t id);
 
+		/// Scope id.
+		uint32_t id;
 		/// Block name.
 		const char* name;
-		/// Hires timer for time measurement.
-		Timer timer;
 		/// Parent block.
 		ProfilerBlock* parent;
 		/// Child blocks.
@@ -83,9 +84,107 @@ namespace Alimer
 		uint64_t _totalMaxTime{};
 		/// Call count since start.
 		unsigned totalCount;
+		/// Timestamp of the current call's begin event.
+		uint64_t startTime{};
+		/// Current frame's heap allocation count.
+		uint64_t _allocations{};
+		/// Current frame's allocated bytes.
+		uint64_t _allocatedBytes{};
+		/// Previous frame's heap allocation count.
+		uint64_t _frameAllocations{};
+		/// Previous frame's allocated bytes.
+		uint64_t _frameAllocatedBytes{};
+		/// Current interval's heap allocation count.
+		uint64_t _intervalAllocations{};
+		/// Current interval's allocated bytes.
+		uint64_t _intervalAllocatedBytes{};
+		/// Heap allocation count since start.
+		uint64_t _totalAllocations{};
+		/// Allocated bytes since start.
+		uint64_t _totalAllocatedBytes{};
+		/// Thread's allocation count at the current call's begin event.
+		uint64_t startAllocations{};
+		/// Thread's allocated bytes at the current call's begin event.
+		uint64_t startAllocatedBytes{};
 	};
 
-	/// Hierarchical performance profiler subsystem.
+	/// Block begin or end event recorded by a thread.
+	struct ProfilerEvent
+	{
+		/// Scope id. PROFILER_END_EVENT for an end event.
+		uint32_t id;
+		/// Timestamp in nanoseconds.
+		uint64_t time;
+#ifdef ALIMER_ALLOCATION_TRACKING
+		/// Thread's heap allocation count at the time of the event.
+		uint64_t allocations;
+		/// Thread's allocated bytes at the time of the event.
+		uint64_t allocatedBytes;
+#endif
+	};
+
+	/// Block begin or end event kept for a trace capture.
+	struct ProfilerTraceEvent
+	{
+		/// Scope id. PROFILER_END_EVENT for an end event.
+		uint32_t id;
+		/// Thread index. Zero for the main thread.
+		uint32_t threadIndex;
+		/// Timestamp in nanoseconds.
+		uint64_t time;
+	};
+
+	/// Scope id of an end event.
+	static const uint32_t PROFILER_END_EVENT = M_MAX_UNSIGNED;
+
+	/// Profiling data of one thread. Events are written by the owning thread into a lock-free ring buffer and replayed into the block tree by the main thread at the end of each frame.
+	class ALIMER_API ProfilerThread
+	{
+	public:
+		/// Maximum number of events buffered between frames.
+		static const uint32_t EVENT_BUFFER_SIZE = 1 << 16;
+
+		/// Construct.
+		ProfilerThread(uint32_t index);
+		/// Destruct.
+		~ProfilerThread();
+
+		/// Record a block begin event. Called from the owning thread.
+		void BeginBlock(uint32_t id, uint64_t time);
+		/// Record a block end event. Called from the owning thread.
+		void EndBlock(uint64_t time);
+
+		/// Return thread slot index. Zero for the main thread. Slots of exited threads are reused by new threads.
+		uint32_t GetIndex() const { return _index; }
+		/// Return root block of the thread.
+		const ProfilerBlock* GetRootBlock() const { return _root; }
+		/// Return number of events dropped due to a full buffer.
+		uint32_t GetNumDroppedEvents() const { return _droppedEvents.load(std::memory_order_relaxed); }
+
+	private:
+		friend class Profiler;
+
+		/// Thread index.
+		uint32_t _index;
+		/// Root block.
+		ProfilerBlock* _root;
+		/// Block events are currently being replayed into. Only accessed by the main thread.
+		ProfilerBlock* _current;
+		/// Event ring buffer.
+		std::unique_ptr<ProfilerEvent[]> _events;
+		/// Number of events written. Only modified by the owning thread.
+		std::atomic<uint32_t> _writeIndex;
+		/// Number of events replayed. Only modified by the main thread.
+		std::atomic<uint32_t> _readIndex;
+		/// Number of events dropped.
+		std::atomic<uint32_t> _droppedEvents;
+		/// Number of recorded blocks that have not ended yet. Only accessed by the owning thread.
+		uint32_t _openBlocks{};
+		/// Number of dropped blocks that have not ended yet. Only accessed by the owning thread.
+		uint32_t _skippedBlocks{};
+	};
+
+	/// Hierarchical performance profiler subsystem. Blocks can be recorded from any thread; the profiling frame is driven from the thread that created the profiler.
 	class ALIMER_API Profiler : public Object
 	{
 		ALIMER_OBJECT(Profiler, Object);
@@ -96,49 +195,124 @@ namespace Alimer
 		/// Destruct.
 		~Profiler();
 
-		/// Begin a profiling block. The name must be persistent; string literals are recommended.
-		void BeginBlock(const char* name);
-		/// End the current profiling block.
+		/// Begin a profiling block by scope id. Can be called from any thread.
+		void BeginBlock(uint32_t id);
+		/// Begin a profiling block by name. Slower than using a registered scope id. The name must be persistent; string literals are recommended.
+		void BeginBlock(const char* name) { BeginBlock(RegisterScope(name)); }
+		/// End the current profiling block. Can be called from any thread.
 		void EndBlock();
 		/// Begin the next profiling frame.
 		void BeginFrame();
-		/// End the current profiling frame.
+		/// End the current profiling frame and process the events recorded by all threads.
 		void EndFrame();
 		/// Begin a profiler interval.
 		void BeginInterval();
 
-		/// Output results into a string.
+		/// Set the trace capture ring buffer size in events. When a capture records more events, the oldest are overwritten. Default 1M events.
+		void SetTraceBufferSize(size_t numEvents);
+		/// Capture begin and end events of all blocks on all threads for a number of frames, starting after a delay in frames. Allocates the ring buffer up front.
+		void CaptureTrace(uint32_t numFrames, uint32_t delayFrames = 0);
+		/// Stop a trace capture in progress or pending.
+		void StopTrace();
+		/// Return whether a trace capture is in progress.
+		bool IsTraceCapturing() const { return _traceCapturing; }
+		/// Return whether a trace capture has been scheduled or is in progress.
+		bool IsTracePending() const { return _traceFramesLeft > 0; }
+		/// Return the captured events in Chrome trace event JSON format, loadable in chrome://tracing or Perfetto.
+		std::string OutputTrace() const;
+		/// Save the captured events in Chrome trace event JSON format. Return true on success.
+		bool SaveTrace(Stream& dest) const;
+
+		/// Output results into a string. The main thread is listed first, followed by each other thread and the aggregate of all other threads.
 		std::string OutputResults(bool showUnused = false, bool showTotal = false, size_t maxDepth = M_MAX_UNSIGNED) const;
-		/// Return the current profiling block.
-		const ProfilerBlock* GetCurrentBlock() const { return _current; }
-		/// Return the root profiling block.
-		const ProfilerBlock* GetRootBlock() const { return _root; }
+		/// Return the root profiling block of the main thread.
+		const ProfilerBlock* GetRootBlock() const;
+		/// Return number of thread slots other than the main thread's. Only safe to call from the main thread.
+		size_t GetNumThreads() const;
+		/// Return profiling data of another thread by index. Only safe to call from the main thread.
+		const ProfilerThread* GetThread(size_t index) const;
+
+		/// Release the calling thread's profiling data slot so that another thread can reuse it. Blocks still open are ended. Called automatically when a thread that has recorded blocks exits.
+		static void ReleaseThreadData();
+		/// Return the calling thread's heap allocation count and allocated bytes. Always zero unless built with ALIMER_ALLOCATION_TRACKING.
+		static void GetThreadAllocations(uint64_t& allocations, uint64_t& allocatedBytes);
+
+		/// Return the profiler instance, or null if not created.
+		static Profiler* GetInstance() { return _instance; }
+		/// Register a profiling scope name and return its id. Registering the same name again returns the same id. The name must be persistent.
+		static uint32_t RegisterScope(const char* name);
+		/// Return the name of a registered scope.
+		static const char* GetScopeName(uint32_t id);
+		/// Return a timestamp in nanoseconds.
+		static uint64_t GetTimestamp()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count());
+		}
 
 	private:
+		/// Return the calling thread's profiling data, registering it on first use.
+		ProfilerThread* GetThreadData();
+		/// Replay a thread's buffered events into its block tree, and into the trace buffer if capturing.
+		void ProcessEvents(ProfilerThread* thread);
+		/// Output a block tree with a title line.
+		void OutputTree(const ProfilerBlock* root, const std::string& title, std::string& output, size_t maxDepth, bool showUnused, bool showTotal) const;
 		/// Output results recursively.
-		void OutputResults(ProfilerBlock* block, std::string& output, size_t depth, size_t maxDepth, bool showUnused, bool showTotal) const;
+		void OutputResults(const ProfilerBlock* block, const ProfilerBlock* root, std::string& output, size_t depth, size_t maxDepth, bool showUnused, bool showTotal) const;
+		/// Merge a block tree into another by scope ids.
+		static void MergeBlocks(ProfilerBlock* dest, const ProfilerBlock* source);
+
+		/// Profiler instance.
+		static Profiler* _instance;
 
-		/// Current profiling block.
-		ProfilerBlock* _current;
-		/// Root profiling block.
-		ProfilerBlock* _root;
 		/// Frames in the current interval.
 		uint32_t _intervalFrames{};
 		/// Total frames since start.
 		uint32_t _totalFrames{};
-
-		/// Profiler thread.
+		/// Frame in progress flag.
+		bool _inFrame{};
+		/// Thread that drives the profiling frame.
 		std::thread::id _threadId{};
+		/// Timestamp at profiler creation.
+		uint64_t _startTime;
+		/// Unique id of this profiler instance, used to detect stale thread-local data.
+		uint32_t _generation;
+		/// Per-thread profiling data. Index 0 is the main thread.
+		std::vector<std::unique_ptr<ProfilerThread>> _threads;
+		/// Slots released by exited threads, reused before creating new ones.
+		std::vector<ProfilerThread*> _freeThreads;
+		/// Mutex for registering threads.
+		mutable std::mutex _threadsMutex;
+
+		/// Trace capture ring buffer.
+		std::unique_ptr<ProfilerTraceEvent[]> _traceEvents;
+		/// Trace capture ring buffer size in events.
+		size_t _traceBufferSize;
+		/// Number of trace events recorded in the current capture, including overwritten ones.
+		uint64_t _traceWriteIndex{};
+		/// Trace capture in progress flag.
+		bool _traceCapturing{};
+		/// Frames to wait before starting the capture.
+		uint32_t _traceDelayFrames{};
+		/// Frames left to capture.
+		uint32_t _traceFramesLeft{};
 	};
 
 	/// Helper class for automatically beginning and ending a profiling block
 	class ALIMER_API AutoProfileBlock
 	{
 	public:
-		/// Construct and begin a profiling block. The name must be persistent; string literals are recommended.
+		/// Construct and begin a profiling block by scope id.
+		AutoProfileBlock(uint32_t id)
+			: _profiler(Profiler::GetInstance())
+		{
+			if (_profiler)
+				_profiler->BeginBlock(id);
+		}
+
+		/// Construct and begin a profiling block by name. The name must be persistent; string literals are recommended.
 		AutoProfileBlock(const char* name)
+			: _profiler(Profiler::GetInstance())
 		{
-			_profiler = Object::GetSubsystem<Profiler>();
 			if (_profiler)
 				_profiler->BeginBlock(name);
 		}
@@ -152,11 +326,14 @@ namespace Alimer
 
 	private:
 		/// Profiler subsystem.
-		Profiler * _profiler;
+		Profiler* _profiler;
 	};
 
 #ifdef ALIMER_PROFILING
-#	define ALIMER_PROFILE(name) Alimer::AutoProfileBlock profile_ ## name (#name)
+	// The scope name is registered once per call site; afterwards entering the scope only records a timestamped event
+#	define ALIMER_PROFILE(name) \
+		static const uint32_t profileScope_ ## name = Alimer::Profiler::RegisterScope(#name); \
+		Alimer::AutoProfileBlock profile_ ## name (profileScope_ ## name)
 #else
 #	define ALIMER_PROFILE(name)
 #endif
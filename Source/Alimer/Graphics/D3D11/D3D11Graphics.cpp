@@ -248,22 +248,6 @@ namespace Alimer
 		return true;
 	}
 
-	bool Graphics::SetMultisample(uint32_t multisample)
-	{
-		if (!IsInitialized())
-			return false;
-
-		// TODO: Handle
-		_multisample = multisample;
-		return false;
-		//return SetMode(_backbufferSize, _window->IsFullscreen(), _window->IsResizable(), multisample_);
-	}
-
-	void Graphics::SetVSync(bool enable)
-	{
-		vsync = enable;
-	}
-
 	void D3D11Graphics::Finalize()
 	{
 		// Release all GPU objects
@@ -581,51 +565,6 @@ namespace Alimer
 		rasterizerStateDirty = true;
 	}
 
-	void Graphics::SetStencilTest(bool stencilEnable, const StencilTestDesc& stencilTest, unsigned char stencilRef)
-	{
-		renderState.stencilEnable = stencilEnable;
-		// When stencil test is disabled, always set default stencil test parameters to prevent creating unnecessary states
-		renderState.stencilTest = stencilEnable ? stencilTest : StencilTestDesc();
-		renderState.stencilRef = stencilRef;
-
-		depthStateDirty = true;
-	}
-
-	void Graphics::ResetRenderTargets()
-	{
-		SetRenderTarget(nullptr, nullptr);
-	}
-
-	void Graphics::ResetViewport()
-	{
-		SetViewport(IntRect(_renderTargetSize));
-	}
-
-	void Graphics::ResetVertexBuffers()
-	{
-		for (uint32_t i = 0; i < MaxVertexBuffers; ++i)
-		{
-			SetVertexBuffer(i, nullptr);
-		}
-	}
-
-	void Graphics::ResetConstantBuffers()
-	{
-		for (uint32_t i = 0; i < static_cast<unsigned>(ShaderStage::Count); ++i)
-		{
-			for (uint32_t j = 0; i < MAX_CONSTANT_BUFFERS; ++j)
-			{
-				SetConstantBuffer((ShaderStage)i, j, nullptr);
-			}
-		}
-	}
-
-	void Graphics::ResetTextures()
-	{
-		for (size_t i = 0; i < MAX_TEXTURE_UNITS; ++i)
-			SetTexture(i, nullptr);
-	}
-
 	void D3D11Graphics::Clear(ClearFlags clearFlags, const Color& clearColor, float clearDepth, uint8_t clearStencil)
 	{
 		PrepareTextures();
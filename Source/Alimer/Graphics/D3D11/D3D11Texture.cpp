@@ -225,7 +225,8 @@ namespace Alimer
 		if (usage & TextureUsageBits::ShaderWrite)
 			d3dUsage |= D3D11_BIND_UNORDERED_ACCESS;
 
-		if (graphics && graphics->IsInitialized())
+		// Other backends, such as the null backend, only need the texture description
+		if (graphics && graphics->IsInitialized() && graphics->GetDeviceType() == GraphicsDeviceType::Direct3D11)
 		{
 			ID3D11Device1* d3dDevice = static_cast<D3D11Graphics*>(graphics.Get())->GetD3DDevice();
 
@@ -352,6 +353,12 @@ namespace Alimer
 				ALIMER_LOGERROR("Failed to create shader resource view for texture");
 			}
 		}
+		else
+		{
+			_size = size;
+			_format = format;
+			_mipLevels = mipLevels;
+		}
 
 		return true;
 	}
@@ -381,7 +388,8 @@ namespace Alimer
 		SafeRelease(_sampler);
 
 		if (graphics
-			&& graphics->IsInitialized())
+			&& graphics->IsInitialized()
+			&& graphics->GetDeviceType() == GraphicsDeviceType::Direct3D11)
 		{
 			D3D11_SAMPLER_DESC samplerDesc = {};
 
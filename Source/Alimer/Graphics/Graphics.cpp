@@ -30,6 +30,7 @@
 #include "IndexBuffer.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "Null/NullGraphics.h"
 
 #ifdef ALIMER_D3D11
 #	include "D3D11/D3D11Graphics.h"
@@ -149,6 +150,67 @@ namespace Alimer
 		rasterizerStateDirty = true;
 	}
 
+	bool Graphics::SetMultisample(uint32_t multisample)
+	{
+		if (!IsInitialized())
+			return false;
+
+		// TODO: Handle
+		_multisample = multisample;
+		return false;
+		//return SetMode(_backbufferSize, _window->IsFullscreen(), _window->IsResizable(), multisample_);
+	}
+
+	void Graphics::SetVSync(bool enable)
+	{
+		vsync = enable;
+	}
+
+	void Graphics::SetStencilTest(bool stencilEnable, const StencilTestDesc& stencilTest, unsigned char stencilRef)
+	{
+		renderState.stencilEnable = stencilEnable;
+		// When stencil test is disabled, always set default stencil test parameters to prevent creating unnecessary states
+		renderState.stencilTest = stencilEnable ? stencilTest : StencilTestDesc();
+		renderState.stencilRef = stencilRef;
+
+		depthStateDirty = true;
+	}
+
+	void Graphics::ResetRenderTargets()
+	{
+		SetRenderTarget(nullptr, nullptr);
+	}
+
+	void Graphics::ResetViewport()
+	{
+		SetViewport(IntRect(_renderTargetSize));
+	}
+
+	void Graphics::ResetVertexBuffers()
+	{
+		for (uint32_t i = 0; i < MaxVertexBuffers; ++i)
+		{
+			SetVertexBuffer(i, nullptr);
+		}
+	}
+
+	void Graphics::ResetConstantBuffers()
+	{
+		for (uint32_t i = 0; i < static_cast<unsigned>(ShaderStage::Count); ++i)
+		{
+			for (uint32_t j = 0; j < MAX_CONSTANT_BUFFERS; ++j)
+			{
+				SetConstantBuffer((ShaderStage)i, j, nullptr);
+			}
+		}
+	}
+
+	void Graphics::ResetTextures()
+	{
+		for (size_t i = 0; i < MAX_TEXTURE_UNITS; ++i)
+			SetTexture(i, nullptr);
+	}
+
 	void Graphics::AddGPUObject(GPUObject* object)
 	{
 		if (object)
@@ -172,6 +234,7 @@ namespace Alimer
 		if (availableDrivers.empty())
 		{
 			availableDrivers.push_back(GraphicsDeviceType::Empty);
+			availableDrivers.push_back(GraphicsDeviceType::Null);
 
 #ifdef ALIMER_D3D11
 			if (D3D11Graphics::IsSupported())
@@ -198,6 +261,7 @@ namespace Alimer
 		switch (deviceType)
 		{
 		case GraphicsDeviceType::Empty:
+		case GraphicsDeviceType::Null:
 			return true;
 
 		case GraphicsDeviceType::Direct3D11:
@@ -264,6 +328,12 @@ namespace Alimer
 			break;
 		}
 
+		case GraphicsDeviceType::Null: {
+			ALIMER_LOGINFO("Using null graphics backend.");
+			graphics = new NullGraphics(validation, applicationName);
+			break;
+		}
+
 		case GraphicsDeviceType::Direct3D11: {
 #ifdef ALIMER_D3D11
 			ALIMER_LOGINFO("Using Direct3D11 graphics backend.");
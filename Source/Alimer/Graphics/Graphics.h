@@ -173,6 +173,8 @@ namespace Alimer
 
 		/// Return whether has the rendering window and context.
 		bool IsInitialized() const;
+		/// Return the backend type.
+		GraphicsDeviceType GetDeviceType() const { return _deviceType; }
 		/// Return backbuffer size, or 0,0 if not initialized.
 		const Size& GetSize() const { return _backbufferSize; }
 		/// Return backbuffer width, or 0 if not initialized.
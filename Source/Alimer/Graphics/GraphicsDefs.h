@@ -62,6 +62,7 @@ namespace Alimer
 	{
 		Default,
 		Empty,
+		Null,
 		Direct3D11,
 		OpenGL,
 		Vulkan
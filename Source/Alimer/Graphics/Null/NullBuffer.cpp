@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "NullBuffer.h"
+#include "NullGraphics.h"
+#include <cstring>
+
+namespace Alimer
+{
+	NullBuffer::NullBuffer(NullGraphics* graphics, BufferUsage usage, uint32_t size, uint32_t stride, const void* initialData)
+		: _graphics(graphics)
+		, _usage(usage)
+		, _stride(stride)
+		, _data(size)
+	{
+		if (initialData && size)
+			memcpy(_data.data(), initialData, size);
+	}
+
+	NullBuffer::~NullBuffer()
+	{
+		if (_graphics)
+			_graphics->UnbindBuffer(this);
+	}
+
+	bool NullBuffer::SetData(uint32_t offset, uint32_t size, const void* data)
+	{
+		if (offset + size > _data.size())
+			return false;
+
+		memcpy(_data.data() + offset, data, size);
+		_graphics->RecordBufferUpdate(this, offset, size);
+		return true;
+	}
+}
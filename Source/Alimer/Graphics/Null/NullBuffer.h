@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../GraphicsImpl.h"
+#include <vector>
+
+namespace Alimer
+{
+	class NullGraphics;
+
+	/// Null backend buffer. Keeps a CPU copy of the contents so that uploads can be inspected.
+	class ALIMER_API NullBuffer final : public BufferHandle
+	{
+	public:
+		/// Construct.
+		NullBuffer(NullGraphics* graphics, BufferUsage usage, uint32_t size, uint32_t stride, const void* initialData);
+		/// Destruct.
+		~NullBuffer();
+
+		bool SetData(uint32_t offset, uint32_t size, const void* data) override;
+
+		/// Return buffer usage.
+		BufferUsage GetUsage() const { return _usage; }
+		/// Return element stride.
+		uint32_t GetStride() const { return _stride; }
+		/// Return current contents.
+		const std::vector<uint8_t>& GetData() const { return _data; }
+
+	private:
+		NullGraphics* _graphics;
+		BufferUsage _usage;
+		uint32_t _stride;
+
+		/// CPU copy of the contents.
+		std::vector<uint8_t> _data;
+	};
+
+}
@@ -0,0 +1,572 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../../Debug/Log.h"
+#include "../../Debug/Profiler.h"
+#include "../../Window/Window.h"
+#include "../ConstantBuffer.h"
+#include "../Texture.h"
+#include "../VertexBuffer.h"
+#include "NullBuffer.h"
+#include "NullGraphics.h"
+using namespace std;
+
+namespace Alimer
+{
+	static const char* nullCommandNames[] =
+	{
+		"SetRenderTargets",
+		"SetViewport",
+		"SetVertexBuffer",
+		"SetIndexBuffer",
+		"SetConstantBuffer",
+		"SetTexture",
+		"SetShaders",
+		"SetScissorTest",
+		"SetPrimitiveType",
+		"SetBlendState",
+		"SetDepthState",
+		"SetRasterizerState",
+		"UpdateBuffer",
+		"Clear",
+		"Draw",
+		"DrawIndexed",
+		"DrawInstanced",
+		"DrawIndexedInstanced",
+		"Present",
+		nullptr
+	};
+
+	static bool StencilTestEquals(const StencilTestDesc& lhs, const StencilTestDesc& rhs)
+	{
+		return lhs.stencilReadMask == rhs.stencilReadMask && lhs.stencilWriteMask == rhs.stencilWriteMask &&
+			lhs.frontFunc == rhs.frontFunc && lhs.frontFail == rhs.frontFail && lhs.frontDepthFail == rhs.frontDepthFail &&
+			lhs.frontPass == rhs.frontPass && lhs.backFunc == rhs.backFunc && lhs.backFail == rhs.backFail &&
+			lhs.backDepthFail == rhs.backDepthFail && lhs.backPass == rhs.backPass;
+	}
+
+	NullGraphics::NullGraphics(bool validation, const string& /*applicationName*/)
+		: Graphics(GraphicsDeviceType::Null, validation)
+	{
+		ResetState();
+	}
+
+	NullGraphics::~NullGraphics()
+	{
+		Finalize();
+	}
+
+	bool NullGraphics::IsSupported()
+	{
+		return true;
+	}
+
+	bool NullGraphics::Initialize(const GraphicsSettings& settings)
+	{
+		if (_initialized)
+			return true;
+
+		uint32_t multisample = Clamp(settings.multisample, 1, 16);
+		if (settings.window)
+			_backbufferSize = Size(settings.window->GetWidth(), settings.window->GetHeight());
+		else
+			_backbufferSize = _headlessSize;
+
+		_renderTargetSize = _backbufferSize;
+		_multisample = multisample;
+		vsync = settings.verticalSync;
+		viewport = IntRect(0, 0, _backbufferSize.width, _backbufferSize.height);
+
+		screenModeEvent.size = _backbufferSize;
+		screenModeEvent.fullscreen = settings.window ? settings.window->IsFullscreen() : false;
+		screenModeEvent.resizable = settings.window ? settings.window->IsResizable() : false;
+		screenModeEvent.multisample = multisample;
+		SendEvent(screenModeEvent);
+
+		ALIMER_LOGDEBUG("Set null screen mode {}x{} multisample {}",
+			_backbufferSize.width,
+			_backbufferSize.height,
+			multisample);
+
+		_initialized = true;
+		return true;
+	}
+
+	void NullGraphics::Finalize()
+	{
+		// Release all GPU objects
+		Graphics::Finalize();
+
+		ClearCommands();
+		ResetState();
+	}
+
+	bool NullGraphics::BeginFrame()
+	{
+		if (!_initialized)
+			return false;
+
+		ClearCommands();
+		return true;
+	}
+
+	void NullGraphics::Present()
+	{
+		if (!_initialized)
+			return;
+
+		NullCommand command;
+		command.type = NullCommandType::Present;
+		Record(command);
+	}
+
+	void NullGraphics::SetBackbufferSize(const Size& size)
+	{
+		_headlessSize = size;
+	}
+
+	void NullGraphics::ClearCommands()
+	{
+		_commands.clear();
+		_stats.Reset();
+	}
+
+	size_t NullGraphics::GetNumCommands(NullCommandType type) const
+	{
+		size_t count = 0;
+		for (auto it = _commands.begin(); it != _commands.end(); ++it)
+		{
+			if (it->type == type)
+				++count;
+		}
+
+		return count;
+	}
+
+	const char* NullGraphics::GetCommandName(NullCommandType type)
+	{
+		return type < NullCommandType::Count ? nullCommandNames[ecast(type)] : "Unknown";
+	}
+
+	void NullGraphics::SetRenderTargets(
+		const std::vector<Texture*>& renderTargets,
+		Texture* depthStencil)
+	{
+		bool changed = false;
+		for (size_t i = 0; i < MAX_RENDERTARGETS; ++i)
+		{
+			Texture* renderTarget = (i < renderTargets.size() && renderTargets[i] && renderTargets[i]->IsRenderTarget()) ?
+				renderTargets[i] : nullptr;
+			if (renderTarget != _renderTargets[i])
+			{
+				_renderTargets[i] = renderTarget;
+				changed = true;
+			}
+		}
+
+		Texture* newDepthStencil = (depthStencil && depthStencil->IsDepthStencil()) ? depthStencil : nullptr;
+		if (newDepthStencil != _depthStencil)
+		{
+			_depthStencil = newDepthStencil;
+			changed = true;
+		}
+
+		// The backbuffer size may have changed even if the bindings did not, so always update the size
+		if (_renderTargets[0])
+			_renderTargetSize = _renderTargets[0]->GetSize();
+		else if (depthStencil)
+			_renderTargetSize = depthStencil->GetSize();
+		else
+			_renderTargetSize = _backbufferSize;
+
+		if (changed)
+			RecordStateChange(NullCommandType::SetRenderTargets, 0, _renderTargets[0], _depthStencil);
+	}
+
+	void NullGraphics::SetViewport(const IntRect& viewport_)
+	{
+		/// \todo Implement a member function in IntRect for clipping
+		IntRect newViewport;
+		newViewport.left = Clamp(viewport_.left, 0, static_cast<int>(_renderTargetSize.width) - 1);
+		newViewport.top = Clamp(viewport_.top, 0, static_cast<int>(_renderTargetSize.height) - 1);
+		newViewport.right = Clamp(viewport_.right, newViewport.left + 1, static_cast<int>(_renderTargetSize.width));
+		newViewport.bottom = Clamp(viewport_.bottom, newViewport.top + 1, static_cast<int>(_renderTargetSize.height));
+
+		if (newViewport == viewport)
+			return;
+
+		viewport = newViewport;
+
+		NullCommand command;
+		command.type = NullCommandType::SetViewport;
+		command.start = viewport.left;
+		command.count = viewport.top;
+		command.vertexStart = viewport.right;
+		command.instanceStart = viewport.bottom;
+		Record(command);
+		++_stats.numStateChanges;
+	}
+
+	void NullGraphics::SetVertexBuffer(
+		uint32_t index,
+		VertexBuffer* buffer,
+		uint32_t vertexOffset,
+		VertexInputRate stepRate)
+	{
+		if (index >= MaxVertexBuffers)
+		{
+			ALIMER_LOGERROR("SetVertexBuffer index out of bound");
+			return;
+		}
+
+		if (_vertexBuffers[index] != buffer
+			|| _vertexOffsets[index] != vertexOffset
+			|| _vertexRates[index] != stepRate)
+		{
+			_vertexBuffers[index] = buffer;
+			_vertexOffsets[index] = buffer ? vertexOffset : 0;
+			_vertexRates[index] = buffer ? stepRate : VertexInputRate::Vertex;
+
+			NullCommand command;
+			command.type = NullCommandType::SetVertexBuffer;
+			command.index = index;
+			command.object = buffer;
+			command.start = _vertexOffsets[index];
+			Record(command);
+			++_stats.numStateChanges;
+		}
+	}
+
+	void NullGraphics::SetConstantBuffer(ShaderStage stage, uint32_t index, ConstantBuffer* buffer)
+	{
+		if (stage < ShaderStage::Count
+			&& index < MAX_CONSTANT_BUFFERS
+			&& buffer != _constantBuffers[ecast(stage)][index])
+		{
+			_constantBuffers[ecast(stage)][index] = buffer;
+
+			NullCommand command;
+			command.type = NullCommandType::SetConstantBuffer;
+			command.index = index;
+			command.object = buffer;
+			command.start = ecast(stage);
+			Record(command);
+			++_stats.numStateChanges;
+		}
+	}
+
+	void NullGraphics::SetTexture(size_t index, Texture* texture)
+	{
+		if (index < MAX_TEXTURE_UNITS && textures[index] != texture)
+		{
+			textures[index] = texture;
+			RecordStateChange(NullCommandType::SetTexture, static_cast<uint32_t>(index), texture);
+		}
+	}
+
+	void NullGraphics::SetIndexBufferCore(BufferHandle* handle, IndexType type)
+	{
+		if (handle == _currentIndexBuffer)
+			return;
+
+		_currentIndexBuffer = handle;
+		RecordStateChange(NullCommandType::SetIndexBuffer, static_cast<uint32_t>(type), handle);
+	}
+
+	void NullGraphics::SetShaders(ShaderVariation* vs, ShaderVariation* ps)
+	{
+		if (vs == vertexShader && ps == pixelShader)
+			return;
+
+		vertexShader = vs;
+		pixelShader = ps;
+		RecordStateChange(NullCommandType::SetShaders, 0, vs, ps);
+		++_stats.numShaderChanges;
+	}
+
+	void NullGraphics::SetScissorTest(bool scissorEnable, const IntRect& scissorRect)
+	{
+		/// \todo Implement a member function in IntRect for clipping
+		IntRect newRect;
+		newRect.left = Clamp(scissorRect.left, 0, static_cast<int>(_renderTargetSize.width) - 1);
+		newRect.top = Clamp(scissorRect.top, 0, static_cast<int>(_renderTargetSize.height) - 1);
+		newRect.right = Clamp(scissorRect.right, newRect.left + 1, static_cast<int>(_renderTargetSize.width));
+		newRect.bottom = Clamp(scissorRect.bottom, newRect.top + 1, static_cast<int>(_renderTargetSize.height));
+
+		if (scissorEnable == renderState.scissorEnable && newRect == renderState.scissorRect)
+			return;
+
+		renderState.scissorEnable = scissorEnable;
+		renderState.scissorRect = newRect;
+		RecordStateChange(NullCommandType::SetScissorTest, scissorEnable ? 1 : 0);
+
+		rasterizerStateDirty = true;
+	}
+
+	void NullGraphics::Clear(ClearFlags clearFlags, const Color& /*clearColor*/, float /*clearDepth*/, uint8_t /*clearStencil*/)
+	{
+		NullCommand command;
+		command.type = NullCommandType::Clear;
+		command.index = static_cast<uint32_t>(clearFlags);
+		command.object = _renderTargets[0];
+		command.object2 = _depthStencil;
+		Record(command);
+	}
+
+	void NullGraphics::Draw(PrimitiveType type, uint32_t vertexStart, uint32_t vertexCount)
+	{
+		if (!PrepareDraw(type))
+			return;
+
+		NullCommand command;
+		command.type = NullCommandType::Draw;
+		command.index = type;
+		command.start = vertexStart;
+		command.count = vertexCount;
+		command.instanceCount = 1;
+		Record(command);
+	}
+
+	void NullGraphics::DrawIndexed(PrimitiveType type, uint32_t indexStart, uint32_t indexCount, uint32_t vertexStart)
+	{
+		if (!PrepareDraw(type))
+			return;
+
+		NullCommand command;
+		command.type = NullCommandType::DrawIndexed;
+		command.index = type;
+		command.object = _currentIndexBuffer;
+		command.start = indexStart;
+		command.count = indexCount;
+		command.vertexStart = vertexStart;
+		command.instanceCount = 1;
+		Record(command);
+	}
+
+	void NullGraphics::DrawInstanced(
+		PrimitiveType type,
+		uint32_t vertexStart,
+		uint32_t vertexCount,
+		uint32_t instanceStart,
+		uint32_t instanceCount)
+	{
+		if (!PrepareDraw(type))
+			return;
+
+		NullCommand command;
+		command.type = NullCommandType::DrawInstanced;
+		command.index = type;
+		command.start = vertexStart;
+		command.count = vertexCount;
+		command.instanceStart = instanceStart;
+		command.instanceCount = instanceCount;
+		Record(command);
+	}
+
+	void NullGraphics::DrawIndexedInstanced(
+		PrimitiveType type,
+		uint32_t indexStart,
+		uint32_t indexCount,
+		uint32_t vertexStart,
+		uint32_t instanceStart,
+		uint32_t instanceCount)
+	{
+		if (!PrepareDraw(type))
+			return;
+
+		NullCommand command;
+		command.type = NullCommandType::DrawIndexedInstanced;
+		command.index = type;
+		command.object = _currentIndexBuffer;
+		command.start = indexStart;
+		command.count = indexCount;
+		command.vertexStart = vertexStart;
+		command.instanceStart = instanceStart;
+		command.instanceCount = instanceCount;
+		Record(command);
+	}
+
+	BufferHandle* NullGraphics::CreateBuffer(BufferUsage usage, uint32_t size, uint32_t stride, ResourceUsage /*resourceUsage*/, const void* initialData)
+	{
+		return new NullBuffer(this, usage, size, stride, initialData);
+	}
+
+	bool NullGraphics::PrepareDraw(PrimitiveType type)
+	{
+		if (!vertexShader || !pixelShader)
+			return false;
+
+		if (primitiveType != type)
+		{
+			RecordStateChange(NullCommandType::SetPrimitiveType, type);
+			primitiveType = type;
+		}
+
+		// Like the hardware backends, only count render state changes that would result in a different state object
+		if (blendStateDirty)
+		{
+			if (!_appliedStateValid
+				|| !(renderState.blendMode == _appliedState.blendMode)
+				|| renderState.colorWriteMask != _appliedState.colorWriteMask
+				|| renderState.alphaToCoverage != _appliedState.alphaToCoverage)
+			{
+				RecordStateChange(NullCommandType::SetBlendState);
+			}
+
+			blendStateDirty = false;
+		}
+
+		if (depthStateDirty)
+		{
+			if (!_appliedStateValid
+				|| renderState.depthFunc != _appliedState.depthFunc
+				|| renderState.depthWrite != _appliedState.depthWrite
+				|| renderState.stencilEnable != _appliedState.stencilEnable
+				|| renderState.stencilRef != _appliedState.stencilRef
+				|| !StencilTestEquals(renderState.stencilTest, _appliedState.stencilTest))
+			{
+				RecordStateChange(NullCommandType::SetDepthState);
+			}
+
+			depthStateDirty = false;
+		}
+
+		if (rasterizerStateDirty)
+		{
+			if (!_appliedStateValid
+				|| renderState.fillMode != _appliedState.fillMode
+				|| renderState.cullMode != _appliedState.cullMode
+				|| renderState.depthBias != _appliedState.depthBias
+				|| renderState.slopeScaledDepthBias != _appliedState.slopeScaledDepthBias
+				|| renderState.depthClip != _appliedState.depthClip
+				|| renderState.scissorEnable != _appliedState.scissorEnable)
+			{
+				RecordStateChange(NullCommandType::SetRasterizerState);
+			}
+
+			rasterizerStateDirty = false;
+		}
+
+		_appliedState = renderState;
+		_appliedStateValid = true;
+		return true;
+	}
+
+	void NullGraphics::Record(const NullCommand& command)
+	{
+		switch (command.type)
+		{
+		case NullCommandType::Draw:
+		case NullCommandType::DrawIndexed:
+			++_stats.numDraws;
+			++_stats.numInstances;
+			_stats.numElements += command.count;
+			break;
+
+		case NullCommandType::DrawInstanced:
+		case NullCommandType::DrawIndexedInstanced:
+			++_stats.numDraws;
+			++_stats.numInstancedDraws;
+			_stats.numInstances += command.instanceCount;
+			_stats.numElements += static_cast<uint64_t>(command.count) * command.instanceCount;
+			break;
+
+		default:
+			break;
+		}
+
+		if (_recordCommands)
+			_commands.push_back(command);
+	}
+
+	void NullGraphics::RecordStateChange(NullCommandType type, uint32_t index, const void* object, const void* object2)
+	{
+		NullCommand command;
+		command.type = type;
+		command.index = index;
+		command.object = object;
+		command.object2 = object2;
+		Record(command);
+		++_stats.numStateChanges;
+	}
+
+	void NullGraphics::RecordBufferUpdate(NullBuffer* buffer, uint32_t offset, uint32_t size)
+	{
+		NullCommand command;
+		command.type = NullCommandType::UpdateBuffer;
+		command.object = buffer;
+		command.start = offset;
+		command.count = size;
+		Record(command);
+		++_stats.numBufferUpdates;
+		_stats.bufferUpdateBytes += size;
+	}
+
+	void NullGraphics::UnbindBuffer(NullBuffer* buffer)
+	{
+		if (_currentIndexBuffer == buffer)
+			SetIndexBufferCore(nullptr, IndexType::UInt16);
+
+		for (uint32_t i = 0; i < MaxVertexBuffers; ++i)
+		{
+			if (_vertexBuffers[i] && _vertexBuffers[i]->GetHandle() == buffer)
+				SetVertexBuffer(i, nullptr, 0, VertexInputRate::Vertex);
+		}
+	}
+
+	void NullGraphics::ResetState()
+	{
+		for (uint32_t i = 0; i < MaxVertexBuffers; ++i)
+		{
+			_vertexBuffers[i] = nullptr;
+			_vertexOffsets[i] = 0;
+			_vertexRates[i] = VertexInputRate::Vertex;
+		}
+
+		for (uint32_t i = 0; i < ecast(ShaderStage::Count); ++i)
+		{
+			for (uint32_t j = 0; j < MAX_CONSTANT_BUFFERS; ++j)
+				_constantBuffers[i][j] = nullptr;
+		}
+
+		for (size_t i = 0; i < MAX_TEXTURE_UNITS; ++i)
+			textures[i] = nullptr;
+
+		for (size_t i = 0; i < MAX_RENDERTARGETS; ++i)
+			_renderTargets[i] = nullptr;
+
+		renderState.Reset();
+
+		_depthStencil = nullptr;
+		_currentIndexBuffer = nullptr;
+		vertexShader = nullptr;
+		pixelShader = nullptr;
+		_appliedStateValid = false;
+		texturesDirty = false;
+		blendStateDirty = false;
+		depthStateDirty = false;
+		rasterizerStateDirty = false;
+		scissorRectDirty = false;
+		primitiveType = MAX_PRIMITIVE_TYPES;
+	}
+}
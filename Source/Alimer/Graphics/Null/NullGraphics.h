@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Graphics.h"
+
+namespace Alimer
+{
+	class NullBuffer;
+
+	/// Type of a command recorded by the null graphics backend.
+	enum class NullCommandType : uint8_t
+	{
+		SetRenderTargets,
+		SetViewport,
+		SetVertexBuffer,
+		SetIndexBuffer,
+		SetConstantBuffer,
+		SetTexture,
+		SetShaders,
+		SetScissorTest,
+		SetPrimitiveType,
+		SetBlendState,
+		SetDepthState,
+		SetRasterizerState,
+		UpdateBuffer,
+		Clear,
+		Draw,
+		DrawIndexed,
+		DrawInstanced,
+		DrawIndexedInstanced,
+		Present,
+		Count
+	};
+
+	/// Command recorded by the null graphics backend. Fields not used by the command type are zero.
+	struct ALIMER_API NullCommand
+	{
+		/// Command type.
+		NullCommandType type;
+		/// Binding slot, primitive type for draws, or clear flags.
+		uint32_t index{ 0 };
+		/// Bound object: buffer, texture, vertex shader or first rendertarget.
+		const void* object{ nullptr };
+		/// Second bound object: pixel shader or depth stencil.
+		const void* object2{ nullptr };
+		/// First vertex or index, buffer update byte offset, or shader stage for constant buffers.
+		uint32_t start{ 0 };
+		/// Vertex or index count, or buffer update byte count.
+		uint32_t count{ 0 };
+		/// Base vertex for indexed draws.
+		uint32_t vertexStart{ 0 };
+		/// First instance.
+		uint32_t instanceStart{ 0 };
+		/// Number of instances.
+		uint32_t instanceCount{ 0 };
+	};
+
+	/// Counters of the null graphics backend since the last BeginFrame().
+	struct ALIMER_API NullGraphicsStats
+	{
+		/// Reset all counters.
+		void Reset() { *this = NullGraphicsStats(); }
+
+		/// Number of draw calls.
+		uint32_t numDraws{ 0 };
+		/// Number of instanced draw calls.
+		uint32_t numInstancedDraws{ 0 };
+		/// Number of instances drawn, counting non-instanced draws as one.
+		uint32_t numInstances{ 0 };
+		/// Number of vertices or indices submitted.
+		uint64_t numElements{ 0 };
+		/// Number of state changes: bindings, shaders and render state objects.
+		uint32_t numStateChanges{ 0 };
+		/// Number of shader changes.
+		uint32_t numShaderChanges{ 0 };
+		/// Number of buffer data updates.
+		uint32_t numBufferUpdates{ 0 };
+		/// Number of bytes uploaded to buffers.
+		uint64_t bufferUpdateBytes{ 0 };
+	};
+
+	/// Null graphics backend. Does not need a GPU or a window; records draw calls and state changes into an inspectable command list instead.
+	class ALIMER_API NullGraphics final : public Graphics
+	{
+		friend class NullBuffer;
+
+	public:
+		/// Construct.
+		NullGraphics(bool validation, const std::string& applicationName);
+		/// Destruct.
+		~NullGraphics() override;
+
+		/// Is backend supported?
+		static bool IsSupported();
+
+		bool Initialize(const GraphicsSettings& settings) override;
+
+		void SetRenderTargets(const std::vector<Texture*>& renderTargets, Texture* stencilBuffer) override;
+		void SetViewport(const IntRect& viewport) override;
+		void SetVertexBuffer(
+			uint32_t index,
+			VertexBuffer* buffer,
+			uint32_t vertexOffset,
+			VertexInputRate stepRate) override;
+		void SetConstantBuffer(ShaderStage stage, uint32_t index, ConstantBuffer* buffer) override;
+		void SetTexture(size_t index, Texture* texture) override;
+		void SetShaders(ShaderVariation* vs, ShaderVariation* ps) override;
+		void SetScissorTest(bool scissorEnable, const IntRect& scissorRect) override;
+
+		void Clear(ClearFlags clearFlags, const Color& clearColor, float clearDepth, uint8_t clearStencil) override;
+		void Draw(PrimitiveType type, uint32_t vertexStart, uint32_t vertexCount) override;
+		void DrawIndexed(PrimitiveType type, uint32_t indexStart, uint32_t indexCount, uint32_t vertexStart) override;
+		void DrawInstanced(PrimitiveType type, uint32_t vertexStart, uint32_t vertexCount, uint32_t instanceStart, uint32_t instanceCount) override;
+		void DrawIndexedInstanced(PrimitiveType type, uint32_t indexStart, uint32_t indexCount, uint32_t vertexStart, uint32_t instanceStart, uint32_t instanceCount) override;
+
+		/// Set backbuffer size used when initialized without a window. Default 1920x1080.
+		void SetBackbufferSize(const Size& size);
+		/// Set whether to store commands. When disabled only the counters are updated, which is cheaper for benchmarking. Default true.
+		void SetRecordCommands(bool enable) { _recordCommands = enable; }
+		/// Clear the recorded commands and counters. Called automatically by BeginFrame().
+		void ClearCommands();
+
+		/// Return commands recorded since the last BeginFrame().
+		const std::vector<NullCommand>& GetCommands() const { return _commands; }
+		/// Return counters since the last BeginFrame().
+		const NullGraphicsStats& GetStats() const { return _stats; }
+		/// Return whether commands are stored.
+		bool GetRecordCommands() const { return _recordCommands; }
+		/// Return number of recorded commands of a type.
+		size_t GetNumCommands(NullCommandType type) const;
+
+		/// Return name of a command type.
+		static const char* GetCommandName(NullCommandType type);
+
+	private:
+		void Finalize() override;
+
+		bool BeginFrame() override;
+		void Present() override;
+
+		/// Apply dirty render state for the next draw call. Return false if the draw call should not be recorded.
+		bool PrepareDraw(PrimitiveType type);
+		/// Record a command.
+		void Record(const NullCommand& command);
+		/// Record a state change command.
+		void RecordStateChange(NullCommandType type, uint32_t index = 0, const void* object = nullptr, const void* object2 = nullptr);
+		/// Record a buffer data update. Called by NullBuffer.
+		void RecordBufferUpdate(NullBuffer* buffer, uint32_t offset, uint32_t size);
+		/// Unbind a buffer that is being destroyed. Called by NullBuffer.
+		void UnbindBuffer(NullBuffer* buffer);
+
+		BufferHandle* CreateBuffer(BufferUsage usage, uint32_t size, uint32_t stride, ResourceUsage resourceUsage, const void* initialData) override;
+
+		void SetIndexBufferCore(BufferHandle* handle, IndexType type) override;
+
+		/// Reset internally tracked state.
+		void ResetState();
+
+		/// Recorded commands.
+		std::vector<NullCommand> _commands;
+		/// Counters.
+		NullGraphicsStats _stats;
+		/// Command storing flag.
+		bool _recordCommands{ true };
+		/// Backbuffer size used without a window.
+		Size _headlessSize{ 1920, 1080 };
+
+		/// Bound vertex buffer offsets.
+		uint32_t _vertexOffsets[MaxVertexBuffers];
+		/// Bound vertex buffer step rates.
+		VertexInputRate _vertexRates[MaxVertexBuffers];
+		/// Bound constant buffers by shader stage.
+		ConstantBuffer* _constantBuffers[ecast(ShaderStage::Count)][MAX_CONSTANT_BUFFERS];
+		/// Current index buffer.
+		BufferHandle* _currentIndexBuffer = nullptr;
+		/// Render state applied by the last draw call.
+		RenderState _appliedState;
+		/// Whether the applied render state is valid.
+		bool _appliedStateValid{ false };
+	};
+}
@@ -49,7 +49,9 @@ namespace Alimer
 			std::string extension = GetExtension(source.GetName());
 			_stage = (extension == ".vs" || extension == ".vert") ? ShaderStage::Vertex : ShaderStage::Fragment;
 			_sourceCode.clear();
-			return ProcessIncludes(_sourceCode, source);
+			bool success = ProcessIncludes(_sourceCode, source);
+			SetMemoryUse(_sourceCode.length());
+			return success;
 
 			//ALIMER_LOGERROR(source.GetName() + " is not a valid shader file.");
 			//return false;
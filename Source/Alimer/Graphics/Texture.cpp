@@ -85,12 +85,14 @@ namespace Alimer
 			return false;
 
 		std::vector<ImageLevel> initialData;
+		uint64_t memoryUse = 0;
 
 		for (size_t i = 0; i < _loadImages.size(); ++i)
 		{
 			for (uint32_t j = 0; j < _loadImages[i]->GetMipLevels(); ++j)
 			{
 				initialData.push_back(_loadImages[i]->GetLevel(j));
+				memoryUse += initialData.back().rows * initialData.back().rowSize;
 			}
 		}
 
@@ -111,6 +113,7 @@ namespace Alimer
 			SamplerAddressMode::Wrap);
 
 		_loadImages.clear();
+		SetMemoryUse(0, success ? memoryUse : 0);
 		return success;
 	}
 }
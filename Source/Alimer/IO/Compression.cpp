@@ -0,0 +1,228 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Compression.h"
+
+#include <cstring>
+
+namespace Alimer
+{
+	/// Minimum match length of the LZ4 format.
+	static const size_t MIN_MATCH = 4;
+	/// Number of bytes at the end of a block that are always literals.
+	static const size_t LAST_LITERALS = 5;
+	/// A match must start at least this many bytes before the end of a block.
+	static const size_t MATCH_FIND_LIMIT = 12;
+	/// Largest match offset.
+	static const size_t MAX_OFFSET = 65535;
+	/// Number of bits in the compressor's hash table index.
+	static const unsigned HASH_BITS = 12;
+
+	static inline uint32_t Read32(const uint8_t* ptr)
+	{
+		uint32_t value;
+		memcpy(&value, ptr, sizeof value);
+		return value;
+	}
+
+	static inline uint32_t HashSequence(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+	static inline uint8_t* WriteLength(uint8_t* dest, size_t length)
+	{
+		while (length >= 255)
+		{
+			*dest++ = 255;
+			length -= 255;
+		}
+		*dest++ = static_cast<uint8_t>(length);
+		return dest;
+	}
+
+	static inline uint8_t* WriteLiterals(uint8_t* dest, uint8_t*& token, const uint8_t* literals, size_t length)
+	{
+		token = dest++;
+		if (length >= 15)
+		{
+			*token = 15 << 4;
+			dest = WriteLength(dest, length - 15);
+		}
+		else
+			*token = static_cast<uint8_t>(length << 4);
+
+		if (length)
+			memcpy(dest, literals, length);
+		return dest + length;
+	}
+
+	static inline bool ReadLength(const uint8_t*& src, const uint8_t* srcEnd, size_t& length)
+	{
+		uint8_t byte;
+		do
+		{
+			if (src >= srcEnd)
+				return false;
+			byte = *src++;
+			length += byte;
+		} while (byte == 255);
+
+		return true;
+	}
+
+	size_t EstimateCompressBound(size_t srcSize)
+	{
+		return srcSize + srcSize / 255 + 16;
+	}
+
+	size_t CompressData(void* dest, const void* src, size_t srcSize)
+	{
+		const uint8_t* srcStart = static_cast<const uint8_t*>(src);
+		const uint8_t* srcEnd = srcStart + srcSize;
+		const uint8_t* ip = srcStart;
+		const uint8_t* anchor = srcStart;
+		uint8_t* op = static_cast<uint8_t*>(dest);
+		uint8_t* token;
+
+		if (srcSize > MATCH_FIND_LIMIT)
+		{
+			const uint8_t* matchFindLimit = srcEnd - MATCH_FIND_LIMIT;
+			const uint8_t* matchLimit = srcEnd - LAST_LITERALS;
+			uint32_t hashTable[1 << HASH_BITS];
+			memset(hashTable, 0, sizeof hashTable);
+			unsigned misses = 0;
+
+			while (ip < matchFindLimit)
+			{
+				uint32_t sequence = Read32(ip);
+				uint32_t hash = HashSequence(sequence);
+				const uint8_t* ref = srcStart + hashTable[hash];
+				hashTable[hash] = static_cast<uint32_t>(ip - srcStart);
+
+				if (ref >= ip || static_cast<size_t>(ip - ref) > MAX_OFFSET || Read32(ref) != sequence)
+				{
+					// Skip faster over data that does not compress
+					ip += 1 + (misses++ >> 6);
+					continue;
+				}
+				misses = 0;
+
+				// Extend the match backward over pending literals, then forward
+				while (ip > anchor && ref > srcStart && ip[-1] == ref[-1])
+				{
+					--ip;
+					--ref;
+				}
+				const uint8_t* matchEnd = ip + MIN_MATCH;
+				const uint8_t* refEnd = ref + MIN_MATCH;
+				while (matchEnd < matchLimit && *matchEnd == *refEnd)
+				{
+					++matchEnd;
+					++refEnd;
+				}
+
+				op = WriteLiterals(op, token, anchor, static_cast<size_t>(ip - anchor));
+
+				size_t offset = static_cast<size_t>(ip - ref);
+				*op++ = static_cast<uint8_t>(offset);
+				*op++ = static_cast<uint8_t>(offset >> 8);
+
+				size_t matchLength = static_cast<size_t>(matchEnd - ip) - MIN_MATCH;
+				if (matchLength >= 15)
+				{
+					*token |= 15;
+					op = WriteLength(op, matchLength - 15);
+				}
+				else
+					*token |= static_cast<uint8_t>(matchLength);
+
+				ip = matchEnd;
+				anchor = ip;
+			}
+		}
+
+		// The last sequence only has literals
+		op = WriteLiterals(op, token, anchor, static_cast<size_t>(srcEnd - anchor));
+		return static_cast<size_t>(op - static_cast<uint8_t*>(dest));
+	}
+
+	bool DecompressData(void* dest, const void* src, size_t destSize, size_t srcSize)
+	{
+		const uint8_t* ip = static_cast<const uint8_t*>(src);
+		const uint8_t* srcEnd = ip + srcSize;
+		uint8_t* destStart = static_cast<uint8_t*>(dest);
+		uint8_t* op = destStart;
+		uint8_t* destEnd = op + destSize;
+
+		for (;;)
+		{
+			if (ip >= srcEnd)
+				return false;
+			uint8_t token = *ip++;
+
+			size_t literalLength = token >> 4;
+			if (literalLength == 15 && !ReadLength(ip, srcEnd, literalLength))
+				return false;
+			if (literalLength > static_cast<size_t>(srcEnd - ip) || literalLength > static_cast<size_t>(destEnd - op))
+				return false;
+
+			if (literalLength)
+				memcpy(op, ip, literalLength);
+			op += literalLength;
+			ip += literalLength;
+
+			// The last sequence ends the block after its literals
+			if (ip == srcEnd)
+				break;
+
+			if (srcEnd - ip < 2)
+				return false;
+			size_t offset = ip[0] | (ip[1] << 8);
+			ip += 2;
+			if (!offset || offset > static_cast<size_t>(op - destStart))
+				return false;
+
+			size_t matchLength = token & 15;
+			if (matchLength == 15 && !ReadLength(ip, srcEnd, matchLength))
+				return false;
+			matchLength += MIN_MATCH;
+			if (matchLength > static_cast<size_t>(destEnd - op))
+				return false;
+
+			// Matches may overlap their own output, so copy bytewise unless the regions are apart
+			const uint8_t* ref = op - offset;
+			if (offset >= matchLength)
+				memcpy(op, ref, matchLength);
+			else
+			{
+				for (size_t i = 0; i < matchLength; ++i)
+					op[i] = ref[i];
+			}
+			op += matchLength;
+		}
+
+		return op == destEnd;
+	}
+}
@@ -0,0 +1,39 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../AlimerConfig.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace Alimer
+{
+	/// Return the worst case size in bytes of LZ4 compressed data for the given input size.
+	ALIMER_API size_t EstimateCompressBound(size_t srcSize);
+	/// Compress data to the LZ4 block format. The destination must hold at least EstimateCompressBound() bytes. Return the compressed size.
+	ALIMER_API size_t CompressData(void* dest, const void* src, size_t srcSize);
+	/// Decompress LZ4 block format data whose uncompressed size is known. Return true on success, or false if the data is corrupt.
+	ALIMER_API bool DecompressData(void* dest, const void* src, size_t destSize, size_t srcSize);
+}
@@ -175,7 +175,7 @@ namespace Alimer
 		if (_position > _size)
 			_size = _position;
 
-		return _size;
+		return numBytes;
 	}
 
 	bool File::IsReadable() const
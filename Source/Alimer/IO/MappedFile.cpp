@@ -0,0 +1,188 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Debug/Log.h"
+#include "FileSystem.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+namespace Alimer
+{
+	MappedFile::MappedFile(const string& fileName)
+	{
+		Open(fileName);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const string& fileName)
+	{
+		Close();
+
+		if (fileName.empty())
+			return false;
+
+		size_t fileSize = 0;
+		const uint8_t* mapping = nullptr;
+
+#ifdef _WIN32
+		HANDLE file = CreateFileW(WideNativePath(fileName).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+			return false;
+		}
+		fileSize = static_cast<size_t>(size.QuadPart);
+
+		// Mapping an empty file fails, so leave it unmapped
+		if (fileSize)
+		{
+			HANDLE fileMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (fileMapping)
+			{
+				mapping = static_cast<const uint8_t*>(MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0));
+				CloseHandle(fileMapping);
+			}
+		}
+		CloseHandle(file);
+
+		if (fileSize && !mapping)
+		{
+			ALIMER_LOGERROR("Could not map file " + fileName);
+			return false;
+		}
+
+		if (mapping)
+			_data.reset(mapping, [](const uint8_t* data) { UnmapViewOfFile(data); });
+#else
+		int file = open(NativePath(fileName).c_str(), O_RDONLY);
+		if (file < 0)
+			return false;
+
+		struct stat st;
+		if (fstat(file, &st) || !S_ISREG(st.st_mode))
+		{
+			close(file);
+			return false;
+		}
+		fileSize = static_cast<size_t>(st.st_size);
+
+		// Mapping an empty file fails, so leave it unmapped
+		if (fileSize)
+		{
+			void* ptr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, file, 0);
+			if (ptr != MAP_FAILED)
+				mapping = static_cast<const uint8_t*>(ptr);
+		}
+		close(file);
+
+		if (fileSize && !mapping)
+		{
+			ALIMER_LOGERROR("Could not map file " + fileName);
+			return false;
+		}
+
+		if (mapping)
+			_data.reset(mapping, [fileSize](const uint8_t* data) { munmap(const_cast<uint8_t*>(data), fileSize); });
+#endif
+
+		_name = fileName;
+		_position = 0;
+		_size = fileSize;
+		_open = true;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		_data.reset();
+		_open = false;
+		_position = 0;
+		_size = 0;
+	}
+
+	size_t MappedFile::Read(void* dest, size_t numBytes)
+	{
+		if (numBytes + _position > _size)
+			numBytes = _size - _position;
+		if (!numBytes)
+			return 0;
+
+		memcpy(dest, _data.get() + _position, numBytes);
+		_position += numBytes;
+		return numBytes;
+	}
+
+	size_t MappedFile::Seek(size_t newPosition)
+	{
+		if (newPosition > _size)
+			newPosition = _size;
+
+		_position = newPosition;
+		return _position;
+	}
+
+	size_t MappedFile::Write(const void*, size_t)
+	{
+		return 0;
+	}
+
+	bool MappedFile::IsReadable() const
+	{
+		return _open;
+	}
+
+	bool MappedFile::IsWritable() const
+	{
+		return false;
+	}
+
+	std::shared_ptr<const uint8_t> MappedFile::Borrow(size_t numBytes)
+	{
+		if (!_data || numBytes > _size - _position)
+			return nullptr;
+
+		// Share ownership of the mapping, but point to the current position
+		std::shared_ptr<const uint8_t> ret(_data, _data.get() + _position);
+		_position += numBytes;
+		return ret;
+	}
+}
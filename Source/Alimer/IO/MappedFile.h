@@ -0,0 +1,75 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Stream.h"
+
+namespace Alimer
+{
+	/// Read-only file that is memory mapped instead of read through buffered calls. Loaders can borrow pointers into the mapping with Borrow() or ReadShared() instead of copying.
+	class ALIMER_API MappedFile : public Stream
+	{
+	public:
+		/// Construct.
+		MappedFile() = default;
+		/// Construct and open a file.
+		MappedFile(const std::string& fileName);
+		/// Destruct. Unmap the file unless borrowed pointers remain.
+		~MappedFile();
+
+		/// Read bytes from the mapping. Return number of bytes actually read.
+		size_t Read(void* dest, size_t numBytes) override;
+		/// Set position in bytes from the beginning of the file.
+		size_t Seek(size_t newPosition) override;
+		/// Write bytes. Not supported, return zero.
+		size_t Write(const void* data, size_t numBytes) override;
+		/// Return whether read operations are allowed.
+		bool IsReadable() const override;
+		/// Return whether write operations are allowed. Always false.
+		bool IsWritable() const override;
+		/// Return a pointer into the mapping and advance the position. The pointer keeps the mapping alive after the file is closed.
+		std::shared_ptr<const uint8_t> Borrow(size_t numBytes) override;
+
+		/// Open and map a file. Return true on success.
+		bool Open(const std::string& fileName);
+		/// Close the file. The mapping stays alive while borrowed pointers remain.
+		void Close();
+
+		/// Return whether is open.
+		bool IsOpen() const { return _open; }
+		/// Return the mapped file data.
+		const uint8_t* Data() const { return _data.get(); }
+
+		using Stream::Read;
+		using Stream::Write;
+
+	private:
+		/// Mapped file data. Unmapped when the last reference is gone.
+		std::shared_ptr<const uint8_t> _data;
+		/// Open flag. An empty file is open without a mapping.
+		bool _open = false;
+	};
+
+}
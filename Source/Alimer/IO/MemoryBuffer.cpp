@@ -55,6 +55,15 @@ namespace Alimer
 	{
 	}
 
+	MemoryBuffer::MemoryBuffer(const std::shared_ptr<const uint8_t>& data, size_t numBytes)
+		: Stream(data ? numBytes : 0)
+		, _buffer(const_cast<uint8_t*>(data.get()))
+		, _readOnly(true)
+		, _owner(data)
+	{
+		SetName("Memory");
+	}
+
 	size_t MemoryBuffer::Read(void* dest, size_t numBytes)
 	{
 		if (numBytes + _position > _size)
@@ -135,4 +144,14 @@ namespace Alimer
 	{
 		return _buffer && !_readOnly;
 	}
+
+	std::shared_ptr<const uint8_t> MemoryBuffer::Borrow(size_t numBytes)
+	{
+		if (!_owner || numBytes > _size - _position)
+			return nullptr;
+
+		std::shared_ptr<const uint8_t> ret(_owner, _buffer + _position);
+		_position += numBytes;
+		return ret;
+	}
 }
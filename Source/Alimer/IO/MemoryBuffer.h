@@ -40,6 +40,8 @@ namespace Alimer
 		MemoryBuffer(std::vector<uint8_t>& data);
 		/// Construct from a read-only vector, which must not go out of scope before MemoryBuffer.
 		MemoryBuffer(const std::vector<uint8_t>& data);
+		/// Construct as read-only from shared memory, which is kept alive by the buffer and by borrowed pointers.
+		MemoryBuffer(const std::shared_ptr<const uint8_t>& data, size_t numBytes);
 
 		/// Read bytes from the memory area. Return number of bytes actually read.
 		size_t Read(void* dest, size_t numBytes) override;
@@ -51,6 +53,8 @@ namespace Alimer
 		bool IsReadable() const override;
 		/// Return whether write operations are allowed.
 		bool IsWritable() const override;
+		/// Return a pointer into the memory area and advance the position. Supported only when constructed from shared memory.
+		std::shared_ptr<const uint8_t> Borrow(size_t numBytes) override;
 
 		/// Return memory area.
 		uint8_t* Data() { return _buffer; }
@@ -63,6 +67,8 @@ namespace Alimer
 		uint8_t* _buffer;
 		/// Read-only flag.
 		bool _readOnly;
+		/// Owner of shared memory.
+		std::shared_ptr<const uint8_t> _owner;
 	};
 
 }
@@ -0,0 +1,163 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Debug/Log.h"
+#include "../Debug/Profiler.h"
+#include "Compression.h"
+#include "MappedFile.h"
+#include "MemoryBuffer.h"
+#include "PackageFile.h"
+
+#include <algorithm>
+using namespace std;
+
+namespace Alimer
+{
+	PackageFile::PackageFile(const string& fileName)
+	{
+		Open(fileName);
+	}
+
+	bool PackageFile::Open(const string& fileName)
+	{
+		ALIMER_PROFILE(OpenPackageFile);
+
+		_data.reset();
+		_entries.clear();
+
+		MappedFile file(fileName);
+		if (!file.IsOpen())
+		{
+			ALIMER_LOGERROR("Could not open package file " + fileName);
+			return false;
+		}
+
+		size_t fileSize = file.Size();
+		if (fileSize < PACKAGE_HEADER_SIZE || file.ReadFileID() != PACKAGE_FILE_ID)
+		{
+			ALIMER_LOGERROR(fileName + " is not a valid package file");
+			return false;
+		}
+
+		uint32_t version = file.ReadUInt();
+		if (version != PACKAGE_FILE_VERSION)
+		{
+			ALIMER_LOGERROR("Unsupported package file version {} in {}", version, fileName);
+			return false;
+		}
+
+		uint32_t numEntries = file.ReadUInt();
+		uint32_t namesSize = file.ReadUInt();
+		size_t namesOffset = PACKAGE_HEADER_SIZE + (size_t)numEntries * PACKAGE_INDEX_ENTRY_SIZE;
+		if (namesOffset + namesSize > fileSize || (numEntries && (!namesSize || file.Data()[namesOffset + namesSize - 1] != 0)))
+		{
+			ALIMER_LOGERROR("Corrupt package file index in " + fileName);
+			return false;
+		}
+
+		const char* names = reinterpret_cast<const char*>(file.Data() + namesOffset);
+		_entries.resize(numEntries);
+
+		for (uint32_t i = 0; i < numEntries; ++i)
+		{
+			PackageEntry& entry = _entries[i];
+			entry.nameHash = StringHash(file.ReadUInt());
+			uint32_t nameOffset = file.ReadUInt();
+			entry.offset = file.ReadUInt64();
+			entry.size = file.ReadUInt();
+			entry.packedSize = file.ReadUInt();
+
+			// The index must be sorted for binary search, and the names and data must lie within the file
+			if (nameOffset >= namesSize || entry.packedSize > entry.size || entry.offset > fileSize || entry.packedSize > fileSize - entry.offset ||
+				(i && entry.nameHash.Value() <= _entries[i - 1].nameHash.Value()))
+			{
+				ALIMER_LOGERROR("Corrupt package file index in " + fileName);
+				_entries.clear();
+				return false;
+			}
+
+			entry.name = names + nameOffset;
+		}
+
+		// Keep the whole mapping alive for the entries
+		file.Seek(0);
+		_data = file.Borrow(fileSize);
+		_name = fileName;
+
+		ALIMER_LOGINFO("Opened package file {} with {} entries", fileName, numEntries);
+		return true;
+	}
+
+	const PackageEntry* PackageFile::GetEntry(const string& name) const
+	{
+		StringHash nameHash(name);
+		auto it = lower_bound(_entries.begin(), _entries.end(), nameHash, [](const PackageEntry& entry, StringHash hash)
+		{
+			return entry.nameHash.Value() < hash.Value();
+		});
+
+		// Verify the name to not confuse a hash collision with a stored file
+		if (it == _entries.end() || it->nameHash != nameHash || str::Compare(it->name, name.c_str(), false))
+			return nullptr;
+
+		return &(*it);
+	}
+
+	unique_ptr<Stream> PackageFile::OpenEntry(const string& name) const
+	{
+		const PackageEntry* entry = GetEntry(name);
+		if (!entry)
+			return nullptr;
+
+		unique_ptr<Stream> ret;
+
+		if (!entry->IsCompressed())
+		{
+			// Share the mapping, so that loaders can borrow the entry data
+			shared_ptr<const uint8_t> data(_data, _data.get() + entry->offset);
+			ret = make_unique<MemoryBuffer>(data, entry->size);
+		}
+		else
+		{
+			shared_ptr<uint8_t> data(new uint8_t[entry->size], default_delete<uint8_t[]>());
+			if (!DecompressData(data.get(), _data.get() + entry->offset, entry->size, entry->packedSize))
+			{
+				ALIMER_LOGERROR("Could not decompress " + name + " from package file " + _name);
+				return nullptr;
+			}
+			ret = make_unique<MemoryBuffer>(shared_ptr<const uint8_t>(data), entry->size);
+		}
+
+		ret->SetName(entry->name);
+		return ret;
+	}
+
+	uint64_t PackageFile::GetTotalSize() const
+	{
+		uint64_t totalSize = 0;
+		for (auto it = _entries.begin(); it != _entries.end(); ++it)
+			totalSize += it->size;
+		return totalSize;
+	}
+}
@@ -0,0 +1,103 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Base/Ptr.h"
+#include "../Base/StringHash.h"
+#include "Stream.h"
+#include <vector>
+
+namespace Alimer
+{
+	/// Package file identifier.
+	static const char PACKAGE_FILE_ID[] = "APAK";
+	/// Package file format version.
+	static const uint32_t PACKAGE_FILE_VERSION = 1;
+	/// Size of the package file header in bytes.
+	static const size_t PACKAGE_HEADER_SIZE = 16;
+	/// Size of a package file index entry in bytes.
+	static const size_t PACKAGE_INDEX_ENTRY_SIZE = 24;
+	/// Alignment in bytes of entry data within a package file.
+	static const uint32_t PACKAGE_DATA_ALIGNMENT = 16;
+
+	/// Description of a file stored in a package.
+	struct ALIMER_API PackageEntry
+	{
+		/// Hash of the sanitized name.
+		StringHash nameHash;
+		/// Sanitized name, pointing into the package data.
+		const char* name;
+		/// Offset of the data from the start of the package file.
+		uint64_t offset;
+		/// Uncompressed size.
+		uint32_t size;
+		/// Stored size. Less than the uncompressed size if the data is LZ4 compressed.
+		uint32_t packedSize;
+
+		/// Return whether the data is compressed.
+		bool IsCompressed() const { return packedSize < size; }
+	};
+
+	/// Read-only archive of resource files, which can be mounted to the resource cache. The file is memory mapped and starts with an index of entries sorted by name hash, so that opening an entry does not touch the filesystem.
+	///
+	/// Layout: file ID, version, number of entries and size of the name block as 32-bit values, followed by the index (32-bit name hash, 32-bit name offset, 64-bit data offset, 32-bit size and 32-bit stored size per entry), the null terminated names and the entry data.
+	class ALIMER_API PackageFile : public RefCounted
+	{
+	public:
+		/// Construct.
+		PackageFile() = default;
+		/// Construct and open.
+		PackageFile(const std::string& fileName);
+
+		/// Open a package file. Return true on success.
+		bool Open(const std::string& fileName);
+		/// Open an entry as a read-only stream. Uncompressed entries can be borrowed without copying. Return null if not found or if decompression fails.
+		std::unique_ptr<Stream> OpenEntry(const std::string& name) const;
+
+		/// Return the package file name.
+		const std::string& GetName() const { return _name; }
+		/// Return whether is open.
+		bool IsOpen() const { return _data != nullptr; }
+		/// Return an entry by sanitized name, or null if not found.
+		const PackageEntry* GetEntry(const std::string& name) const;
+		/// Return whether an entry exists.
+		bool Exists(const std::string& name) const { return GetEntry(name) != nullptr; }
+		/// Return all entries, sorted by name hash.
+		const std::vector<PackageEntry>& GetEntries() const { return _entries; }
+		/// Return number of entries.
+		size_t GetNumEntries() const { return _entries.size(); }
+		/// Return total uncompressed size of the entries.
+		uint64_t GetTotalSize() const;
+
+	private:
+		/// Package file name.
+		std::string _name;
+		/// Memory mapped package data.
+		std::shared_ptr<const uint8_t> _data;
+		/// Entries sorted by name hash.
+		std::vector<PackageEntry> _entries;
+	};
+
+}
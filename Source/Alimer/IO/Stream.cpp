@@ -38,6 +38,11 @@ namespace Alimer
 	{
 	}
 
+	std::shared_ptr<const uint8_t> Stream::Borrow(size_t)
+	{
+		return nullptr;
+	}
+
 	void Stream::SetName(const std::string& newName)
 	{
 		_name = newName;
@@ -210,6 +215,19 @@ namespace Alimer
 		return ret;
 	}
 
+	std::shared_ptr<const uint8_t> Stream::ReadShared(size_t numBytes)
+	{
+		std::shared_ptr<const uint8_t> ret = Borrow(numBytes);
+		if (ret || !numBytes)
+			return ret;
+
+		std::shared_ptr<uint8_t> buffer(new uint8_t[numBytes], std::default_delete<uint8_t[]>());
+		if (Read(buffer.get(), numBytes) != numBytes)
+			return nullptr;
+
+		return buffer;
+	}
+
 	Quaternion Stream::ReadQuaternion()
 	{
 		float data[4];
@@ -26,6 +26,7 @@
 #include "../Base/String.h"
 #include "../Math/Quaternion.h"
 #include "../nlohmann/json.hpp"
+#include <memory>
 
 namespace Alimer
 {
@@ -55,6 +56,8 @@ namespace Alimer
 		virtual bool IsReadable() const = 0;
 		/// Return whether write operations are allowed.
 		virtual bool IsWritable() const = 0;
+		/// Return a pointer to the next bytes without copying and advance the position. Supported by streams whose data is already in memory; the pointer keeps that memory alive. Return null if not supported or not enough data.
+		virtual std::shared_ptr<const uint8_t> Borrow(size_t numBytes);
 
 		/// Change the stream name.
 		void SetName(const std::string& newName);
@@ -96,6 +99,8 @@ namespace Alimer
 		StringHash ReadStringHash();
 		/// Read a byte buffer, with size prepended as a VLE value.
 		std::vector<uint8_t> ReadBuffer();
+		/// Read bytes to shared memory. Borrow the bytes if the stream supports it, otherwise copy to a new buffer. Return null if not enough data.
+		std::shared_ptr<const uint8_t> ReadShared(size_t numBytes);
 
 		/// Read a quaternion.
 		Quaternion ReadQuaternion();
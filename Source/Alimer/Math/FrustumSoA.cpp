@@ -0,0 +1,239 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../AlimerConfig.h"
+#include "FrustumSoA.h"
+
+#if defined(ALIMER_SIMD) && ALIMER_SSE2
+#	include <xmmintrin.h>
+#	if defined(__AVX__)
+#		include <immintrin.h>
+#		define ALIMER_FRUSTUM_AVX
+#	endif
+#	define ALIMER_FRUSTUM_SSE
+#elif defined(ALIMER_SIMD) && ALIMER_NEON
+#	include <arm_neon.h>
+#	define ALIMER_FRUSTUM_NEON
+#endif
+
+namespace Alimer
+{
+	void FrustumSoA::Define(const Frustum& frustum)
+	{
+		for (size_t i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+		{
+			const Plane& plane = frustum.planes[i];
+			normalX[i] = plane.normal.x;
+			normalY[i] = plane.normal.y;
+			normalZ[i] = plane.normal.z;
+			absNormalX[i] = plane.absNormal.x;
+			absNormalY[i] = plane.absNormal.y;
+			absNormalZ[i] = plane.absNormal.z;
+			d[i] = plane.d;
+		}
+	}
+
+	void FrustumSoA::IsInsideFast(const float* minX, const float* minY, const float* minZ, const float* maxX, const float* maxY, const float* maxZ, size_t count, uint8_t* results) const
+	{
+		size_t i = 0;
+
+		// A box is outside if it is behind any plane: the center's distance to the plane is less than the negated
+		// projection of the half size on the absolute plane normal. Each SIMD lane tests one box against all planes
+#ifdef ALIMER_FRUSTUM_AVX
+		{
+			const __m256 half = _mm256_set1_ps(0.5f);
+			const __m256 zero = _mm256_setzero_ps();
+
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 boxMinX = _mm256_loadu_ps(minX + i);
+				__m256 boxMinY = _mm256_loadu_ps(minY + i);
+				__m256 boxMinZ = _mm256_loadu_ps(minZ + i);
+				__m256 boxMaxX = _mm256_loadu_ps(maxX + i);
+				__m256 boxMaxY = _mm256_loadu_ps(maxY + i);
+				__m256 boxMaxZ = _mm256_loadu_ps(maxZ + i);
+				__m256 centerX = _mm256_mul_ps(_mm256_add_ps(boxMinX, boxMaxX), half);
+				__m256 centerY = _mm256_mul_ps(_mm256_add_ps(boxMinY, boxMaxY), half);
+				__m256 centerZ = _mm256_mul_ps(_mm256_add_ps(boxMinZ, boxMaxZ), half);
+				__m256 edgeX = _mm256_mul_ps(_mm256_sub_ps(boxMaxX, boxMinX), half);
+				__m256 edgeY = _mm256_mul_ps(_mm256_sub_ps(boxMaxY, boxMinY), half);
+				__m256 edgeZ = _mm256_mul_ps(_mm256_sub_ps(boxMaxZ, boxMinZ), half);
+				__m256 outside = zero;
+
+				for (size_t j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+				{
+					__m256 dist = _mm256_add_ps(_mm256_add_ps(
+						_mm256_mul_ps(_mm256_set1_ps(normalX[j]), centerX),
+						_mm256_mul_ps(_mm256_set1_ps(normalY[j]), centerY)), _mm256_add_ps(
+						_mm256_mul_ps(_mm256_set1_ps(normalZ[j]), centerZ),
+						_mm256_set1_ps(d[j])));
+					__m256 absDist = _mm256_add_ps(_mm256_add_ps(
+						_mm256_mul_ps(_mm256_set1_ps(absNormalX[j]), edgeX),
+						_mm256_mul_ps(_mm256_set1_ps(absNormalY[j]), edgeY)),
+						_mm256_mul_ps(_mm256_set1_ps(absNormalZ[j]), edgeZ));
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(dist, absDist), zero, _CMP_LT_OQ));
+				}
+
+				int mask = _mm256_movemask_ps(outside);
+				for (size_t k = 0; k < 8; ++k)
+					results[i + k] = (mask & (1 << k)) ? 0 : 1;
+			}
+		}
+#endif
+
+#if defined(ALIMER_FRUSTUM_SSE)
+		{
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128 zero = _mm_setzero_ps();
+
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 boxMinX = _mm_loadu_ps(minX + i);
+				__m128 boxMinY = _mm_loadu_ps(minY + i);
+				__m128 boxMinZ = _mm_loadu_ps(minZ + i);
+				__m128 boxMaxX = _mm_loadu_ps(maxX + i);
+				__m128 boxMaxY = _mm_loadu_ps(maxY + i);
+				__m128 boxMaxZ = _mm_loadu_ps(maxZ + i);
+				__m128 centerX = _mm_mul_ps(_mm_add_ps(boxMinX, boxMaxX), half);
+				__m128 centerY = _mm_mul_ps(_mm_add_ps(boxMinY, boxMaxY), half);
+				__m128 centerZ = _mm_mul_ps(_mm_add_ps(boxMinZ, boxMaxZ), half);
+				__m128 edgeX = _mm_mul_ps(_mm_sub_ps(boxMaxX, boxMinX), half);
+				__m128 edgeY = _mm_mul_ps(_mm_sub_ps(boxMaxY, boxMinY), half);
+				__m128 edgeZ = _mm_mul_ps(_mm_sub_ps(boxMaxZ, boxMinZ), half);
+				__m128 outside = zero;
+
+				for (size_t j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+				{
+					__m128 dist = _mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(_mm_set1_ps(normalX[j]), centerX),
+						_mm_mul_ps(_mm_set1_ps(normalY[j]), centerY)), _mm_add_ps(
+						_mm_mul_ps(_mm_set1_ps(normalZ[j]), centerZ),
+						_mm_set1_ps(d[j])));
+					__m128 absDist = _mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(_mm_set1_ps(absNormalX[j]), edgeX),
+						_mm_mul_ps(_mm_set1_ps(absNormalY[j]), edgeY)),
+						_mm_mul_ps(_mm_set1_ps(absNormalZ[j]), edgeZ));
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, absDist), zero));
+				}
+
+				int mask = _mm_movemask_ps(outside);
+				for (size_t k = 0; k < 4; ++k)
+					results[i + k] = (mask & (1 << k)) ? 0 : 1;
+			}
+		}
+#elif defined(ALIMER_FRUSTUM_NEON)
+		{
+			const float32x4_t half = vdupq_n_f32(0.5f);
+			const float32x4_t zero = vdupq_n_f32(0.0f);
+
+			for (; i + 4 <= count; i += 4)
+			{
+				float32x4_t boxMinX = vld1q_f32(minX + i);
+				float32x4_t boxMinY = vld1q_f32(minY + i);
+				float32x4_t boxMinZ = vld1q_f32(minZ + i);
+				float32x4_t boxMaxX = vld1q_f32(maxX + i);
+				float32x4_t boxMaxY = vld1q_f32(maxY + i);
+				float32x4_t boxMaxZ = vld1q_f32(maxZ + i);
+				float32x4_t centerX = vmulq_f32(vaddq_f32(boxMinX, boxMaxX), half);
+				float32x4_t centerY = vmulq_f32(vaddq_f32(boxMinY, boxMaxY), half);
+				float32x4_t centerZ = vmulq_f32(vaddq_f32(boxMinZ, boxMaxZ), half);
+				float32x4_t edgeX = vmulq_f32(vsubq_f32(boxMaxX, boxMinX), half);
+				float32x4_t edgeY = vmulq_f32(vsubq_f32(boxMaxY, boxMinY), half);
+				float32x4_t edgeZ = vmulq_f32(vsubq_f32(boxMaxZ, boxMinZ), half);
+				uint32x4_t outside = vdupq_n_u32(0);
+
+				for (size_t j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+				{
+					float32x4_t dist = vdupq_n_f32(d[j]);
+					dist = vmlaq_n_f32(dist, centerX, normalX[j]);
+					dist = vmlaq_n_f32(dist, centerY, normalY[j]);
+					dist = vmlaq_n_f32(dist, centerZ, normalZ[j]);
+					dist = vmlaq_n_f32(dist, edgeX, absNormalX[j]);
+					dist = vmlaq_n_f32(dist, edgeY, absNormalY[j]);
+					dist = vmlaq_n_f32(dist, edgeZ, absNormalZ[j]);
+					outside = vorrq_u32(outside, vcltq_f32(dist, zero));
+				}
+
+				uint32_t lanes[4];
+				vst1q_u32(lanes, outside);
+				for (size_t k = 0; k < 4; ++k)
+					results[i + k] = lanes[k] ? 0 : 1;
+			}
+		}
+#endif
+
+		// Scalar path for the remaining boxes
+		for (; i < count; ++i)
+		{
+			float centerX = (minX[i] + maxX[i]) * 0.5f;
+			float centerY = (minY[i] + maxY[i]) * 0.5f;
+			float centerZ = (minZ[i] + maxZ[i]) * 0.5f;
+			float edgeX = (maxX[i] - minX[i]) * 0.5f;
+			float edgeY = (maxY[i] - minY[i]) * 0.5f;
+			float edgeZ = (maxZ[i] - minZ[i]) * 0.5f;
+			uint8_t inside = 1;
+
+			for (size_t j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+			{
+				float dist = normalX[j] * centerX + normalY[j] * centerY + normalZ[j] * centerZ + d[j];
+				float absDist = absNormalX[j] * edgeX + absNormalY[j] * edgeY + absNormalZ[j] * edgeZ;
+				if (dist + absDist < 0.0f)
+				{
+					inside = 0;
+					break;
+				}
+			}
+
+			results[i] = inside;
+		}
+	}
+
+	void FrustumSoA::IsInsideFast(const BoundingBox* boxes, size_t count, uint8_t* results) const
+	{
+		float minX[FRUSTUM_BATCH_SIZE];
+		float minY[FRUSTUM_BATCH_SIZE];
+		float minZ[FRUSTUM_BATCH_SIZE];
+		float maxX[FRUSTUM_BATCH_SIZE];
+		float maxY[FRUSTUM_BATCH_SIZE];
+		float maxZ[FRUSTUM_BATCH_SIZE];
+
+		// Transpose the boxes in batches for the kernel
+		for (size_t i = 0; i < count; i += FRUSTUM_BATCH_SIZE)
+		{
+			size_t batchSize = count - i < FRUSTUM_BATCH_SIZE ? count - i : FRUSTUM_BATCH_SIZE;
+			for (size_t j = 0; j < batchSize; ++j)
+			{
+				const BoundingBox& box = boxes[i + j];
+				minX[j] = box.min.x;
+				minY[j] = box.min.y;
+				minZ[j] = box.min.z;
+				maxX[j] = box.max.x;
+				maxY[j] = box.max.y;
+				maxZ[j] = box.max.z;
+			}
+
+			IsInsideFast(minX, minY, minZ, maxX, maxY, maxZ, batchSize, results + i);
+		}
+	}
+}
@@ -0,0 +1,74 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Frustum.h"
+
+namespace Alimer
+{
+
+/// Number of bounding boxes to test per kernel call when culling large arrays in chunks.
+static const size_t FRUSTUM_BATCH_SIZE = 64;
+
+/// %Frustum planes in structure-of-arrays form, for testing several bounding boxes at once with SSE, AVX or NEON instructions.
+class ALIMER_API FrustumSoA
+{
+public:
+    /// Plane normal X components.
+    float normalX[NUM_FRUSTUM_PLANES];
+    /// Plane normal Y components.
+    float normalY[NUM_FRUSTUM_PLANES];
+    /// Plane normal Z components.
+    float normalZ[NUM_FRUSTUM_PLANES];
+    /// Absolute plane normal X components.
+    float absNormalX[NUM_FRUSTUM_PLANES];
+    /// Absolute plane normal Y components.
+    float absNormalY[NUM_FRUSTUM_PLANES];
+    /// Absolute plane normal Z components.
+    float absNormalZ[NUM_FRUSTUM_PLANES];
+    /// Plane constants.
+    float d[NUM_FRUSTUM_PLANES];
+
+    /// Construct undefined.
+    FrustumSoA()
+    {
+    }
+
+    /// Construct from a frustum.
+    FrustumSoA(const Frustum& frustum)
+    {
+        Define(frustum);
+    }
+
+    /// Define from a frustum.
+    void Define(const Frustum& frustum);
+
+    /// Test bounding boxes given as arrays of min and max coordinates. Write 1 to the results for each box that is (partially) inside and 0 for each box that is outside.
+    void IsInsideFast(const float* minX, const float* minY, const float* minZ, const float* maxX, const float* maxY, const float* maxZ, size_t count, uint8_t* results) const;
+    /// Test an array of bounding boxes. Write 1 to the results for each box that is (partially) inside and 0 for each box that is outside.
+    void IsInsideFast(const BoundingBox* boxes, size_t count, uint8_t* results) const;
+};
+
+}
@@ -25,24 +25,126 @@
 #include "../Graphics/Texture.h"
 #include "Batch.h"
 #include <algorithm>
+#include <cstring>
 
 namespace Alimer
 {
-	inline bool CompareBatchState(Batch& lhs, Batch& rhs)
+	inline bool CompareBatchState(const Batch& lhs, const Batch& rhs)
 	{
 		return lhs.sortKey < rhs.sortKey;
 	}
 
-	inline bool CompareBatchDistanceFrontToBack(Batch& lhs, Batch& rhs)
+	inline bool CompareBatchDistanceFrontToBack(const Batch& lhs, const Batch& rhs)
 	{
 		return lhs.distance < rhs.distance;
 	}
 
-	inline bool CompareBatchDistanceBackToFront(Batch& lhs, Batch& rhs)
+	inline bool CompareBatchDistanceBackToFront(const Batch& lhs, const Batch& rhs)
 	{
 		return lhs.distance > rhs.distance;
 	}
 
+	/// Minimum number of batches to use radix sort for. Smaller vectors use stable comparison sort.
+	static const size_t MIN_RADIX_SORT_BATCHES = 64;
+
+	/// Convert a float to an unsigned integer with the same ordering.
+	inline uint32_t FloatToSortKey(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof bits);
+		// Negative values: flip all bits to reverse their order. Positive values: flip the sign bit to sort them above negatives
+		return bits ^ ((bits & 0x80000000) ? 0xffffffff : 0x80000000);
+	}
+
+	/// Sort batches with a comparison function, optionally preserving the order of equal batches.
+	template <class T> void ComparisonSort(std::vector<Batch>& batches, T compare, bool stable)
+	{
+		if (stable)
+			std::stable_sort(batches.begin(), batches.end(), compare);
+		else
+			std::sort(batches.begin(), batches.end(), compare);
+	}
+
+	/// Sort batches with the comparison function of a sort mode.
+	static void ComparisonSort(std::vector<Batch>& batches, BatchSortMode mode, bool stable)
+	{
+		switch (mode)
+		{
+		case SORT_STATE:
+			ComparisonSort(batches, CompareBatchState, stable);
+			break;
+
+		case SORT_FRONT_TO_BACK:
+			ComparisonSort(batches, CompareBatchDistanceFrontToBack, stable);
+			break;
+
+		case SORT_BACK_TO_FRONT:
+			ComparisonSort(batches, CompareBatchDistanceBackToFront, stable);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	/// Return a radix sort digit of an entry. The lowest digits come from the batch index, so that batches with equal keys are ordered by index.
+	inline uint32_t RadixSortDigit(const BatchSortEntry& entry, size_t digit, size_t indexBytes)
+	{
+		if (digit < indexBytes)
+			return (entry.index >> (digit * 8)) & 0xff;
+		else
+			return (entry.key >> ((digit - indexBytes) * 8)) & 0xff;
+	}
+
+	/// Sort entries by key and then by batch index with least significant digit first radix sort, 8 bits per pass. Passes where all entries have the same digit are skipped.
+	static void RadixSort(std::vector<BatchSortEntry>& entries, std::vector<BatchSortEntry>& buffer, size_t keyBytes)
+	{
+		size_t count = entries.size();
+		buffer.resize(count);
+
+		// Use only as many index digits as the batch count needs
+		size_t indexBytes = 0;
+		for (size_t maxIndex = count - 1; maxIndex; maxIndex >>= 8)
+			++indexBytes;
+		size_t digits = indexBytes + keyBytes;
+
+		// Build the histograms for all passes at once
+		uint32_t histograms[sizeof(uint32_t) + sizeof(uint64_t)][256];
+		memset(histograms, 0, sizeof histograms);
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (size_t j = 0; j < digits; ++j)
+				++histograms[j][RadixSortDigit(entries[i], j, indexBytes)];
+		}
+
+		BatchSortEntry* src = entries.data();
+		BatchSortEntry* dest = buffer.data();
+
+		for (size_t j = 0; j < digits; ++j)
+		{
+			uint32_t* histogram = histograms[j];
+			if (histogram[RadixSortDigit(src[0], j, indexBytes)] == count)
+				continue;
+
+			uint32_t offset = 0;
+			for (size_t k = 0; k < 256; ++k)
+			{
+				uint32_t digitCount = histogram[k];
+				histogram[k] = offset;
+				offset += digitCount;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+				dest[histogram[RadixSortDigit(src[i], j, indexBytes)]++] = src[i];
+
+			std::swap(src, dest);
+		}
+
+		// Make sure the result ends up in the entries vector
+		if (src != entries.data())
+			entries.swap(buffer);
+	}
+
 	void BatchQueue::Clear()
 	{
 		batches.clear();
@@ -54,19 +156,19 @@ namespace Alimer
 		switch (sort)
 		{
 		case SORT_STATE:
-			std::sort(batches.begin(), batches.end(), CompareBatchState);
-			std::sort(additiveBatches.begin(), additiveBatches.end(), CompareBatchState);
+			SortBatches(batches, SORT_STATE);
+			SortBatches(additiveBatches, SORT_STATE);
 			break;
 
 		case SORT_FRONT_TO_BACK:
-			std::sort(batches.begin(), batches.end(), CompareBatchDistanceFrontToBack);
+			SortBatches(batches, SORT_FRONT_TO_BACK);
 			// After drawing the base batches, the Z buffer has been prepared. Additive batches can be sorted per state now
-			std::sort(additiveBatches.begin(), additiveBatches.end(), CompareBatchState);
+			SortBatches(additiveBatches, SORT_STATE);
 			break;
 
 		case SORT_BACK_TO_FRONT:
-			std::sort(batches.begin(), batches.end(), CompareBatchDistanceBackToFront);
-			std::sort(additiveBatches.begin(), additiveBatches.end(), CompareBatchDistanceBackToFront);
+			SortBatches(batches, SORT_BACK_TO_FRONT);
+			SortBatches(additiveBatches, SORT_BACK_TO_FRONT);
 			break;
 
 		default:
@@ -78,6 +180,43 @@ namespace Alimer
 		BuildInstances(additiveBatches, instanceTransforms);
 	}
 
+	void BatchQueue::SortBatches(std::vector<Batch>& batches_, BatchSortMode mode)
+	{
+		if (mode == SORT_NONE)
+			return;
+
+		// Small vectors use stable comparison sort when radix sort is enabled, so that the order does not depend on the batch count
+		size_t count = batches_.size();
+		if (!radixSortModes[mode] || count < MIN_RADIX_SORT_BATCHES)
+		{
+			ComparisonSort(batches_, mode, radixSortModes[mode]);
+			return;
+		}
+
+		ALIMER_PROFILE(RadixSortBatches);
+
+		sortEntries.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Batch& batch = batches_[i];
+			BatchSortEntry& entry = sortEntries[i];
+			if (mode == SORT_STATE)
+				entry.key = batch.sortKey;
+			else if (mode == SORT_FRONT_TO_BACK)
+				entry.key = FloatToSortKey(batch.distance);
+			else
+				entry.key = ~FloatToSortKey(batch.distance);
+			entry.index = static_cast<uint32_t>(i);
+		}
+
+		RadixSort(sortEntries, sortBuffer, mode == SORT_STATE ? sizeof(uint64_t) : sizeof(uint32_t));
+
+		sortedBatches.resize(count);
+		for (size_t i = 0; i < count; ++i)
+			sortedBatches[i] = batches_[sortEntries[i].index];
+		batches_.swap(sortedBatches);
+	}
+
 	void BatchQueue::BuildInstances(std::vector<Batch>& batches, std::vector<Matrix3x4>& instanceTransforms)
 	{
 		Batch* start = nullptr;
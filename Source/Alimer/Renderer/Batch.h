@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "../Base/FrameArena.h"
 #include "../Math/AreaAllocator.h"
 #include "Camera.h"
 #include "GeometryNode.h"
@@ -65,6 +66,15 @@ namespace Alimer
 		};
 	};
 
+	/// Sort key and batch index for radix sorting.
+	struct ALIMER_API BatchSortEntry
+	{
+		/// Sort key.
+		uint64_t key;
+		/// Index of the batch.
+		uint32_t index;
+	};
+
 	/// Per-pass batch queue structure.
 	struct ALIMER_API BatchQueue
 	{
@@ -72,6 +82,13 @@ namespace Alimer
 		void Clear();
 		/// Sort batches and build instances.
 		void Sort(std::vector<Matrix3x4>& instanceTransforms);
+		/// Sort a batch vector according to a sort mode, using radix sort if enabled for the mode.
+		void SortBatches(std::vector<Batch>& batches, BatchSortMode mode);
+
+		/// Set whether to use radix sort for a sort mode. Radix sort orders batches with equal keys by their index, so the result is deterministic. Default true for all modes.
+		void SetRadixSort(BatchSortMode mode, bool enable) { radixSortModes[mode] = enable; }
+		/// Return whether radix sort is used for a sort mode.
+		bool GetRadixSort(BatchSortMode mode) const { return radixSortModes[mode]; }
 
 		/// Build instances from adjacent batches with same state.
 		static void BuildInstances(std::vector<Batch>& batches, std::vector<Matrix3x4>& instanceTransforms);
@@ -88,17 +105,32 @@ namespace Alimer
 		uint8_t baseIndex;
 		/// Additive pass index (if needed.)
 		uint8_t additiveIndex;
+		/// Radix sort enable flags per sort mode.
+		bool radixSortModes[SORT_FRONT_TO_BACK + 1] = { true, true, true, true };
+		/// Radix sort keys.
+		std::vector<BatchSortEntry> sortEntries;
+		/// Radix sort intermediate buffer.
+		std::vector<BatchSortEntry> sortBuffer;
+		/// Sorted batches before swapping them in place.
+		std::vector<Batch> sortedBatches;
 	};
 
 	/// %List of lights for a geometry node.
 	struct ALIMER_API LightList
 	{
+		/// Construct with allocator for the lights and light passes.
+		LightList(const ArenaAllocator<Light*>& allocator = ArenaAllocator<Light*>()) :
+			lights(allocator),
+			lightPasses(allocator)
+		{
+		}
+
 		/// %List key.
 		uint64_t key;
 		/// Lights.
-		std::vector<Light*> lights;
+		std::vector<Light*, ArenaAllocator<Light*> > lights;
 		/// Associated light passes.
-		std::vector<LightPass*> lightPasses;
+		std::vector<LightPass*, ArenaAllocator<LightPass*> > lightPasses;
 		/// Use count
 		size_t useCount;
 	};
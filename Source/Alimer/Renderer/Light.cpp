@@ -314,6 +314,15 @@ namespace Alimer
 		Camera* mainCamera,
 		std::vector<std::unique_ptr<ShadowView>>& shadowViews,
 		size_t& useIndex)
+	{
+		size_t startIndex = useIndex;
+		AllocateShadowViews(shadowViews, useIndex);
+
+		for (size_t i = startIndex; i < useIndex; ++i)
+			SetupShadowView(mainCamera, shadowViews[i].get(), i - startIndex);
+	}
+
+	void Light::AllocateShadowViews(std::vector<std::unique_ptr<ShadowView>>& shadowViews, size_t& useIndex)
 	{
 		size_t numViews = NumShadowViews();
 		if (!numViews)
@@ -322,9 +331,6 @@ namespace Alimer
 		if (shadowViews.size() < useIndex + numViews)
 			shadowViews.resize(useIndex + numViews);
 
-		int numVerticalSplits = (lightType == LIGHT_POINT || (lightType == LIGHT_DIRECTIONAL && NumShadowSplits() > 2)) ? 2 : 1;
-		int actualShadowMapSize = shadowRect.Height() / numVerticalSplits;
-
 		for (size_t i = 0; i < numViews; ++i)
 		{
 			if (!shadowViews[useIndex + i])
@@ -333,163 +339,166 @@ namespace Alimer
 			ShadowView* view = shadowViews[useIndex + i].get();
 			view->Clear();
 			view->light = this;
-			Camera& shadowCamera = view->shadowCamera;
+		}
 
-			switch (lightType)
-			{
-			case LIGHT_DIRECTIONAL:
-			{
-				IntVector2 topLeft(shadowRect.left, shadowRect.top);
-				if (i & 1)
-					topLeft.x += actualShadowMapSize;
-				if (i & 2)
-					topLeft.y += actualShadowMapSize;
-				view->viewport = IntRect(topLeft.x, topLeft.y, topLeft.x + actualShadowMapSize, topLeft.y + actualShadowMapSize);
-
-				float splitStart = Max(mainCamera->NearClip(), (i == 0) ? 0.0f : ShadowSplit(i - 1));
-				float splitEnd = Min(mainCamera->FarClip(), ShadowSplit(i));
-				float extrusionDistance = mainCamera->FarClip();
-
-				// Calculate initial position & rotation
-				shadowCamera.SetTransform(mainCamera->WorldPosition() - extrusionDistance * WorldDirection(), WorldRotation());
-
-				// Calculate main camera shadowed frustum in light's view space
-				Frustum splitFrustum = mainCamera->WorldSplitFrustum(splitStart, splitEnd);
-				const Matrix3x4& lightView = shadowCamera.ViewMatrix();
-				Frustum lightViewFrustum = splitFrustum.Transformed(lightView);
-
-				// Fit the frustum inside a bounding box
-				BoundingBox shadowBox;
-				shadowBox.Define(lightViewFrustum);
-
-				// If shadow camera is far away from the frustum, can bring it closer for better depth precision
-				/// \todo The minimum distance is somewhat arbitrary
-				float minDistance = mainCamera->FarClip() * 0.25f;
-				if (shadowBox.min.z > minDistance)
-				{
-					float move = shadowBox.min.z - minDistance;
-					shadowCamera.Translate(Vector3(0.0f, 0.f, move));
-					shadowBox.min.z -= move,
-						shadowBox.max.z -= move;
-				}
-
-				shadowCamera.SetOrthographic(true);
-				shadowCamera.SetFarClip(shadowBox.max.z);
-
-				Vector3 center = shadowBox.Center();
-				Vector3 size = shadowBox.Size();
-				shadowCamera.SetOrthoSize(Vector2(size.x, size.y));
-				shadowCamera.SetZoom(1.0f);
-
-				// Center shadow camera to the view space bounding box
-				Vector3 pos(shadowCamera.WorldPosition());
-				Quaternion rot(shadowCamera.WorldRotation());
-				Vector3 adjust(center.x, center.y, 0.0f);
-				shadowCamera.Translate(rot * adjust, TS_WORLD);
-
-				// Snap to whole texels
-				{
-					Vector3 viewPos(rot.Inverse() * shadowCamera.WorldPosition());
-					float invSize = 1.0f / actualShadowMapSize;
-					Vector2 texelSize(size.x * invSize, size.y * invSize);
-					Vector3 snap(-fmodf(viewPos.x, texelSize.x), -fmodf(viewPos.y, texelSize.y), 0.0f);
-					shadowCamera.Translate(rot * snap, TS_WORLD);
-				}
-			}
-			break;
+		// Point lights use an extra constant instead of shadow matrices
+		if (lightType != LIGHT_POINT)
+			shadowMatrices.resize(numViews);
+		else
+			shadowMatrices.clear();
 
-			case LIGHT_POINT:
+		useIndex += numViews;
+	}
+
+	void Light::SetupShadowView(Camera* mainCamera, ShadowView* view, size_t i)
+	{
+		int numVerticalSplits = (lightType == LIGHT_POINT || (lightType == LIGHT_DIRECTIONAL && NumShadowSplits() > 2)) ? 2 : 1;
+		int actualShadowMapSize = shadowRect.Height() / numVerticalSplits;
+		Camera& shadowCamera = view->shadowCamera;
+
+		switch (lightType)
+		{
+		case LIGHT_DIRECTIONAL:
+		{
+			IntVector2 topLeft(shadowRect.left, shadowRect.top);
+			if (i & 1)
+				topLeft.x += actualShadowMapSize;
+			if (i & 2)
+				topLeft.y += actualShadowMapSize;
+			view->viewport = IntRect(topLeft.x, topLeft.y, topLeft.x + actualShadowMapSize, topLeft.y + actualShadowMapSize);
+
+			float splitStart = Max(mainCamera->NearClip(), (i == 0) ? 0.0f : ShadowSplit(i - 1));
+			float splitEnd = Min(mainCamera->FarClip(), ShadowSplit(i));
+			float extrusionDistance = mainCamera->FarClip();
+
+			// Calculate initial position & rotation
+			shadowCamera.SetTransform(mainCamera->WorldPosition() - extrusionDistance * WorldDirection(), WorldRotation());
+
+			// Calculate main camera shadowed frustum in light's view space
+			Frustum splitFrustum = mainCamera->WorldSplitFrustum(splitStart, splitEnd);
+			const Matrix3x4& lightView = shadowCamera.ViewMatrix();
+			Frustum lightViewFrustum = splitFrustum.Transformed(lightView);
+
+			// Fit the frustum inside a bounding box
+			BoundingBox shadowBox;
+			shadowBox.Define(lightViewFrustum);
+
+			// If shadow camera is far away from the frustum, can bring it closer for better depth precision
+			/// \todo The minimum distance is somewhat arbitrary
+			float minDistance = mainCamera->FarClip() * 0.25f;
+			if (shadowBox.min.z > minDistance)
 			{
-				static const Quaternion pointLightFaceRotations[] = {
-					Quaternion(0.0f, 90.0f, 0.0f),
-					Quaternion(0.0f, -90.0f, 0.0f),
-					Quaternion(-90.0f, 0.0f, 0.0f),
-					Quaternion(90.0f, 0.0f, 0.0f),
-					Quaternion(0.0f, 0.0f, 0.0f),
-					Quaternion(0.0f, 180.0f, 0.0f)
-				};
-
-				IntVector2 topLeft(shadowRect.left, shadowRect.top);
-				if (i & 1)
-					topLeft.y += actualShadowMapSize;
-				topLeft.x += ((unsigned)i >> 1) * actualShadowMapSize;
-				view->viewport = IntRect(topLeft.x, topLeft.y, topLeft.x + actualShadowMapSize, topLeft.y + actualShadowMapSize);
-
-				shadowCamera.SetTransform(WorldPosition(), pointLightFaceRotations[i]);
-				shadowCamera.SetFov(90.0f);
-				// Adjust zoom to avoid edge sampling artifacts (there is a matching adjustment in the shadow sampling)
-				shadowCamera.SetZoom(0.99f);
-				shadowCamera.SetFarClip(Range());
-				shadowCamera.SetNearClip(Range() * 0.01f);
-				shadowCamera.SetOrthographic(false);
-				shadowCamera.SetAspectRatio(1.0f);
+				float move = shadowBox.min.z - minDistance;
+				shadowCamera.Translate(Vector3(0.0f, 0.f, move));
+				shadowBox.min.z -= move,
+					shadowBox.max.z -= move;
 			}
-			break;
 
-			case LIGHT_SPOT:
-				view->viewport = shadowRect;
-				shadowCamera.SetTransform(WorldPosition(), WorldRotation());
-				shadowCamera.SetFov(fov);
-				shadowCamera.SetZoom(1.0f);
-				shadowCamera.SetFarClip(Range());
-				shadowCamera.SetNearClip(Range() * 0.01f);
-				shadowCamera.SetOrthographic(false);
-				shadowCamera.SetAspectRatio(1.0f);
-				break;
+			shadowCamera.SetOrthographic(true);
+			shadowCamera.SetFarClip(shadowBox.max.z);
+
+			Vector3 center = shadowBox.Center();
+			Vector3 size = shadowBox.Size();
+			shadowCamera.SetOrthoSize(Vector2(size.x, size.y));
+			shadowCamera.SetZoom(1.0f);
+
+			// Center shadow camera to the view space bounding box
+			Vector3 pos(shadowCamera.WorldPosition());
+			Quaternion rot(shadowCamera.WorldRotation());
+			Vector3 adjust(center.x, center.y, 0.0f);
+			shadowCamera.Translate(rot * adjust, TS_WORLD);
+
+			// Snap to whole texels
+			{
+				Vector3 viewPos(rot.Inverse() * shadowCamera.WorldPosition());
+				float invSize = 1.0f / actualShadowMapSize;
+				Vector2 texelSize(size.x * invSize, size.y * invSize);
+				Vector3 snap(-fmodf(viewPos.x, texelSize.x), -fmodf(viewPos.y, texelSize.y), 0.0f);
+				shadowCamera.Translate(rot * snap, TS_WORLD);
 			}
 		}
+		break;
 
-		// Setup shadow matrices now as camera positions have been finalized
-		if (lightType != LIGHT_POINT)
+		case LIGHT_POINT:
 		{
-			shadowMatrices.resize(numViews);
+			static const Quaternion pointLightFaceRotations[] = {
+				Quaternion(0.0f, 90.0f, 0.0f),
+				Quaternion(0.0f, -90.0f, 0.0f),
+				Quaternion(-90.0f, 0.0f, 0.0f),
+				Quaternion(90.0f, 0.0f, 0.0f),
+				Quaternion(0.0f, 0.0f, 0.0f),
+				Quaternion(0.0f, 180.0f, 0.0f)
+			};
+
+			IntVector2 topLeft(shadowRect.left, shadowRect.top);
+			if (i & 1)
+				topLeft.y += actualShadowMapSize;
+			topLeft.x += ((unsigned)i >> 1) * actualShadowMapSize;
+			view->viewport = IntRect(topLeft.x, topLeft.y, topLeft.x + actualShadowMapSize, topLeft.y + actualShadowMapSize);
+
+			shadowCamera.SetTransform(WorldPosition(), pointLightFaceRotations[i]);
+			shadowCamera.SetFov(90.0f);
+			// Adjust zoom to avoid edge sampling artifacts (there is a matching adjustment in the shadow sampling)
+			shadowCamera.SetZoom(0.99f);
+			shadowCamera.SetFarClip(Range());
+			shadowCamera.SetNearClip(Range() * 0.01f);
+			shadowCamera.SetOrthographic(false);
+			shadowCamera.SetAspectRatio(1.0f);
+		}
+		break;
 
-			for (size_t i = 0; i < numViews; ++i)
-			{
-				ShadowView* view = shadowViews[useIndex + i].get();
+		case LIGHT_SPOT:
+			view->viewport = shadowRect;
+			shadowCamera.SetTransform(WorldPosition(), WorldRotation());
+			shadowCamera.SetFov(fov);
+			shadowCamera.SetZoom(1.0f);
+			shadowCamera.SetFarClip(Range());
+			shadowCamera.SetNearClip(Range() * 0.01f);
+			shadowCamera.SetOrthographic(false);
+			shadowCamera.SetAspectRatio(1.0f);
+			break;
+		}
 
-				Camera& shadowCamera = view->shadowCamera;
-				float width = (float)shadowMap->GetWidth();
-				float height = (float)shadowMap->GetHeight();
-				Vector3 offset((float)view->viewport.left / width, (float)view->viewport.top / height, 0.0f);
-				Vector3 scale(0.5f * (float)view->viewport.Width() / width, 0.5f * (float)view->viewport.Height() / height, 1.0f);
+		// Setup shadow matrix now as camera position has been finalized
+		if (lightType != LIGHT_POINT)
+		{
+			float width = (float)shadowMap->GetWidth();
+			float height = (float)shadowMap->GetHeight();
+			Vector3 offset((float)view->viewport.left / width, (float)view->viewport.top / height, 0.0f);
+			Vector3 scale(0.5f * (float)view->viewport.Width() / width, 0.5f * (float)view->viewport.Height() / height, 1.0f);
 
-				offset.x += scale.x;
-				offset.y += scale.y;
-				scale.y = -scale.y;
+			offset.x += scale.x;
+			offset.y += scale.y;
+			scale.y = -scale.y;
 
-				// OpenGL has different depth range
+			// OpenGL has different depth range
 #ifdef ALIMER_OPENGL
-				offset.z = 0.5f;
-				scale.z = 0.5f;
+			offset.z = 0.5f;
+			scale.z = 0.5f;
 #endif
 
-				Matrix4 texAdjust(Matrix4::IDENTITY);
-				texAdjust.SetTranslation(offset);
-				texAdjust.SetScale(scale);
+			Matrix4 texAdjust(Matrix4::IDENTITY);
+			texAdjust.SetTranslation(offset);
+			texAdjust.SetScale(scale);
 
-				shadowMatrices[i] = texAdjust * shadowCamera.ProjectionMatrix() * shadowCamera.ViewMatrix();
-			}
+			shadowMatrices[i] = texAdjust * shadowCamera.ProjectionMatrix() * shadowCamera.ViewMatrix();
 		}
-		else
+		else if (i == 0)
 		{
-			// Point lights use an extra constant instead
-			shadowMatrices.clear();
-
 			Vector2 textureSize((float)shadowMap->GetWidth(), (float)shadowMap->GetHeight());
 			pointShadowParameters = Vector4(actualShadowMapSize / textureSize.x, actualShadowMapSize / textureSize.y,
 				(float)shadowRect.left / textureSize.x, (float)shadowRect.top / textureSize.y);
 		}
 
-		// Calculate shadow mapping constants
-		Camera& shadowCamera = shadowViews[useIndex]->shadowCamera;
-		float nearClip = shadowCamera.NearClip();
-		float farClip = shadowCamera.FarClip();
-		float q = farClip / (farClip - nearClip);
-		float r = -q * nearClip;
-		shadowParameters = Vector4(0.5f / (float)shadowMap->GetWidth(), 0.5f / (float)shadowMap->GetHeight(), q, r);
-
-		useIndex += numViews;
+		// Calculate shadow mapping constants from the first view
+		if (i == 0)
+		{
+			float nearClip = shadowCamera.NearClip();
+			float farClip = shadowCamera.FarClip();
+			float q = farClip / (farClip - nearClip);
+			float r = -q * nearClip;
+			shadowParameters = Vector4(0.5f / (float)shadowMap->GetWidth(), 0.5f / (float)shadowMap->GetHeight(), q, r);
+		}
 	}
 
 	void Light::OnWorldBoundingBoxUpdate() const
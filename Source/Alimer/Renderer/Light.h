@@ -107,6 +107,10 @@ namespace Alimer
 			Camera* mainCamera,
 			std::vector<std::unique_ptr<ShadowView>>& shadowViews,
 			size_t& useIndex);
+		/// Reserve and clear shadow views for the light, starting from useIndex, and advance the index. Called by Renderer.
+		void AllocateShadowViews(std::vector<std::unique_ptr<ShadowView>>& shadowViews, size_t& useIndex);
+		/// Setup the shadow camera, viewport and shadow matrix of one allocated view. Views of the same light can be setup in parallel. Called by Renderer.
+		void SetupShadowView(Camera* mainCamera, ShadowView* view, size_t index);
 
 		/// Return shadow map.
 		Texture* ShadowMap() const { return shadowMap; }
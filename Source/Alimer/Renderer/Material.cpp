@@ -172,6 +172,16 @@ namespace Alimer
 		OnShadersChanged();
 	}
 
+	std::string Pass::GetShaderFileName(const std::string& name, ShaderStage stage)
+	{
+		// Use different extensions for GLSL & HLSL shaders
+#ifdef ALIMER_OPENGL
+		return name + (stage == ShaderStage::Vertex ? ".vert" : ".frag");
+#else
+		return name + (stage == ShaderStage::Vertex ? ".vs" : ".ps");
+#endif
+	}
+
 	void Pass::Reset()
 	{
 		depthFunc = CMP_LESS_EQUAL;
@@ -248,6 +258,32 @@ namespace Alimer
 		if (root.count("psDefines"))
 			_shaderDefines[static_cast<uint32_t>(ShaderStage::Fragment)] = root["psDefines"].get<string>();
 
+		// When loading in the background, load the textures and pass shaders in parallel. EndLoad() is delayed until they
+		// have finished, so that the renderer finds the shaders already in the cache
+		if (IsBackgroundLoading())
+		{
+			ResourceCache* cache = GetSubsystem<ResourceCache>();
+			if (root.count("textures") && root["textures"].is_object())
+			{
+				const json& jsonTextures = root["textures"];
+				for (auto it = jsonTextures.begin(); it != jsonTextures.end(); ++it)
+					cache->BackgroundLoadResource<Texture>(it.value().get<string>(), this);
+			}
+
+			if (root.count("passes") && root["passes"].is_object())
+			{
+				const json& jsonPasses = root["passes"];
+				for (auto it = jsonPasses.begin(); it != jsonPasses.end(); ++it)
+				{
+					const json& jsonPass = it.value();
+					if (jsonPass.count("vs"))
+						cache->BackgroundLoadResource<Shader>(Pass::GetShaderFileName(jsonPass["vs"].get<string>(), ShaderStage::Vertex), this);
+					if (jsonPass.count("ps"))
+						cache->BackgroundLoadResource<Shader>(Pass::GetShaderFileName(jsonPass["ps"].get<string>(), ShaderStage::Fragment), this);
+				}
+			}
+		}
+
 		return true;
 	}
 
@@ -282,7 +318,6 @@ namespace Alimer
 			constantBuffers[static_cast<uint32_t>(ShaderStage::Fragment)]->LoadJSON(root["psConstantBuffer"]);
 		}
 
-		/// \todo Queue texture loads during BeginLoad()
 		ResetTextures();
 		if (root.count("textures")
 			&& root["textures"].is_object())
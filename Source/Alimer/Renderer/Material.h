@@ -69,6 +69,8 @@ namespace Alimer
 		const std::string& GetShaderName(ShaderStage stage) const { return _shaderNames[static_cast<unsigned>(stage)]; }
 		/// Return shader defines by stage.
 		const std::string& GetShaderDefines(ShaderStage stage) const { return _shaderDefines[static_cast<unsigned>(stage)]; }
+		/// Return the shader resource file name for a shader name and stage, using the extension of the graphics backend.
+		static std::string GetShaderFileName(const std::string& name, ShaderStage stage);
 		/// Return combined shader defines from the material and pass by stage.
 		const std::string& GetCombinedShaderDefines(ShaderStage stage) const { return _combinedShaderDefines[static_cast<unsigned>(stage)]; }
 		/// Return shader hash value for state sorting.
@@ -29,6 +29,9 @@
 #include "GeometryNode.h"
 #include "Material.h"
 #include "Model.h"
+#include "ModelFormat.h"
+
+#include <cstring>
 
 namespace Alimer
 {
@@ -62,6 +65,20 @@ namespace Alimer
 		RegisterFactory<Model>();
 	}
 
+	static_assert(sizeof(GeometryDesc) == 24, "GeometryDesc must match the model file LOD level layout");
+
+	/// Vertex formats by legacy vertex element type. Integer elements are not supported. The legacy semantics match ModelFileSemantic.
+	static const VertexFormat legacyVertexFormats[] =
+	{
+		VertexFormat::Count,
+		VertexFormat::Float,
+		VertexFormat::Float2,
+		VertexFormat::Float3,
+		VertexFormat::Float4,
+		VertexFormat::UByte4,
+		VertexFormat::UByte4N
+	};
+
 	static Quaternion ReadQuaternionUrho(Stream& source)
 	{
 		float data[4];
@@ -69,23 +86,223 @@ namespace Alimer
 		return Quaternion(data[1], data[2], data[3], data[0]);
 	}
 
+	/// Read an aligned block of records from a model file. Return false if the file is too short.
+	template <class T> static bool ReadModelFileBlock(Stream& source, std::vector<T>& dest, size_t count)
+	{
+		source.Seek(static_cast<size_t>(AlignModelFileOffset(source.Position())));
+		if ((uint64_t)count * sizeof(T) > source.Size() - source.Position())
+			return false;
+
+		dest.resize(count);
+		return source.Read(dest.data(), count * sizeof(T)) == count * sizeof(T);
+	}
+
+	/// Read vertex or index data from a model file, borrowing it if the stream supports it. Return null if out of range.
+	static std::shared_ptr<const uint8_t> ReadModelFileData(Stream& source, uint64_t offset, uint64_t size)
+	{
+		if (offset > source.Size() || size > source.Size() - offset)
+			return nullptr;
+
+		source.Seek(static_cast<size_t>(offset));
+		return source.ReadShared(static_cast<size_t>(size));
+	}
+
 	bool Model::BeginLoad(Stream& source)
 	{
-		/// \todo Develop own format for Alimer
 		std::string fileID = source.ReadFileID();
 
-		if (fileID != "UMDL"
-			&& fileID != "UMD2")
+		vbDescs.clear();
+		ibDescs.clear();
+		geomDescs.clear();
+
+		if (fileID == MODEL_FILE_ID)
+			return BeginLoadNative(source);
+		if (fileID == "UMDL" || fileID == "UMD2")
+			return BeginLoadLegacy(source, fileID == "UMD2");
+
+		ALIMER_LOGERROR(source.GetName() + " is not a valid model file");
+		return false;
+	}
+
+	bool Model::BeginLoadNative(Stream& source)
+	{
+		ModelFileHeader header;
+		memcpy(header.fileID, MODEL_FILE_ID, sizeof header.fileID);
+		const size_t headerRemaining = sizeof header - sizeof header.fileID;
+		if (source.Read(&header.version, headerRemaining) != headerRemaining)
+		{
+			ALIMER_LOGERROR("Truncated model file " + source.GetName());
+			return false;
+		}
+		if (header.version != MODEL_FILE_VERSION)
+		{
+			ALIMER_LOGERROR("Unsupported model file version {} in {}", header.version, source.GetName());
+			return false;
+		}
+
+		// The descriptor blocks are read in bulk, then the vertex and index data by offset
+		std::vector<ModelFileVertexBuffer> vertexBuffers;
+		std::vector<ModelFileVertexElement> vertexElements;
+		std::vector<ModelFileIndexBuffer> indexBuffers;
+		std::vector<ModelFileGeometry> geometryRecords;
+		std::vector<GeometryDesc> lodLevels;
+		std::vector<uint32_t> boneMappingIndices;
+		std::vector<ModelFileBone> boneRecords;
+		std::vector<char> boneNames;
+
+		if (!ReadModelFileBlock(source, vertexBuffers, header.numVertexBuffers) ||
+			!ReadModelFileBlock(source, vertexElements, header.numVertexElements) ||
+			!ReadModelFileBlock(source, indexBuffers, header.numIndexBuffers) ||
+			!ReadModelFileBlock(source, geometryRecords, header.numGeometries) ||
+			!ReadModelFileBlock(source, lodLevels, header.numLodLevels) ||
+			!ReadModelFileBlock(source, boneMappingIndices, header.numBoneMappings) ||
+			!ReadModelFileBlock(source, boneRecords, header.numBones) ||
+			!ReadModelFileBlock(source, boneNames, header.boneNamesSize))
 		{
-			ALIMER_LOGERROR(source.GetName() + " is not a valid model file");
+			ALIMER_LOGERROR("Truncated model file " + source.GetName());
 			return false;
 		}
 
-		const bool hasVertexDeclarations = (fileID == "UMD2");
+		uint64_t memoryUse = 0;
 
-		vbDescs.clear();
-		ibDescs.clear();
-		geomDescs.clear();
+		vbDescs.resize(vertexBuffers.size());
+		for (size_t i = 0; i < vertexBuffers.size(); ++i)
+		{
+			const ModelFileVertexBuffer& record = vertexBuffers[i];
+			VertexBufferDesc& vbDesc = vbDescs[i];
+
+			if ((uint64_t)record.firstElement + record.numElements > vertexElements.size())
+			{
+				ALIMER_LOGERROR("Out of range vertex elements in " + source.GetName());
+				return false;
+			}
+
+			uint32_t vertexSize = 0;
+			for (uint32_t j = record.firstElement; j < record.firstElement + record.numElements; ++j)
+			{
+				const ModelFileVertexElement& element = vertexElements[j];
+				if (element.semantic >= ModelFileSemantic::Count || element.format >= static_cast<uint8_t>(VertexFormat::Count))
+				{
+					ALIMER_LOGERROR("Unknown vertex element in " + source.GetName());
+					return false;
+				}
+
+				VertexFormat format = static_cast<VertexFormat>(element.format);
+				vbDesc.vertexElements.push_back(VertexElement(format, modelFileSemantics[static_cast<size_t>(element.semantic)], element.semanticIndex, element.offset));
+				vertexSize += GetVertexFormatSize(format);
+			}
+
+			if (vertexSize != record.vertexSize)
+			{
+				ALIMER_LOGERROR("Vertex size mismatch in " + source.GetName());
+				return false;
+			}
+
+			vbDesc.vertexCount = record.vertexCount;
+			uint64_t dataSize = (uint64_t)record.vertexCount * record.vertexSize;
+			vbDesc.vertexData = ReadModelFileData(source, record.dataOffset, dataSize);
+			if (!vbDesc.vertexData)
+			{
+				ALIMER_LOGERROR("Could not read vertex data from " + source.GetName());
+				return false;
+			}
+			memoryUse += dataSize;
+		}
+
+		ibDescs.resize(indexBuffers.size());
+		for (size_t i = 0; i < indexBuffers.size(); ++i)
+		{
+			const ModelFileIndexBuffer& record = indexBuffers[i];
+			IndexBufferDesc& ibDesc = ibDescs[i];
+
+			if (record.indexSize != 2 && record.indexSize != 4)
+			{
+				ALIMER_LOGERROR("Unsupported index size in " + source.GetName());
+				return false;
+			}
+
+			ibDesc.indexCount = record.indexCount;
+			ibDesc.indexType = record.indexSize == 2 ? IndexType::UInt16 : IndexType::UInt32;
+			uint64_t dataSize = (uint64_t)record.indexCount * record.indexSize;
+			ibDesc.indexData = ReadModelFileData(source, record.dataOffset, dataSize);
+			if (!ibDesc.indexData)
+			{
+				ALIMER_LOGERROR("Could not read index data from " + source.GetName());
+				return false;
+			}
+			memoryUse += dataSize;
+		}
+
+		geomDescs.resize(geometryRecords.size());
+		boneMappings.resize(geometryRecords.size());
+		for (size_t i = 0; i < geometryRecords.size(); ++i)
+		{
+			const ModelFileGeometry& record = geometryRecords[i];
+			if ((uint64_t)record.firstLodLevel + record.numLodLevels > lodLevels.size() ||
+				(uint64_t)record.firstBoneMapping + record.numBoneMappings > boneMappingIndices.size())
+			{
+				ALIMER_LOGERROR("Out of range geometry data in " + source.GetName());
+				return false;
+			}
+
+			geomDescs[i].assign(lodLevels.begin() + record.firstLodLevel, lodLevels.begin() + record.firstLodLevel + record.numLodLevels);
+			for (auto it = geomDescs[i].begin(); it != geomDescs[i].end(); ++it)
+			{
+				// Check the raw value, as it may not be a valid enum value
+				uint32_t primitiveType;
+				memcpy(&primitiveType, &it->primitiveType, sizeof primitiveType);
+				if (primitiveType < POINT_LIST || primitiveType >= MAX_PRIMITIVE_TYPES)
+				{
+					ALIMER_LOGERROR("Unknown primitive type in " + source.GetName());
+					return false;
+				}
+			}
+
+			boneMappings[i].assign(boneMappingIndices.begin() + record.firstBoneMapping, boneMappingIndices.begin() + record.firstBoneMapping + record.numBoneMappings);
+		}
+
+		if (boneNames.size() && boneNames.back() != 0)
+		{
+			ALIMER_LOGERROR("Corrupt bone names in " + source.GetName());
+			return false;
+		}
+
+		bones.resize(boneRecords.size());
+		rootBoneIndex = 0;
+		for (size_t i = 0; i < boneRecords.size(); ++i)
+		{
+			const ModelFileBone& record = boneRecords[i];
+			Bone& bone = bones[i];
+
+			if (record.nameOffset >= boneNames.size() || record.parentIndex >= boneRecords.size())
+			{
+				ALIMER_LOGERROR("Corrupt bone data in " + source.GetName());
+				return false;
+			}
+
+			bone.name = &boneNames[record.nameOffset];
+			bone.parentIndex = record.parentIndex;
+			bone.initialPosition = Vector3(record.initialPosition);
+			bone.initialRotation = Quaternion(record.initialRotation);
+			bone.initialScale = Vector3(record.initialScale);
+			bone.offsetMatrix = Matrix3x4(record.offsetMatrix);
+			bone.radius = record.radius;
+			bone.boundingBox = BoundingBox(Vector3(&record.boundingBox[0]), Vector3(&record.boundingBox[3]));
+
+			if (bone.parentIndex == i)
+				rootBoneIndex = i;
+		}
+
+		boundingBox = BoundingBox(Vector3(&header.boundingBox[0]), Vector3(&header.boundingBox[3]));
+
+		SetMemoryUse(0, memoryUse);
+		return true;
+	}
+
+	bool Model::BeginLoadLegacy(Stream& source, bool hasVertexDeclarations)
+	{
+		// The vertex and index data is uploaded to GPU buffers in EndLoad()
+		uint64_t memoryUse = 0;
 
 		uint32_t numVertexBuffers = source.ReadUInt();
 		vbDescs.resize(numVertexBuffers);
@@ -94,11 +311,38 @@ namespace Alimer
 			VertexBufferDesc& vbDesc = vbDescs[i];
 
 			vbDesc.vertexCount = source.ReadUInt();
-			uint32_t elementMask = source.ReadUInt();
+
+			size_t vertexSize = 0;
+			uint32_t elementMask = 0;
+			if (hasVertexDeclarations)
+			{
+				// UMD2 files list the elements with their type, semantic and semantic index packed in one value
+				uint32_t numElements = source.ReadUInt();
+				for (uint32_t j = 0; j < numElements; ++j)
+				{
+					uint32_t desc = source.ReadUInt();
+					uint32_t type = desc & 0xff;
+					uint32_t semantic = (desc >> 8) & 0xff;
+					uint32_t semanticIndex = (desc >> 16) & 0xff;
+
+					if (type >= sizeof(legacyVertexFormats) / sizeof(legacyVertexFormats[0]) || legacyVertexFormats[type] == VertexFormat::Count ||
+						semantic >= static_cast<uint32_t>(ModelFileSemantic::Count))
+					{
+						ALIMER_LOGERROR("Unsupported vertex element in " + source.GetName());
+						return false;
+					}
+
+					VertexFormat format = legacyVertexFormats[type];
+					vbDesc.vertexElements.push_back(VertexElement(format, modelFileSemantics[semantic], semanticIndex));
+					vertexSize += GetVertexFormatSize(format);
+				}
+			}
+			else
+				elementMask = source.ReadUInt();
+
 			source.ReadUInt(); // morphRangeStart
 			source.ReadUInt(); // morphRangeCount
 
-			size_t vertexSize = 0;
 			if (elementMask & 1)
 			{
 				vbDesc.vertexElements.push_back(VertexElement(VertexFormat::Float3, VertexElementSemantic::POSITION));
@@ -150,10 +394,14 @@ namespace Alimer
 				vertexSize += 4;
 			}
 
-			vbDesc.vertexData.reset(new uint8_t[vbDesc.vertexCount * vertexSize]);
-			source.Read(
-				vbDesc.vertexData.get(), 
-				vbDesc.vertexCount * vertexSize);
+			// Borrowed from the file without copying if it is memory mapped
+			vbDesc.vertexData = source.ReadShared(vbDesc.vertexCount * vertexSize);
+			if (!vbDesc.vertexData)
+			{
+				ALIMER_LOGERROR("Could not read vertex data from " + source.GetName());
+				return false;
+			}
+			memoryUse += vbDesc.vertexCount * vertexSize;
 		}
 
 		uint32_t numIndexBuffers = source.ReadUInt();
@@ -165,8 +413,13 @@ namespace Alimer
 			ibDesc.indexCount = source.ReadUInt();
 			uint32_t indexSize = source.ReadUInt();
 			ibDesc.indexType = indexSize == 2 ? IndexType::UInt16 : IndexType::UInt32;
-			ibDesc.indexData.reset(new uint8_t[ibDesc.indexCount * indexSize]);
-			source.Read(ibDesc.indexData.get(), ibDesc.indexCount * indexSize);
+			ibDesc.indexData = source.ReadShared(ibDesc.indexCount * indexSize);
+			if (!ibDesc.indexData)
+			{
+				ALIMER_LOGERROR("Could not read index data from " + source.GetName());
+				return false;
+			}
+			memoryUse += ibDesc.indexCount * indexSize;
 		}
 
 		size_t numGeometries = source.ReadUInt();
@@ -236,11 +489,30 @@ namespace Alimer
 		// Read bounding box
 		boundingBox = source.Read<BoundingBox>();
 
+		SetMemoryUse(0, memoryUse);
 		return true;
 	}
 
 	bool Model::EndLoad()
 	{
+		// Reject geometries that would draw past the end of their index buffer before creating any GPU buffers
+		for (size_t i = 0; i < geomDescs.size(); ++i)
+		{
+			for (size_t j = 0; j < geomDescs[i].size(); ++j)
+			{
+				const GeometryDesc& geomDesc = geomDescs[i][j];
+				if (geomDesc.ibRef < ibDescs.size() &&
+					(uint64_t)geomDesc.drawStart + geomDesc.drawCount > ibDescs[geomDesc.ibRef].indexCount)
+				{
+					ALIMER_LOGERROR("Geometry {} LOD level {} draws past the end of its index buffer in {}", i, j, GetName());
+					vbDescs.clear();
+					ibDescs.clear();
+					geomDescs.clear();
+					return false;
+				}
+			}
+		}
+
 		std::vector<SharedPtr<VertexBuffer> > vbs;
 		for (size_t i = 0; i < vbDescs.size(); ++i)
 		{
@@ -4,11 +4,14 @@
 
 #include "../Graphics/GraphicsDefs.h"
 #include "../Math/BoundingBox.h"
+#include "../Math/Matrix3x4.h"
+#include "../Math/Quaternion.h"
 #include "../Resource/Resource.h"
 
 namespace Alimer
 {
 
+	class Node;
 	class VertexBuffer;
 	class IndexBuffer;
 	struct Geometry;
@@ -21,7 +24,7 @@ namespace Alimer
 		/// Number of vertices.
 		uint32_t vertexCount;
 		/// Vertex data.
-		std::unique_ptr<uint8_t[]> vertexData;
+		std::shared_ptr<const uint8_t> vertexData;
 	};
 
 	/// Load-time description of an index buffer, to be uploaded on the GPU later.
@@ -32,7 +35,7 @@ namespace Alimer
 		/// Number of indices.
 		uint32_t indexCount;
 		/// Index data.
-		std::unique_ptr<uint8_t[]> indexData;
+		std::shared_ptr<const uint8_t> indexData;
 	};
 
 	/// Load-time description of a geometry.
@@ -129,8 +132,19 @@ namespace Alimer
 		size_t RootBoneIndex() const { return rootBoneIndex; }
 		/// Return per-geometry bone mapping.
 		const std::vector<std::vector<size_t>> GetBoneMappings() const { return boneMappings; }
+		/// Return vertex buffer descriptions. Valid between BeginLoad() and EndLoad().
+		const std::vector<VertexBufferDesc>& GetVertexBufferDescs() const { return vbDescs; }
+		/// Return index buffer descriptions. Valid between BeginLoad() and EndLoad().
+		const std::vector<IndexBufferDesc>& GetIndexBufferDescs() const { return ibDescs; }
+		/// Return geometry descriptions by geometry and LOD level. Valid between BeginLoad() and EndLoad().
+		const std::vector<std::vector<GeometryDesc> >& GetGeometryDescs() const { return geomDescs; }
 
 	private:
+		/// Load the Alimer model format. The file ID has already been read.
+		bool BeginLoadNative(Stream& source);
+		/// Load the legacy Urho3D model format. The file ID has already been read. UMD2 files have vertex declarations instead of element masks.
+		bool BeginLoadLegacy(Stream& source, bool hasVertexDeclarations);
+
 		/// Geometry LOD levels.
 		std::vector<std::vector<SharedPtr<Geometry> > > geometries;
 		/// Local space bounding box.
@@ -0,0 +1,177 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../AlimerConfig.h"
+#include "../Graphics/GraphicsDefs.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace Alimer
+{
+	/// Alimer model file identifier.
+	static const char MODEL_FILE_ID[] = "AMDL";
+	/// Alimer model file format version.
+	static const uint32_t MODEL_FILE_VERSION = 1;
+	/// Alignment in bytes of each block in a model file.
+	static const uint32_t MODEL_FILE_ALIGNMENT = 16;
+
+	/// Return an offset rounded up to the model file block alignment.
+	inline uint64_t AlignModelFileOffset(uint64_t offset)
+	{
+		return (offset + MODEL_FILE_ALIGNMENT - 1) & ~(uint64_t)(MODEL_FILE_ALIGNMENT - 1);
+	}
+
+	/// Model file header. It is followed by aligned blocks in this order: vertex buffers, vertex elements, index buffers, geometries, LOD levels as GeometryDesc structures, bone mappings as 32-bit indices, bones, bone names, and the vertex and index data referenced by offset.
+	struct ModelFileHeader
+	{
+		/// File identifier.
+		char fileID[4];
+		/// Format version.
+		uint32_t version;
+		/// Number of vertex buffers.
+		uint32_t numVertexBuffers;
+		/// Number of vertex elements in all vertex buffers.
+		uint32_t numVertexElements;
+		/// Number of index buffers.
+		uint32_t numIndexBuffers;
+		/// Number of geometries.
+		uint32_t numGeometries;
+		/// Number of LOD levels in all geometries.
+		uint32_t numLodLevels;
+		/// Number of bone mapping indices in all geometries.
+		uint32_t numBoneMappings;
+		/// Number of bones.
+		uint32_t numBones;
+		/// Size of the null terminated bone names in bytes.
+		uint32_t boneNamesSize;
+		/// Local space bounding box minimum and maximum.
+		float boundingBox[6];
+	};
+
+	/// Vertex buffer record in a model file.
+	struct ModelFileVertexBuffer
+	{
+		/// Number of vertices.
+		uint32_t vertexCount;
+		/// Vertex size in bytes. Must match the sum of the element sizes.
+		uint32_t vertexSize;
+		/// Index of the first vertex element.
+		uint32_t firstElement;
+		/// Number of vertex elements.
+		uint32_t numElements;
+		/// Offset of the vertex data from the start of the file.
+		uint64_t dataOffset;
+	};
+
+	/// Vertex element semantics in a model file.
+	enum class ModelFileSemantic : uint8_t
+	{
+		Position = 0,
+		Normal,
+		Binormal,
+		Tangent,
+		TexCoord,
+		Color,
+		BlendWeight,
+		BlendIndices,
+		Count
+	};
+
+	/// Vertex element semantic names by ModelFileSemantic.
+	static const char* const modelFileSemantics[] =
+	{
+		VertexElementSemantic::POSITION,
+		VertexElementSemantic::NORMAL,
+		VertexElementSemantic::BINORMAL,
+		VertexElementSemantic::TANGENT,
+		VertexElementSemantic::TEXCOORD,
+		VertexElementSemantic::COLOR,
+		VertexElementSemantic::BLENDWEIGHT,
+		VertexElementSemantic::BLENDINDICES
+	};
+
+	static_assert(sizeof(modelFileSemantics) / sizeof(modelFileSemantics[0]) == static_cast<size_t>(ModelFileSemantic::Count), "Model file semantic names must match ModelFileSemantic");
+
+	/// Vertex element record in a model file.
+	struct ModelFileVertexElement
+	{
+		/// Semantic.
+		ModelFileSemantic semantic;
+		/// Semantic index.
+		uint8_t semanticIndex;
+		/// Format as VertexFormat.
+		uint8_t format;
+		/// Padding.
+		uint8_t padding;
+		/// Offset from vertex start.
+		uint32_t offset;
+	};
+
+	/// Index buffer record in a model file.
+	struct ModelFileIndexBuffer
+	{
+		/// Number of indices.
+		uint32_t indexCount;
+		/// Index size in bytes, 2 or 4.
+		uint32_t indexSize;
+		/// Offset of the index data from the start of the file.
+		uint64_t dataOffset;
+	};
+
+	/// Geometry record in a model file.
+	struct ModelFileGeometry
+	{
+		/// Index of the first LOD level.
+		uint32_t firstLodLevel;
+		/// Number of LOD levels.
+		uint32_t numLodLevels;
+		/// Index of the first bone mapping.
+		uint32_t firstBoneMapping;
+		/// Number of bone mappings.
+		uint32_t numBoneMappings;
+	};
+
+	/// Bone record in a model file.
+	struct ModelFileBone
+	{
+		/// Offset of the name in the bone names block.
+		uint32_t nameOffset;
+		/// Parent bone index. Equal to own index for the root bone.
+		uint32_t parentIndex;
+		/// Reset position.
+		float initialPosition[3];
+		/// Reset rotation as x, y, z, w.
+		float initialRotation[4];
+		/// Reset scale.
+		float initialScale[3];
+		/// Offset matrix for skinning, 3 rows of 4.
+		float offsetMatrix[12];
+		/// Collision radius.
+		float radius;
+		/// Collision bounding box minimum and maximum.
+		float boundingBox[6];
+	};
+}
@@ -60,6 +60,75 @@ namespace Alimer
 		return false;
 	}
 
+	void Octant::PushNode(OctreeNode* node)
+	{
+		nodes.push_back(node);
+		minX.push_back(0.0f);
+		minY.push_back(0.0f);
+		minZ.push_back(0.0f);
+		maxX.push_back(0.0f);
+		maxY.push_back(0.0f);
+		maxZ.push_back(0.0f);
+		nodeFlags.push_back(0);
+		layerMasks.push_back(0);
+		SetCullingData(nodes.size() - 1, node);
+	}
+
+	OctreeNode* Octant::EraseNode(size_t index)
+	{
+		size_t last = nodes.size() - 1;
+		OctreeNode* moved = index < last ? nodes[last] : nullptr;
+		if (moved)
+		{
+			nodes[index] = nodes[last];
+			minX[index] = minX[last];
+			minY[index] = minY[last];
+			minZ[index] = minZ[last];
+			maxX[index] = maxX[last];
+			maxY[index] = maxY[last];
+			maxZ[index] = maxZ[last];
+			nodeFlags[index] = nodeFlags[last];
+			layerMasks[index] = layerMasks[last];
+		}
+
+		nodes.pop_back();
+		minX.pop_back();
+		minY.pop_back();
+		minZ.pop_back();
+		maxX.pop_back();
+		maxY.pop_back();
+		maxZ.pop_back();
+		nodeFlags.pop_back();
+		layerMasks.pop_back();
+		return moved;
+	}
+
+	void Octant::ClearNodes()
+	{
+		nodes.clear();
+		minX.clear();
+		minY.clear();
+		minZ.clear();
+		maxX.clear();
+		maxY.clear();
+		maxZ.clear();
+		nodeFlags.clear();
+		layerMasks.clear();
+	}
+
+	void Octant::SetCullingData(size_t index, const OctreeNode* node)
+	{
+		const BoundingBox& box = node->WorldBoundingBox();
+		minX[index] = box.min.x;
+		minY[index] = box.min.y;
+		minZ[index] = box.min.z;
+		maxX[index] = box.max.x;
+		maxY[index] = box.max.y;
+		maxZ[index] = box.max.z;
+		nodeFlags[index] = node->GetFlags();
+		layerMasks[index] = node->GetLayerMask();
+	}
+
 	Octree::Octree()
 	{
 		root.Initialize(nullptr, BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), DEFAULT_OCTREE_LEVELS);
@@ -82,6 +151,11 @@ namespace Alimer
 	{
 		ALIMER_PROFILE(UpdateOctree);
 
+		if (_updateQueue.empty())
+			return;
+
+		// Clear the queued flags. Nodes with a spatial parent get their world transform calculated here, because the parent
+		// may be shared by several queued nodes and calculating it from worker threads would race
 		for (auto it = _updateQueue.begin(); it != _updateQueue.end(); ++it)
 		{
 			OctreeNode* node = *it;
@@ -89,42 +163,35 @@ namespace Alimer
 			if (node)
 			{
 				node->SetFlag(NF_OCTREE_UPDATE_QUEUED, false);
+				if (node->TestFlag(NF_SPATIAL_PARENT))
+					node->WorldTransform();
+			}
+		}
 
-				// Do nothing if still fits the current octant
-				const BoundingBox& box = node->WorldBoundingBox();
-				Vector3 boxSize = box.Size();
-				Octant* oldOctant = node->_octant;
-				if (oldOctant && oldOctant->cullingBox.IsInside(box) == INSIDE && oldOctant->FitBoundingBox(box, boxSize))
-					continue;
+		// Calculate the bounding boxes in parallel. Nodes that still fit their current octant only refresh the culling data,
+		// which touches distinct array elements and needs no locking
+		size_t count = _updateQueue.size();
+		_reinsertFlags.resize(count);
+		auto updateBoundingBoxes = [this](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				OctreeNode* node = _updateQueue[i];
+				_reinsertFlags[i] = node && !UpdateBoundingBox(node);
+			}
+		};
 
-				// Begin reinsert process. Start from root and check what level child needs to be used
-				Octant* newOctant = &root;
-				Vector3 boxCenter = box.Center();
+		JobSystem* jobSystem = GetSubsystem<JobSystem>();
+		if (jobSystem)
+			jobSystem->ParallelFor(count, OCTREE_UPDATE_GRAIN_SIZE, updateBoundingBoxes);
+		else
+			updateBoundingBoxes(0, count);
 
-				for (;;)
-				{
-					bool insertHere;
-					// If node does not fit fully inside root octant, must remain in it
-					if (newOctant == &root)
-						insertHere = newOctant->cullingBox.IsInside(box) != INSIDE || newOctant->FitBoundingBox(box, boxSize);
-					else
-						insertHere = newOctant->FitBoundingBox(box, boxSize);
-
-					if (insertHere)
-					{
-						if (newOctant != oldOctant)
-						{
-							// Add first, then remove, because node count going to zero deletes the octree branch in question
-							AddNode(node, newOctant);
-							if (oldOctant)
-								RemoveNode(node, oldOctant);
-						}
-						break;
-					}
-					else
-						newOctant = CreateChildOctant(newOctant, newOctant->ChildIndex(boxCenter));
-				}
-			}
+		// Then reinsert the nodes that moved out of their octant serially
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (_reinsertFlags[i])
+				ReinsertNode(_updateQueue[i]);
 		}
 
 		_updateQueue.clear();
@@ -148,7 +215,8 @@ namespace Alimer
 	void Octree::RemoveNode(OctreeNode* node)
 	{
 		assert(node);
-		RemoveNode(node, node->_octant);
+		if (node->_octant)
+			RemoveNode(node, node->_octant, node->_octantIndex);
 		if (node->TestFlag(NF_OCTREE_UPDATE_QUEUED))
 		{
 			CancelUpdate(node);
@@ -220,6 +288,12 @@ namespace Alimer
 		return emptyRes;
 	}
 
+	void Octree::FindNodes(std::vector<OctreeNode*>& result, const Frustum& frustum, unsigned short nodeFlags, unsigned layerMask) const
+	{
+		ALIMER_PROFILE(QueryOctree);
+		CollectNodes(result, &root, frustum, FrustumSoA(frustum), nodeFlags, layerMask);
+	}
+
 	void Octree::SetBoundingBoxAttr(const BoundingBox& boundingBox)
 	{
 		root.worldBoundingBox = boundingBox;
@@ -241,9 +315,60 @@ namespace Alimer
 		return root.level;
 	}
 
+	bool Octree::UpdateBoundingBox(OctreeNode* node)
+	{
+		const BoundingBox& box = node->WorldBoundingBox();
+		Octant* octant = node->_octant;
+		if (octant && octant->cullingBox.IsInside(box) == INSIDE && octant->FitBoundingBox(box, box.Size()))
+		{
+			octant->SetCullingData(node->_octantIndex, node);
+			return true;
+		}
+
+		return false;
+	}
+
+	void Octree::ReinsertNode(OctreeNode* node)
+	{
+		const BoundingBox& box = node->WorldBoundingBox();
+		Vector3 boxSize = box.Size();
+		Vector3 boxCenter = box.Center();
+		Octant* oldOctant = node->_octant;
+		size_t oldIndex = node->_octantIndex;
+
+		// Start from root and check what level child needs to be used
+		Octant* newOctant = &root;
+		for (;;)
+		{
+			bool insertHere;
+			// If node does not fit fully inside root octant, must remain in it
+			if (newOctant == &root)
+				insertHere = newOctant->cullingBox.IsInside(box) != INSIDE || newOctant->FitBoundingBox(box, boxSize);
+			else
+				insertHere = newOctant->FitBoundingBox(box, boxSize);
+
+			if (insertHere)
+			{
+				if (newOctant != oldOctant)
+				{
+					// Add first, then remove, because node count going to zero deletes the octree branch in question
+					AddNode(node, newOctant);
+					if (oldOctant)
+						RemoveNode(node, oldOctant, oldIndex);
+				}
+				else
+					oldOctant->SetCullingData(oldIndex, node);
+				break;
+			}
+			else
+				newOctant = CreateChildOctant(newOctant, newOctant->ChildIndex(boxCenter));
+		}
+	}
+
 	void Octree::AddNode(OctreeNode* node, Octant* octant)
 	{
-		octant->nodes.push_back(node);
+		node->_octantIndex = octant->nodes.size();
+		octant->PushNode(node);
 		node->_octant = octant;
 
 		// Increment the node count in the whole parent branch
@@ -254,12 +379,13 @@ namespace Alimer
 		}
 	}
 
-	void Octree::RemoveNode(OctreeNode* node, Octant* octant)
+	void Octree::RemoveNode(OctreeNode* node, Octant* octant, size_t index)
 	{
-		// Do not set the node's octant pointer to zero, as the node may already be added into another octant.
-		auto it = std::find(octant->nodes.begin(), octant->nodes.end(), node);
-		if (it != end(octant->nodes))
-			octant->nodes.erase(it);
+		// Do not set the node's octant pointer or index, as the node may already be added into another octant.
+		assert(index < octant->nodes.size() && octant->nodes[index] == node);
+		OctreeNode* moved = octant->EraseNode(index);
+		if (moved)
+			moved->_octantIndex = index;
 
 		// Decrement the node count in the whole parent branch and erase empty octants as necessary
 		while (octant)
@@ -318,7 +444,7 @@ namespace Alimer
 			if (deletingOctree)
 				node->_octant = nullptr;
 		}
-		octant->nodes.clear();
+		octant->ClearNodes();
 		octant->numNodes = 0;
 
 		for (size_t i = 0; i < NUM_OCTANTS; ++i)
@@ -347,11 +473,10 @@ namespace Alimer
 
 	void Octree::CollectNodes(std::vector<OctreeNode*>& result, const Octant* octant, unsigned short nodeFlags, unsigned layerMask) const
 	{
-		const std::vector<OctreeNode*>& octantNodes = octant->nodes;
-		for (auto* node : octantNodes)
+		for (size_t i = 0, count = octant->nodes.size(); i < count; ++i)
 		{
-			if ((node->GetFlags() & nodeFlags) == nodeFlags && (node->GetLayerMask() & layerMask))
-				result.push_back(node);
+			if ((octant->nodeFlags[i] & nodeFlags) == nodeFlags && (octant->layerMasks[i] & layerMask))
+				result.push_back(octant->nodes[i]);
 		}
 
 		for (size_t i = 0; i < NUM_OCTANTS; ++i)
@@ -361,6 +486,41 @@ namespace Alimer
 		}
 	}
 
+	void Octree::CollectNodes(std::vector<OctreeNode*>& result, const Octant* octant, const Frustum& frustum, const FrustumSoA& frustumSoA, unsigned short nodeFlags, unsigned layerMask) const
+	{
+		Intersection res = frustum.IsInside(octant->cullingBox);
+		if (res == OUTSIDE)
+			return;
+
+		// If this octant is completely inside the frustum, can include all contained octants and their nodes without further tests
+		if (res == INSIDE)
+			CollectNodes(result, octant, nodeFlags, layerMask);
+		else
+		{
+			uint8_t inside[FRUSTUM_BATCH_SIZE];
+
+			// Test the bounding boxes in batches, then check flags of the nodes inside
+			for (size_t i = 0, count = octant->nodes.size(); i < count; i += FRUSTUM_BATCH_SIZE)
+			{
+				size_t batchSize = std::min(count - i, FRUSTUM_BATCH_SIZE);
+				octant->CullNodes(frustumSoA, i, batchSize, inside);
+
+				for (size_t j = 0; j < batchSize; ++j)
+				{
+					size_t index = i + j;
+					if (inside[j] && (octant->nodeFlags[index] & nodeFlags) == nodeFlags && (octant->layerMasks[index] & layerMask))
+						result.push_back(octant->nodes[index]);
+				}
+			}
+
+			for (size_t i = 0; i < NUM_OCTANTS; ++i)
+			{
+				if (octant->children[i])
+					CollectNodes(result, octant->children[i], frustum, frustumSoA, nodeFlags, layerMask);
+			}
+		}
+	}
+
 	void Octree::CollectNodes(std::vector<RaycastResult>& result, const Octant* octant, const Ray& ray, unsigned short nodeFlags,
 		float maxDistance, unsigned layerMask) const
 	{
@@ -5,12 +5,22 @@
 #include "../Base/Allocator.h"
 #include "../Debug/Profiler.h"
 #include "../Math/BoundingBox.h"
+#include "../Math/FrustumSoA.h"
+#include "../Threading/JobSystem.h"
 #include "OctreeNode.h"
 
 namespace Alimer
 {
 
 	static const size_t NUM_OCTANTS = 8;
+	/// Octree levels processed on the calling thread in a parallel query. The subtrees below are culled in parallel.
+	static const size_t PARALLEL_QUERY_DEPTH = 2;
+	/// Number of queued nodes per job when updating bounding boxes in parallel.
+	static const size_t OCTREE_UPDATE_GRAIN_SIZE = 256;
+	/// Maximum number of subtrees in a parallel query.
+	static const size_t MAX_PARALLEL_SUBTREES = NUM_OCTANTS * NUM_OCTANTS;
+	/// Number of result slots in a parallel query: one for the upper levels and one per subtree.
+	static const size_t NUM_PARALLEL_QUERY_SLOTS = MAX_PARALLEL_SUBTREES + 1;
 
 	class Octree;
 	class OctreeNode;
@@ -43,6 +53,16 @@ namespace Alimer
 		bool FitBoundingBox(const BoundingBox& box, const Vector3& boxSize) const;
 		/// Return child octant index based on position.
 		size_t ChildIndex(const Vector3& position) const { size_t ret = position.x < center.x ? 0 : 1; ret += position.y < center.y ? 0 : 2; ret += position.z < center.z ? 0 : 4; return ret; }
+		/// Append a node and its culling data.
+		void PushNode(OctreeNode* node);
+		/// Remove the node at index by moving the last node to its place. Return the moved node, or null if the last node was removed.
+		OctreeNode* EraseNode(size_t index);
+		/// Remove all nodes and culling data.
+		void ClearNodes();
+		/// Copy the current bounding box, flags and layer mask of the node at index to the culling data.
+		void SetCullingData(size_t index, const OctreeNode* node);
+		/// Test the bounding boxes of a range of nodes against a frustum. Write 1 to the results for each node that is (partially) inside and 0 for nodes outside.
+		void CullNodes(const FrustumSoA& frustum, size_t start, size_t count, uint8_t* results) const { frustum.IsInsideFast(&minX[start], &minY[start], &minZ[start], &maxX[start], &maxY[start], &maxZ[start], count, results); }
 
 		/// Expanded (loose) bounding box used for culling the octant and the nodes within it.
 		BoundingBox cullingBox;
@@ -56,6 +76,22 @@ namespace Alimer
 		int level;
 		/// Nodes contained in the octant.
 		std::vector<OctreeNode*> nodes;
+		/// Node bounding box minimum X coordinates. The culling data is in the same order as the nodes.
+		std::vector<float> minX;
+		/// Node bounding box minimum Y coordinates.
+		std::vector<float> minY;
+		/// Node bounding box minimum Z coordinates.
+		std::vector<float> minZ;
+		/// Node bounding box maximum X coordinates.
+		std::vector<float> maxX;
+		/// Node bounding box maximum Y coordinates.
+		std::vector<float> maxY;
+		/// Node bounding box maximum Z coordinates.
+		std::vector<float> maxZ;
+		/// Node flags.
+		std::vector<uint16_t> nodeFlags;
+		/// Node layer masks.
+		std::vector<uint32_t> layerMasks;
 		/// Child octants.
 		Octant* children[NUM_OCTANTS];
 		/// Parent octant.
@@ -100,6 +136,9 @@ namespace Alimer
 			CollectNodes(result, &root, volume, nodeFlags, layerMask);
 		}
 
+		/// Query for nodes using a frustum. The nodes are tested in batches with SIMD instructions.
+		void FindNodes(std::vector<OctreeNode*>& result, const Frustum& frustum, unsigned short nodeFlags, unsigned layerMask = LAYERMASK_ALL) const;
+
 		/// Query for nodes using a volume such as frustum or sphere. Invoke a function for each octant.
 		template <class T> void FindNodes(const T& volume, void(*callback)(std::vector<OctreeNode*>::const_iterator, std::vector<OctreeNode*>::const_iterator, bool)) const
 		{
@@ -114,7 +153,49 @@ namespace Alimer
 			CollectNodesMemberCallback(&root, volume, object, callback);
 		}
 
+		/// Query for nodes using a volume such as frustum or sphere, culling the octant subtrees in parallel with the JobSystem. Invoke a member function for each octant with a result slot index below NUM_PARALLEL_QUERY_SLOTS: 0 for the upper levels and 1 + subtree index below them. Each slot is written by one thread at a time, and concatenating the slots in index order gives the same order regardless of which thread culled which subtree. The callback can cull the octant's nodes using its culling data.
+		template <class T, class U> void FindNodesParallel(const T& volume, U* object, void (U::*callback)(const Octant*, bool, uint32_t)) const
+		{
+			ALIMER_PROFILE(QueryOctreeParallel);
+
+			Intersection res = volume.IsInside(root.cullingBox);
+			if (res == OUTSIDE)
+				return;
+
+			// Process the upper levels on the calling thread and gather the subtrees below them
+			ParallelSubtree subtrees[MAX_PARALLEL_SUBTREES];
+			size_t numSubtrees = 0;
+			CollectParallelSubtrees(&root, res == INSIDE, 0, volume, object, callback, 0, subtrees, numSubtrees);
+
+			auto collectSubtrees = [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					uint32_t slotIndex = static_cast<uint32_t>(i + 1);
+					if (subtrees[i].inside)
+						CollectNodesParallelCallback(subtrees[i].octant, object, callback, slotIndex);
+					else
+						CollectNodesParallelCallback(subtrees[i].octant, volume, object, callback, slotIndex);
+				}
+			};
+
+			JobSystem* jobSystem = Object::GetSubsystem<JobSystem>();
+			if (jobSystem)
+				jobSystem->ParallelFor(numSubtrees, 1, collectSubtrees);
+			else
+				collectSubtrees(0, numSubtrees);
+		}
+
 	private:
+		/// Octant subtree to be culled by a parallel query.
+		struct ParallelSubtree
+		{
+			/// Subtree root octant.
+			const Octant* octant;
+			/// Whether the octant is completely inside the query volume.
+			bool inside;
+		};
+
 		/// Set bounding box. Used in serialization.
 		void SetBoundingBoxAttr(const BoundingBox& boundingBox);
 		/// Return bounding box. Used in serialization.
@@ -123,10 +204,14 @@ namespace Alimer
 		void SetNumLevelsAttr(int numLevels);
 		/// Return number of levels. Used in serialization.
 		int NumLevelsAttr() const;
+		/// Update the bounding box of a queued node. If it still fits the current octant, refresh the culling data and return true. Safe to call from worker threads.
+		bool UpdateBoundingBox(OctreeNode* node);
+		/// Find the octant for a node whose bounding box no longer fits its current octant and move it there.
+		void ReinsertNode(OctreeNode* node);
 		/// Add node to a specific octant.
 		void AddNode(OctreeNode* node, Octant* octant);
-		/// Remove node from an octant.
-		void RemoveNode(OctreeNode* node, Octant* octant);
+		/// Remove node from an octant, where it resides at the specified index.
+		void RemoveNode(OctreeNode* node, Octant* octant, size_t index);
 		/// Create a new child octant.
 		Octant* CreateChildOctant(Octant* octant, size_t index);
 		/// Delete one child octant.
@@ -137,6 +222,8 @@ namespace Alimer
 		void CollectNodes(std::vector<OctreeNode*>& result, const Octant* octant) const;
 		/// Get all visible nodes matching flags from an octant recursively.
 		void CollectNodes(std::vector<OctreeNode*>& result, const Octant* octant, unsigned short nodeFlags, unsigned layerMask) const;
+		/// Get all visible nodes matching flags using a frustum, testing the nodes in batches.
+		void CollectNodes(std::vector<OctreeNode*>& result, const Octant* octant, const Frustum& frustum, const FrustumSoA& frustumSoA, unsigned short nodeFlags, unsigned layerMask) const;
 		/// Get all visible nodes matching flags along a ray.
 		void CollectNodes(std::vector<RaycastResult>& result, const Octant* octant, const Ray& ray, unsigned short nodeFlags, float maxDistance, unsigned layerMask) const;
 		/// Get all visible nodes matching flags that could be potential raycast hits.
@@ -154,14 +241,14 @@ namespace Alimer
 				CollectNodes(result, octant, nodeFlags, layerMask);
 			else
 			{
-				const std::vector<OctreeNode*>& octantNodes = octant->nodes;
-				for (auto it = octantNodes.begin(); it != octantNodes.end(); ++it)
+				// Test using the culling data, so that only the matching nodes are accessed
+				for (size_t i = 0, count = octant->nodes.size(); i < count; ++i)
 				{
-					OctreeNode* node = *it;
-					if ((node->GetFlags() & nodeFlags) == nodeFlags && (node->GetLayerMask() & layerMask) &&
-						volume.IsInsideFast(node->WorldBoundingBox()) != OUTSIDE)
+					if ((octant->nodeFlags[i] & nodeFlags) == nodeFlags && (octant->layerMasks[i] & layerMask) &&
+						volume.IsInsideFast(BoundingBox(Vector3(octant->minX[i], octant->minY[i], octant->minZ[i]),
+						Vector3(octant->maxX[i], octant->maxY[i], octant->maxZ[i]))) != OUTSIDE)
 					{
-						result.push_back(node);
+						result.push_back(octant->nodes[i]);
 					}
 				}
 
@@ -246,14 +333,81 @@ namespace Alimer
 			}
 		}
 
+		/// Process the upper levels of a parallel query and gather the subtrees below them.
+		template <class T, class U> void CollectParallelSubtrees(const Octant* octant, bool inside, size_t depth, const T& volume, U* object, void (U::*callback)(const Octant*, bool, uint32_t), uint32_t slotIndex, ParallelSubtree* subtrees, size_t& numSubtrees) const
+		{
+			(object->*callback)(octant, inside, slotIndex);
+
+			for (size_t i = 0; i < NUM_OCTANTS; ++i)
+			{
+				const Octant* child = octant->children[i];
+				if (!child)
+					continue;
+
+				bool childInside = inside;
+				if (!inside)
+				{
+					Intersection res = volume.IsInside(child->cullingBox);
+					if (res == OUTSIDE)
+						continue;
+					childInside = res == INSIDE;
+				}
+
+				if (depth + 1 < PARALLEL_QUERY_DEPTH)
+					CollectParallelSubtrees(child, childInside, depth + 1, volume, object, callback, slotIndex, subtrees, numSubtrees);
+				else
+				{
+					subtrees[numSubtrees].octant = child;
+					subtrees[numSubtrees].inside = childInside;
+					++numSubtrees;
+				}
+			}
+		}
+
+		/// Collect nodes from octant and child octants in a parallel query. Invoke a member function for each octant.
+		template <class T> void CollectNodesParallelCallback(const Octant* octant, T* object, void (T::*callback)(const Octant*, bool, uint32_t), uint32_t slotIndex) const
+		{
+			(object->*callback)(octant, true, slotIndex);
+
+			for (size_t i = 0; i < NUM_OCTANTS; ++i)
+			{
+				if (octant->children[i])
+					CollectNodesParallelCallback(octant->children[i], object, callback, slotIndex);
+			}
+		}
+
+		/// Collect nodes using a volume such as frustum or sphere in a parallel query. Invoke a member function for each octant.
+		template <class T, class U> void CollectNodesParallelCallback(const Octant* octant, const T& volume, U* object, void (U::*callback)(const Octant*, bool, uint32_t), uint32_t slotIndex) const
+		{
+			Intersection res = volume.IsInside(octant->cullingBox);
+			if (res == OUTSIDE)
+				return;
+
+			// If this octant is completely inside the volume, can include all contained octants and their nodes without further tests
+			if (res == INSIDE)
+				CollectNodesParallelCallback(octant, object, callback, slotIndex);
+			else
+			{
+				(object->*callback)(octant, false, slotIndex);
+
+				for (size_t i = 0; i < NUM_OCTANTS; ++i)
+				{
+					if (octant->children[i])
+						CollectNodesParallelCallback(octant->children[i], volume, object, callback, slotIndex);
+				}
+			}
+		}
+
 		/// Queue of nodes to be reinserted.
 		std::vector<OctreeNode*> _updateQueue;
+		/// Reinsertion needed flags for the nodes in the update queue.
+		std::vector<uint8_t> _reinsertFlags;
 		/// RaycastSingle initial coarse result.
 		std::vector<std::pair<OctreeNode*, float> > initialRes;
 		/// RaycastSingle final result.
 		std::vector<RaycastResult> finalRes;
 		/// Allocator for child octants.
-		Allocator<Octant> allocator;
+		ThreadCachedAllocator<Octant> allocator;
 		/// Root octant.
 		Octant root;
 	};
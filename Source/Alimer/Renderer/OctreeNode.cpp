@@ -31,6 +31,7 @@ namespace Alimer
 	OctreeNode::OctreeNode()
 		: _octree(nullptr)
 		, _octant(nullptr)
+		, _octantIndex(0)
 		, _lastFrameNumber(0)
 		, _distance(0.0f)
 	{
@@ -51,6 +52,7 @@ namespace Alimer
 	void OctreeNode::SetCastShadows(bool enable)
 	{
 		SetFlag(NF_CASTSHADOWS, enable);
+		QueueOctreeUpdate();
 	}
 
 	void OctreeNode::OnPrepareRender(uint32_t frameNumber, Camera* camera)
@@ -93,11 +95,17 @@ namespace Alimer
 	{
 		SpatialNode::OnTransformChanged();
 		SetFlag(NF_BOUNDING_BOX_DIRTY, true);
+		QueueOctreeUpdate();
+	}
 
-		if (!TestFlag(NF_OCTREE_UPDATE_QUEUED) && _octree)
-		{
-			_octree->QueueUpdate(this);
-		}
+	void OctreeNode::OnSetEnabled(bool)
+	{
+		QueueOctreeUpdate();
+	}
+
+	void OctreeNode::OnSetLayer(uint8_t)
+	{
+		QueueOctreeUpdate();
 	}
 
 	void OctreeNode::OnWorldBoundingBoxUpdate() const
@@ -116,4 +124,10 @@ namespace Alimer
 		}
 	}
 
+	void OctreeNode::QueueOctreeUpdate()
+	{
+		if (!TestFlag(NF_OCTREE_UPDATE_QUEUED) && _octree)
+			_octree->QueueUpdate(this);
+	}
+
 }
\ No newline at end of file
@@ -77,6 +77,10 @@ namespace Alimer
 		void OnSceneSet(Scene* newScene, Scene* oldScene) override;
 		/// Handle the transform matrix changing.
 		void OnTransformChanged() override;
+		/// Handle the enabled status changing.
+		void OnSetEnabled(bool newEnabled) override;
+		/// Handle the layer changing.
+		void OnSetLayer(uint8_t newLayer) override;
 		/// Recalculate the world space bounding box.
 		virtual void OnWorldBoundingBoxUpdate() const;
 
@@ -90,10 +94,14 @@ namespace Alimer
 	private:
 		/// Remove from the current octree.
 		void RemoveFromOctree();
+		/// Queue a reinsertion to the octree, which also refreshes the culling data in the octant.
+		void QueueOctreeUpdate();
 
 		/// Current octree.
 		Octree* _octree;
 		/// Current octree octant.
 		Octant* _octant;
+		/// Index within the current octant's nodes.
+		size_t _octantIndex;
 	};
 }
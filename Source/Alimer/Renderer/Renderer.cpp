@@ -31,6 +31,7 @@
 #include "../Graphics/VertexBuffer.h"
 #include "../Resource/ResourceCache.h"
 #include "../Scene/Scene.h"
+#include "../Threading/JobSystem.h"
 #include "Light.h"
 #include "Material.h"
 #include "Model.h"
@@ -38,6 +39,7 @@
 #include "Renderer.h"
 #include "StaticModel.h"
 #include <algorithm>
+#include <cstring>
 
 using namespace std;
 
@@ -53,6 +55,9 @@ namespace Alimer
 	static const uint32_t LPS_LIGHT2 = (0x400 | 0x800 | 0x1000);
 	static const uint32_t LPS_LIGHT3 = (0x2000 | 0x4000 | 0x8000);
 
+	/// Number of geometries per batch collection job.
+	static const size_t COLLECT_BATCHES_GRAIN_SIZE = 64;
+
 	static const CullMode cullModeFlip[] =
 	{
 		CULL_NONE,
@@ -83,6 +88,8 @@ namespace Alimer
 	}
 
 	Renderer::Renderer()
+		: lightLists(std::less<uint64_t>(), ArenaAllocator<std::pair<const uint64_t, LightList> >(&_frameArena))
+		, lightPasses(std::less<uint64_t>(), ArenaAllocator<std::pair<const uint64_t, LightPass> >(&_frameArena))
 	{
 	}
 
@@ -142,8 +149,10 @@ namespace Alimer
 		_instanceTransforms.clear();
 		lightLists.clear();
 		lightPasses.clear();
+		// The light lists and passes are now in the frame arena. The previous view's data stays valid until the next view
+		_frameArena.BeginFrame();
 		for (auto it = batchQueues.begin(); it != batchQueues.end(); ++it)
-			it->second.Clear();
+			it->Clear();
 		for (auto it = shadowMaps.begin(); it != shadowMaps.end(); ++it)
 			it->Clear();
 		usedShadowViews = 0;
@@ -163,8 +172,25 @@ namespace Alimer
 		_octree->Update();
 
 		_frustum = _camera->WorldFrustum();
+		_frustumSoA.Define(_frustum);
 		_viewMask = _camera->ViewMask();
-		_octree->FindNodes(_frustum, this, &Renderer::CollectGeometriesAndLights);
+
+		// Cull the octree in parallel, then merge the per-slot results in slot order, so that the order of the visible objects
+		// does not depend on which thread culled which subtree
+		_slotObjects.resize(NUM_PARALLEL_QUERY_SLOTS);
+		for (auto it = _slotObjects.begin(); it != _slotObjects.end(); ++it)
+		{
+			it->geometries.clear();
+			it->lights.clear();
+		}
+
+		_octree->FindNodesParallel(_frustum, this, &Renderer::CollectGeometriesAndLights);
+
+		for (auto it = _slotObjects.begin(); it != _slotObjects.end(); ++it)
+		{
+			geometries.insert(geometries.end(), it->geometries.begin(), it->geometries.end());
+			_lights.insert(_lights.end(), it->lights.begin(), it->lights.end());
+		}
 
 		return true;
 	}
@@ -175,11 +201,14 @@ namespace Alimer
 
 		{
 			// Sort lights by increasing distance. Directional lights will have distance 0 which ensure they have the first
-			// opportunity to allocate shadow maps
+			// opportunity to allocate shadow maps. Lights at equal distance keep their collection order
 			ALIMER_PROFILE(SortLights);
-			std::sort(_lights.begin(), _lights.end(), CompareLights);
+			std::stable_sort(_lights.begin(), _lights.end(), CompareLights);
 		}
 
+		size_t numShadowLights = 0;
+		size_t numShadowViewJobs = 0;
+
 		for (auto it = _lights.begin(), end = _lights.end(); it != end; ++it)
 		{
 			Light* light = *it;
@@ -190,7 +219,7 @@ namespace Alimer
 
 			// Create a light list that contains only this light. It will be used for nodes that have no light interactions so far
 			uint64_t key = (uint64_t)light;
-			LightList* lightList = &lightLists[key];
+			LightList* lightList = CreateLightList(key);
 			lightList->lights.push_back(light);
 			lightList->key = key;
 			lightList->useCount = 0;
@@ -280,67 +309,35 @@ namespace Alimer
 				continue;
 			}
 
-			// Setup shadow cameras & find shadow casters
+			// Reserve the shadow views now. Their setup and the shadow caster collection are done in parallel after all
+			// lights have been processed, as the views are independent of each other
 			size_t startIndex = usedShadowViews;
-			light->SetupShadowViews(_camera, shadowViews, usedShadowViews);
-			bool hasShadowBatches = false;
+			light->AllocateShadowViews(shadowViews, usedShadowViews);
+			// Make sure the light's world transform is up to date before accessing it from several threads
+			light->WorldTransform();
+
+			if (_shadowLitGeometries.size() <= numShadowLights)
+				_shadowLitGeometries.resize(numShadowLights + 1);
+			_shadowLitGeometries[numShadowLights].swap(litGeometries);
 
 			for (size_t i = startIndex; i < usedShadowViews; ++i)
 			{
-				ShadowView* view = shadowViews[i].get();
-				Frustum shadowFrustum = view->shadowCamera.WorldFrustum();
-				BatchQueue& shadowQueue = view->shadowQueue;
-				shadowQueue.sort = SORT_STATE;
-				shadowQueue.lit = false;
-				shadowQueue.baseIndex = Material::GetPassIndex("shadow");
-				shadowQueue.additiveIndex = 0;
-
-				switch (light->GetLightType())
-				{
-				case LIGHT_DIRECTIONAL:
-					// Directional light needs a new frustum query for each split, as the shadow cameras are typically far outside
-					// the main view
-					litGeometries.clear();
-					_octree->FindNodes(reinterpret_cast<std::vector<OctreeNode*>&>(litGeometries),
-						shadowFrustum, NF_ENABLED | NF_GEOMETRY | NF_CASTSHADOWS, light->LightMask());
-					CollectShadowBatches(litGeometries, shadowQueue, shadowFrustum, false, false);
-					break;
-
-				case LIGHT_POINT:
-					// Check which lit geometries are shadow casters and inside each shadow frustum. First check whether the
-					// shadow frustum is inside the view at all
-					/// \todo Could use a frustum-frustum test for more accuracy
-					if (_frustum.IsInsideFast(BoundingBox(shadowFrustum)))
-					{
-						CollectShadowBatches(litGeometries, shadowQueue, shadowFrustum, true, true);
-					}
-					break;
-
-				case LIGHT_SPOT:
-					// For spot light only need to check which lit geometries are shadow casters
-					CollectShadowBatches(litGeometries, shadowQueue, shadowFrustum, true, false);
-					break;
-				}
-
-				shadowQueue.Sort(_instanceTransforms);
-
-				// Mark shadow map for rendering only if it has a view with some batches
-				if (shadowQueue.batches.size())
-				{
-					shadowMaps[index].shadowViews.push_back(view);
-					shadowMaps[index].used = true;
-					hasShadowBatches = true;
-				}
+				if (_shadowViewJobs.size() <= numShadowViewJobs)
+					_shadowViewJobs.resize(numShadowViewJobs + 1);
+
+				ShadowViewJob& job = _shadowViewJobs[numShadowViewJobs++];
+				job.view = shadowViews[i].get();
+				job.viewIndex = i - startIndex;
+				job.shadowMapIndex = index;
+				job.litGeometriesIndex = numShadowLights;
 			}
 
-			if (!hasShadowBatches)
-			{
-				// Light did not have any shadow batches: convert to unshadowed and reuse the views
-				light->SetShadowMap(nullptr);
-				usedShadowViews = startIndex;
-			}
+			++numShadowLights;
 		}
 
+		if (numShadowViewJobs)
+			ProcessShadowViews(numShadowViewJobs);
+
 		{
 			ALIMER_PROFILE(BuildLightPasses);
 
@@ -461,88 +458,62 @@ namespace Alimer
 	{
 		ALIMER_PROFILE(CollectBatches);
 
-		// Setup batch queues for each requested pass
-		static std::vector<BatchQueue*> currentQueues;
-		currentQueues.resize(passes.size());
+		// Setup batch queues for each requested pass. Create the queues first, as growing the queue array moves them
+		_currentQueues.resize(passes.size());
 		for (size_t i = 0; i < passes.size(); ++i)
 		{
 			const PassDesc& srcPass = passes[i];
 			uint8_t baseIndex = Material::GetPassIndex(srcPass.name);
-			BatchQueue* batchQueue = &batchQueues[baseIndex];
-			currentQueues[i] = batchQueue;
-			batchQueue->sort = srcPass.sort;
-			batchQueue->lit = srcPass.lit;
-			batchQueue->baseIndex = baseIndex;
-			batchQueue->additiveIndex = srcPass.lit ? Material::GetPassIndex(srcPass.name + "add") : 0;
+			BatchQueue& batchQueue = GetBatchQueue(baseIndex);
+			batchQueue.sort = srcPass.sort;
+			batchQueue.lit = srcPass.lit;
+			batchQueue.baseIndex = baseIndex;
+			batchQueue.additiveIndex = srcPass.lit ? Material::GetPassIndex(srcPass.name + "add") : 0;
 		}
-
-		// Loop through geometry nodes
-		for (auto gIt = geometries.begin(), gEnd = geometries.end(); gIt != gEnd; ++gIt)
+		for (size_t i = 0; i < passes.size(); ++i)
+			_currentQueues[i] = &batchQueues[Material::GetPassIndex(passes[i].name)];
+
+		// Collect batches from chunks of geometries into per-chunk vectors. Which thread executes a chunk varies, so the
+		// results are stored by chunk index to keep the merged order, and therefore the order of equal sort keys, deterministic
+		JobSystem* jobSystem = GetSubsystem<JobSystem>();
+		size_t numChunks = jobSystem ? (geometries.size() + COLLECT_BATCHES_GRAIN_SIZE - 1) / COLLECT_BATCHES_GRAIN_SIZE : 1;
+		if (_chunkBatches.size() < numChunks)
+			_chunkBatches.resize(numChunks);
+		for (auto it = _chunkBatches.begin(); it != _chunkBatches.end(); ++it)
 		{
-			GeometryNode* node = *gIt;
-			LightList* lightList = node->GetLightList();
-
-			Batch newBatch;
-			newBatch.type = node->GetGeometryType();
-			newBatch.worldMatrix = &node->WorldTransform();
-
-			// Loop through node's geometries
-			for (auto bIt = node->GetBatches().begin(), bEnd = node->GetBatches().end(); bIt != bEnd; ++bIt)
+			it->batches.resize(_currentQueues.size());
+			it->additiveBatches.resize(_currentQueues.size());
+			for (size_t i = 0; i < _currentQueues.size(); ++i)
 			{
-				newBatch.geometry = bIt->geometry.Get();
-				Material* material = bIt->material.Get();
-				assert(material);
-
-				// Loop through requested queues
-				for (auto qIt = currentQueues.begin(); qIt != currentQueues.end(); ++qIt)
-				{
-					BatchQueue& batchQueue = **qIt;
-					newBatch.pass = material->GetPass(batchQueue.baseIndex);
-					// Material may not have the requested pass at all, skip further processing as fast as possible in that case
-					if (!newBatch.pass)
-						continue;
-
-					newBatch.lights = batchQueue.lit ? lightList ? lightList->lightPasses[0] : &ambientLightPass : nullptr;
-					if (batchQueue.sort < SORT_BACK_TO_FRONT)
-						newBatch.CalculateSortKey();
-					else
-						newBatch.distance = node->GetDistance();
-
-					batchQueue.batches.push_back(newBatch);
+				it->batches[i].clear();
+				it->additiveBatches[i].clear();
+			}
+		}
 
-					// Create additive light batches if necessary
-					if (batchQueue.lit
-						&& lightList
-						&& lightList->lightPasses.size() > 1)
-					{
-						newBatch.pass = material->GetPass(batchQueue.additiveIndex);
-						if (!newBatch.pass)
-							continue;
+		if (jobSystem)
+		{
+			jobSystem->ParallelFor(geometries.size(), COLLECT_BATCHES_GRAIN_SIZE, [this](size_t begin, size_t end)
+			{
+				CollectGeometryBatches(begin, end, begin / COLLECT_BATCHES_GRAIN_SIZE);
+			});
+		}
+		else
+			CollectGeometryBatches(0, geometries.size(), 0);
 
-						for (size_t i = 1; i < lightList->lightPasses.size(); ++i)
-						{
-							newBatch.lights = lightList->lightPasses[i];
-							if (batchQueue.sort != SORT_BACK_TO_FRONT)
-							{
-								newBatch.CalculateSortKey();
-								batchQueue.additiveBatches.push_back(newBatch);
-							}
-							else
-							{
-								// In back-to-front mode base and additive batches must be mixed. Manipulate distance to make
-								// the additive batches render later
-								newBatch.distance = node->GetDistance() * 0.99999f;
-								batchQueue.batches.push_back(newBatch);
-							}
-						}
-					}
-				}
+		// Merge the per-chunk batches into the queues in chunk order
+		for (size_t i = 0; i < _currentQueues.size(); ++i)
+		{
+			BatchQueue& batchQueue = *_currentQueues[i];
+			for (auto it = _chunkBatches.begin(); it != _chunkBatches.end(); ++it)
+			{
+				batchQueue.batches.insert(batchQueue.batches.end(), it->batches[i].begin(), it->batches[i].end());
+				batchQueue.additiveBatches.insert(batchQueue.additiveBatches.end(), it->additiveBatches[i].begin(), it->additiveBatches[i].end());
 			}
 		}
 
 		size_t oldSize = _instanceTransforms.size();
 
-		for (auto qIt = currentQueues.begin(); qIt != currentQueues.end(); ++qIt)
+		for (auto qIt = _currentQueues.begin(); qIt != _currentQueues.end(); ++qIt)
 		{
 			BatchQueue& batchQueue = **qIt;
 			batchQueue.Sort(_instanceTransforms);
@@ -594,7 +565,7 @@ namespace Alimer
 		for (size_t i = 0, count = passes.size(); i < count; ++i)
 		{
 			uint8_t passIndex = Material::GetPassIndex(passes[i].name);
-			BatchQueue& batchQueue = batchQueues[passIndex];
+			BatchQueue& batchQueue = GetBatchQueue(passIndex);
 			RenderBatches(batchQueue.batches, _camera, i == 0);
 			RenderBatches(batchQueue.additiveBatches, _camera, false);
 		}
@@ -605,7 +576,7 @@ namespace Alimer
 		ALIMER_PROFILE(RenderBatches);
 
 		uint8_t passIndex = Material::GetPassIndex(pass);
-		BatchQueue& batchQueue = batchQueues[passIndex];
+		BatchQueue& batchQueue = GetBatchQueue(passIndex);
 		RenderBatches(batchQueue.batches, _camera);
 		RenderBatches(batchQueue.additiveBatches, _camera, false);
 	}
@@ -710,62 +681,125 @@ namespace Alimer
 		_faceSelectionTexture2->SetDataLost(false);
 	}
 
-	void Renderer::CollectGeometriesAndLights(
-		std::vector<OctreeNode*>::const_iterator begin,
-		std::vector<OctreeNode*>::const_iterator end,
-		bool inside)
+	void Renderer::CollectGeometriesAndLights(const Octant* octant, bool inside, uint32_t slotIndex)
 	{
-		if (inside)
+		SlotObjects& objects = _slotObjects[slotIndex];
+		uint8_t visible[FRUSTUM_BATCH_SIZE];
+
+		// Test the bounding boxes from the octant's culling data in batches, then check flags and layer mask. Only the
+		// visible nodes are accessed
+		for (size_t i = 0, count = octant->nodes.size(); i < count; i += FRUSTUM_BATCH_SIZE)
 		{
-			for (auto it = begin; it != end; ++it)
+			size_t batchSize = std::min(count - i, FRUSTUM_BATCH_SIZE);
+			if (inside)
+				memset(visible, 1, batchSize);
+			else
+				octant->CullNodes(_frustumSoA, i, batchSize, visible);
+
+			for (size_t j = 0; j < batchSize; ++j)
 			{
-				OctreeNode* node = *it;
-				uint16_t flags = node->GetFlags();
-				if ((flags & NF_ENABLED) && (flags & (NF_GEOMETRY | NF_LIGHT)) && (node->GetLayerMask() & _viewMask))
+				size_t index = i + j;
+				uint16_t flags = octant->nodeFlags[index];
+				if (!visible[j] || !(flags & NF_ENABLED) || !(flags & (NF_GEOMETRY | NF_LIGHT)) || !(octant->layerMasks[index] & _viewMask))
+					continue;
+
+				if (flags & NF_GEOMETRY)
 				{
-					if (flags & NF_GEOMETRY)
-					{
-						GeometryNode* geometry = static_cast<GeometryNode*>(node);
-						geometry->OnPrepareRender(_frameNumber, _camera);
-						geometries.push_back(geometry);
-					}
-					else
-					{
-						Light* light = static_cast<Light*>(node);
-						light->OnPrepareRender(_frameNumber, _camera);
-						_lights.push_back(light);
-					}
+					GeometryNode* geometry = static_cast<GeometryNode*>(octant->nodes[index]);
+					geometry->OnPrepareRender(_frameNumber, _camera);
+					objects.geometries.push_back(geometry);
+				}
+				else
+				{
+					Light* light = static_cast<Light*>(octant->nodes[index]);
+					light->OnPrepareRender(_frameNumber, _camera);
+					objects.lights.push_back(light);
 				}
 			}
 		}
-		else
+	}
+
+	void Renderer::CollectGeometryBatches(size_t begin, size_t end, size_t chunkIndex)
+	{
+		ALIMER_PROFILE(CollectGeometryBatches);
+
+		ChunkBatches& chunkBatches = _chunkBatches[chunkIndex];
+
+		// Loop through geometry nodes
+		for (size_t gIndex = begin; gIndex < end; ++gIndex)
 		{
-			for (auto it = begin; it != end; ++it)
+			GeometryNode* node = geometries[gIndex];
+			LightList* lightList = node->GetLightList();
+
+			Batch newBatch;
+			newBatch.type = node->GetGeometryType();
+			newBatch.worldMatrix = &node->WorldTransform();
+
+			// Loop through node's geometries
+			for (auto bIt = node->GetBatches().begin(), bEnd = node->GetBatches().end(); bIt != bEnd; ++bIt)
 			{
-				OctreeNode* node = *it;
-				uint16_t flags = node->GetFlags();
-				if ((flags & NF_ENABLED)
-					&& (flags & (NF_GEOMETRY | NF_LIGHT))
-					&& (node->GetLayerMask() & _viewMask)
-					&& _frustum.IsInsideFast(node->WorldBoundingBox()))
+				newBatch.geometry = bIt->geometry.Get();
+				Material* material = bIt->material.Get();
+				assert(material);
+
+				// Loop through requested queues
+				for (size_t qIndex = 0; qIndex < _currentQueues.size(); ++qIndex)
 				{
-					if (flags & NF_GEOMETRY)
-					{
-						GeometryNode* geometry = static_cast<GeometryNode*>(node);
-						geometry->OnPrepareRender(_frameNumber, _camera);
-						geometries.push_back(geometry);
-					}
+					const BatchQueue& batchQueue = *_currentQueues[qIndex];
+					std::vector<Batch>& batches = chunkBatches.batches[qIndex];
+
+					newBatch.pass = material->GetPass(batchQueue.baseIndex);
+					// Material may not have the requested pass at all, skip further processing as fast as possible in that case
+					if (!newBatch.pass)
+						continue;
+
+					newBatch.lights = batchQueue.lit ? lightList ? lightList->lightPasses[0] : &ambientLightPass : nullptr;
+					if (batchQueue.sort < SORT_BACK_TO_FRONT)
+						newBatch.CalculateSortKey();
 					else
+						newBatch.distance = node->GetDistance();
+
+					batches.push_back(newBatch);
+
+					// Create additive light batches if necessary
+					if (batchQueue.lit
+						&& lightList
+						&& lightList->lightPasses.size() > 1)
 					{
-						Light* light = static_cast<Light*>(node);
-						light->OnPrepareRender(_frameNumber, _camera);
-						_lights.push_back(light);
+						newBatch.pass = material->GetPass(batchQueue.additiveIndex);
+						if (!newBatch.pass)
+							continue;
+
+						for (size_t i = 1; i < lightList->lightPasses.size(); ++i)
+						{
+							newBatch.lights = lightList->lightPasses[i];
+							if (batchQueue.sort != SORT_BACK_TO_FRONT)
+							{
+								newBatch.CalculateSortKey();
+								chunkBatches.additiveBatches[qIndex].push_back(newBatch);
+							}
+							else
+							{
+								// In back-to-front mode base and additive batches must be mixed. Manipulate distance to make
+								// the additive batches render later
+								newBatch.distance = node->GetDistance() * 0.99999f;
+								batches.push_back(newBatch);
+							}
+						}
 					}
 				}
 			}
 		}
 	}
 
+	BatchQueue& Renderer::GetBatchQueue(uint8_t passIndex)
+	{
+		if (passIndex >= batchQueues.size())
+			batchQueues.resize(passIndex + 1);
+
+		return batchQueues[passIndex];
+	}
+
 	void Renderer::AddLightToNode(GeometryNode* node, Light* light, LightList* lightList)
 	{
 		LightList* oldList = node->GetLightList();
@@ -791,7 +825,7 @@ namespace Alimer
 			}
 			else
 			{
-				LightList* newList = &lightLists[newListKey];
+				LightList* newList = CreateLightList(newListKey);
 				newList->key = newListKey;
 				newList->lights = oldList->lights;
 				newList->lights.push_back(light);
@@ -801,30 +835,164 @@ namespace Alimer
 		}
 	}
 
-	void Renderer::CollectShadowBatches(
-		const std::vector<GeometryNode*>& nodes,
-		BatchQueue& batchQueue,
-		const Frustum& frustum,
-		bool checkShadowCaster,
-		bool checkFrustum)
+	LightList* Renderer::CreateLightList(uint64_t key)
 	{
-		Batch newBatch;
-		newBatch.lights = nullptr;
+		return &lightLists.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+			std::forward_as_tuple(ArenaAllocator<Light*>(&_frameArena))).first->second;
+	}
+
+	void Renderer::ProcessShadowViews(size_t numJobs)
+	{
+		ALIMER_PROFILE(ProcessShadowViews);
 
-		for (auto gIt = nodes.begin(), gEnd = nodes.end(); gIt != gEnd; ++gIt)
+		JobSystem* jobSystem = GetSubsystem<JobSystem>();
+		uint8_t shadowPassIndex = Material::GetPassIndex("shadow");
+
+		// Setup the shadow cameras and find the shadow casters of each view
+		if (jobSystem)
 		{
-			GeometryNode* node = *gIt;
-			if (checkShadowCaster && !(node->GetFlags() & NF_CASTSHADOWS))
-				continue;
-			if (checkFrustum && !frustum.IsInsideFast(node->WorldBoundingBox()))
-				continue;
+			jobSystem->ParallelFor(numJobs, 1, [this](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+					CollectShadowCasters(_shadowViewJobs[i]);
+			});
+		}
+		else
+		{
+			for (size_t i = 0; i < numJobs; ++i)
+				CollectShadowCasters(_shadowViewJobs[i]);
+		}
 
-			// Node was possibly not in the main view. Update geometry first in that case
-			if (node->GetLastFrameNumber() != _frameNumber)
+		// Casters may not have been in the main view. Update their geometry on the main thread, as a node may be a caster
+		// in several views
+		for (size_t i = 0; i < numJobs; ++i)
+		{
+			const std::vector<GeometryNode*>& casters = _shadowViewJobs[i].casters;
+			for (auto gIt = casters.begin(), gEnd = casters.end(); gIt != gEnd; ++gIt)
 			{
-				node->OnPrepareRender(_frameNumber, _camera);
+				GeometryNode* node = *gIt;
+				if (node->GetLastFrameNumber() != _frameNumber)
+					node->OnPrepareRender(_frameNumber, _camera);
 			}
+		}
 
+		// Build and sort the shadow batches
+		if (jobSystem)
+		{
+			jobSystem->ParallelFor(numJobs, 1, [this, shadowPassIndex](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+					CollectShadowBatches(_shadowViewJobs[i], shadowPassIndex);
+			});
+		}
+		else
+		{
+			for (size_t i = 0; i < numJobs; ++i)
+				CollectShadowBatches(_shadowViewJobs[i], shadowPassIndex);
+		}
+
+		// Merge the per-view instance transforms and mark shadow maps for rendering only if they have a view with some
+		// batches. Lights that did not get any shadow batches are converted to unshadowed
+		bool hasShadowBatches = false;
+
+		for (size_t i = 0; i < numJobs; ++i)
+		{
+			ShadowViewJob& job = _shadowViewJobs[i];
+			ShadowView* view = job.view;
+			BatchQueue& shadowQueue = view->shadowQueue;
+
+			if (job.instanceTransforms.size())
+			{
+				uint32_t instanceOffset = static_cast<uint32_t>(_instanceTransforms.size());
+				for (auto bIt = shadowQueue.batches.begin(), bEnd = shadowQueue.batches.end(); bIt != bEnd; ++bIt)
+				{
+					if (bIt->type == GEOM_INSTANCED)
+						bIt->instanceStart += instanceOffset;
+				}
+				_instanceTransforms.insert(_instanceTransforms.end(), job.instanceTransforms.begin(), job.instanceTransforms.end());
+			}
+
+			if (shadowQueue.batches.size())
+			{
+				shadowMaps[job.shadowMapIndex].shadowViews.push_back(view);
+				shadowMaps[job.shadowMapIndex].used = true;
+				hasShadowBatches = true;
+			}
+
+			if (i + 1 == numJobs || _shadowViewJobs[i + 1].view->light != view->light)
+			{
+				if (!hasShadowBatches)
+					view->light->SetShadowMap(nullptr);
+
+				hasShadowBatches = false;
+			}
+		}
+	}
+
+	void Renderer::CollectShadowCasters(ShadowViewJob& job)
+	{
+		ALIMER_PROFILE(CollectShadowCasters);
+
+		ShadowView* view = job.view;
+		Light* light = view->light;
+		const std::vector<GeometryNode*>& litGeometries = _shadowLitGeometries[job.litGeometriesIndex];
+
+		light->SetupShadowView(_camera, view, job.viewIndex);
+		job.frustum = view->shadowCamera.WorldFrustum();
+		job.casters.clear();
+
+		switch (light->GetLightType())
+		{
+		case LIGHT_DIRECTIONAL:
+			// Directional light needs a new frustum query for each split, as the shadow cameras are typically far outside
+			// the main view
+			_octree->FindNodes(reinterpret_cast<std::vector<OctreeNode*>&>(job.casters), job.frustum, NF_ENABLED | NF_GEOMETRY |
+				NF_CASTSHADOWS, light->LightMask());
+			break;
+
+		case LIGHT_POINT:
+			// Check which lit geometries are shadow casters and inside each shadow frustum. First check whether the
+			// shadow frustum is inside the view at all
+			/// \todo Could use a frustum-frustum test for more accuracy
+			if (_frustum.IsInsideFast(BoundingBox(job.frustum)))
+			{
+				for (auto gIt = litGeometries.begin(), gEnd = litGeometries.end(); gIt != gEnd; ++gIt)
+				{
+					GeometryNode* node = *gIt;
+					if ((node->GetFlags() & NF_CASTSHADOWS) && job.frustum.IsInsideFast(node->WorldBoundingBox()))
+						job.casters.push_back(node);
+				}
+			}
+			break;
+
+		case LIGHT_SPOT:
+			// For spot light only need to check which lit geometries are shadow casters
+			for (auto gIt = litGeometries.begin(), gEnd = litGeometries.end(); gIt != gEnd; ++gIt)
+			{
+				GeometryNode* node = *gIt;
+				if (node->GetFlags() & NF_CASTSHADOWS)
+					job.casters.push_back(node);
+			}
+			break;
+		}
+	}
+
+	void Renderer::CollectShadowBatches(ShadowViewJob& job, uint8_t passIndex)
+	{
+		ALIMER_PROFILE(CollectShadowBatches);
+
+		BatchQueue& shadowQueue = job.view->shadowQueue;
+		shadowQueue.sort = SORT_STATE;
+		shadowQueue.lit = false;
+		shadowQueue.baseIndex = passIndex;
+		shadowQueue.additiveIndex = 0;
+
+		Batch newBatch;
+		newBatch.lights = nullptr;
+
+		for (auto gIt = job.casters.begin(), gEnd = job.casters.end(); gIt != gEnd; ++gIt)
+		{
+			GeometryNode* node = *gIt;
 			newBatch.type = node->GetGeometryType();
 			newBatch.worldMatrix = &node->WorldTransform();
 
@@ -835,15 +1003,19 @@ namespace Alimer
 				Material* material = bIt->material.Get();
 				assert(material);
 
-				newBatch.pass = material->GetPass(batchQueue.baseIndex);
+				newBatch.pass = material->GetPass(shadowQueue.baseIndex);
 				// Material may not have the requested pass at all, skip further processing as fast as possible in that case
 				if (!newBatch.pass)
 					continue;
 
 				newBatch.CalculateSortKey();
-				batchQueue.batches.push_back(newBatch);
+				shadowQueue.batches.push_back(newBatch);
 			}
 		}
+
+		// Instances are built into the job's own transforms, which are merged on the main thread
+		job.instanceTransforms.clear();
+		shadowQueue.Sort(job.instanceTransforms);
 	}
 
 	void Renderer::RenderBatches(
@@ -1046,14 +1218,10 @@ namespace Alimer
 		ALIMER_PROFILE(LoadPassShaders);
 
 		ResourceCache* cache = GetSubsystem<ResourceCache>();
-		// Use different extensions for GLSL & HLSL shaders
-#ifdef ALIMER_OPENGL
-		pass->shaders[ecast(ShaderStage::Vertex)] = cache->LoadResource<Shader>(pass->GetShaderName(ShaderStage::Vertex) + ".vert");
-		pass->shaders[ecast(ShaderStage::Fragment)] = cache->LoadResource<Shader>(pass->GetShaderName(ShaderStage::Fragment) + ".frag");
-#else
-		pass->shaders[ecast(ShaderStage::Vertex)] = cache->LoadResource<Shader>(pass->GetShaderName(ShaderStage::Vertex) + ".vs");
-		pass->shaders[ecast(ShaderStage::Fragment)] = cache->LoadResource<Shader>(pass->GetShaderName(ShaderStage::Fragment) + ".ps");
-#endif
+		pass->shaders[ecast(ShaderStage::Vertex)] = cache->LoadResource<Shader>(
+			Pass::GetShaderFileName(pass->GetShaderName(ShaderStage::Vertex), ShaderStage::Vertex));
+		pass->shaders[ecast(ShaderStage::Fragment)] = cache->LoadResource<Shader>(
+			Pass::GetShaderFileName(pass->GetShaderName(ShaderStage::Fragment), ShaderStage::Fragment));
 
 		pass->shadersLoaded = true;
 	}
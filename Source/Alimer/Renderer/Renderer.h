@@ -25,7 +25,7 @@
 
 #include "../Graphics/Texture.h"
 #include "../Math/Color.h"
-#include "../Math/Frustum.h"
+#include "../Math/FrustumSoA.h"
 #include "../Resource/Image.h"
 #include "Batch.h"
 
@@ -34,6 +34,7 @@ namespace Alimer
 	class ConstantBuffer;
 	class GeometryNode;
 	class Octree;
+	struct Octant;
 	class Scene;
 	class VertexBuffer;
 
@@ -130,16 +131,45 @@ namespace Alimer
 		SharedPtr<ConstantBuffer> psLightConstantBuffer;
 
 	private:
+		/// Work item for setting up a shadow view and collecting its batches.
+		struct ShadowViewJob
+		{
+			/// Shadow view.
+			ShadowView* view;
+			/// Index of the view within the light's views.
+			size_t viewIndex;
+			/// Shadow map the view is allocated from.
+			size_t shadowMapIndex;
+			/// Index of the light's lit geometries.
+			size_t litGeometriesIndex;
+			/// Shadow camera frustum.
+			Frustum frustum;
+			/// Shadow casters.
+			std::vector<GeometryNode*> casters;
+			/// Instance transforms of the view's batches, merged after sorting.
+			std::vector<Matrix3x4> instanceTransforms;
+		};
+
 		/// Initialize. Needs the Graphics subsystem and rendering context to exist.
 		void Initialize();
 		/// (Re)define face selection textures.
 		void DefineFaceSelectionTextures();
-		/// Octree callback for collecting lights and geometries.
-		void CollectGeometriesAndLights(std::vector<OctreeNode*>::const_iterator begin, std::vector<OctreeNode*>::const_iterator end, bool inside);
+		/// Octree callback for collecting lights and geometries from an octant. Called from worker threads, stores the results per query slot.
+		void CollectGeometriesAndLights(const Octant* octant, bool inside, uint32_t slotIndex);
+		/// Collect batches from a range of visible geometries into the batch vectors of a chunk.
+		void CollectGeometryBatches(size_t begin, size_t end, size_t chunkIndex);
+		/// Return the batch queue for a pass index, creating it if necessary.
+		BatchQueue& GetBatchQueue(uint8_t passIndex);
 		/// Assign a light list to a node. Creates new light lists as necessary to handle multiple lights.
 		void AddLightToNode(GeometryNode* node, Light* light, LightList* lightList);
-		/// Collect shadow caster batches.
-		void CollectShadowBatches(const std::vector<GeometryNode*>& nodes, BatchQueue& batchQueue, const Frustum& frustum, bool checkShadowCaster, bool checkFrustum);
+		/// Create a light list with the given key into the frame arena. Return the existing list if already created.
+		LightList* CreateLightList(uint64_t key);
+		/// Setup the allocated shadow views, collect and sort their shadow batches in parallel.
+		void ProcessShadowViews(size_t numJobs);
+		/// Setup a shadow view's camera and find its shadow casters. Called from worker threads.
+		void CollectShadowCasters(ShadowViewJob& job);
+		/// Collect and sort shadow caster batches of a view. Called from worker threads.
+		void CollectShadowBatches(ShadowViewJob& job, uint8_t passIndex);
 		/// Render batches from a specific queue and camera.
 		void RenderBatches(const std::vector<Batch>& batches, Camera* camera, bool setPerFrameContants = true, bool overrideDepthBias = false, int depthBias = 0, float slopeScaledDepthBias = 0.0f);
 		/// Load shaders for a pass.
@@ -157,22 +187,59 @@ namespace Alimer
 		Octree* _octree;
 		/// Camera's view frustum.
 		Frustum _frustum;
+		/// Camera's view frustum planes for batched culling.
+		FrustumSoA _frustumSoA;
 		/// Camera's view mask.
 		uint32_t _viewMask;
 		/// Geometries in frustum.
 		std::vector<GeometryNode*> geometries;
 		/// Lights in frustum.
 		std::vector<Light*> _lights;
-		/// Batch queues per pass.
-		std::map<uint8_t, BatchQueue> batchQueues;
+
+		/// Per-slot results of the visible object query.
+		struct SlotObjects
+		{
+			/// Geometries in frustum.
+			std::vector<GeometryNode*> geometries;
+			/// Lights in frustum.
+			std::vector<Light*> lights;
+			/// Padding to keep the slots' vectors on separate cache lines.
+			uint8_t padding[64];
+		};
+
+		/// Visible objects per octree query slot, merged in slot order after the query.
+		std::vector<SlotObjects> _slotObjects;
+		/// Per-chunk batches for each of the currently collected queues, merged in chunk order before sorting.
+		struct ChunkBatches
+		{
+			/// Base batches per queue.
+			std::vector<std::vector<Batch>> batches;
+			/// Additive lighting batches per queue.
+			std::vector<std::vector<Batch>> additiveBatches;
+			/// Padding to keep the chunks' vectors on separate cache lines.
+			uint8_t padding[64];
+		};
+
+		/// Batch queues indexed by pass index.
+		std::vector<BatchQueue> batchQueues;
+		/// Queues being collected by the current CollectBatches() call.
+		std::vector<BatchQueue*> _currentQueues;
+		/// Per-chunk collected batches.
+		std::vector<ChunkBatches> _chunkBatches;
 		/// Instance transforms for uploading to the instance vertex buffer.
 		std::vector<Matrix3x4> _instanceTransforms;
 		/// Lit geometries query result.
 		std::vector<GeometryNode*> litGeometries;
+		/// Lit geometries of each shadowed light, used by the shadow view jobs.
+		std::vector<std::vector<GeometryNode*>> _shadowLitGeometries;
+		/// Shadow view jobs.
+		std::vector<ShadowViewJob> _shadowViewJobs;
+		/// Per-view memory for the light lists and light passes.
+		FrameArena _frameArena;
 		/// %Light lists.
-		std::map<uint64_t, LightList> lightLists;
+		std::map<uint64_t, LightList, std::less<uint64_t>, ArenaAllocator<std::pair<const uint64_t, LightList> > > lightLists;
 		/// %Light passes.
-		std::map<uint64_t, LightPass> lightPasses;
+		std::map<uint64_t, LightPass, std::less<uint64_t>, ArenaAllocator<std::pair<const uint64_t, LightPass> > > lightPasses;
 		/// Ambient only light pass.
 		LightPass ambientLightPass;
 		/// Current frame number.
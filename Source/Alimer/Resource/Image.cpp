@@ -445,6 +445,14 @@ namespace Alimer
 			FreePixelData(pixelData);
 		}
 
+		uint64_t memoryUse = 0;
+		for (uint32_t i = 0; i < _mipLevels; ++i)
+		{
+			ImageLevel level = GetLevel(i);
+			memoryUse += level.rows * level.rowSize;
+		}
+		SetMemoryUse(memoryUse);
+
 		return true;
 	}
 
@@ -39,6 +39,8 @@ namespace Alimer
 
 		size_t dataSize = source.Size() - source.Position();
 		std::unique_ptr<char[]> buffer(new char[dataSize]);
+		// The parsed tree is roughly the size of the text
+		SetMemoryUse(dataSize);
 		if (source.Read(buffer.get(), dataSize) != dataSize)
 			return false;
 
@@ -57,4 +57,10 @@ namespace Alimer
 		_name = newName;
 		_nameHash = StringHash(newName);
 	}
+
+	void Resource::SetMemoryUse(uint64_t cpuBytes, uint64_t gpuBytes)
+	{
+		_cpuMemoryUse = cpuBytes;
+		_gpuMemoryUse = gpuBytes;
+	}
 }
@@ -27,17 +27,41 @@ namespace Alimer
 		bool Load(Stream& source);
 		/// Set name of the resource, usually the same as the file being loaded from.
 		void SetName(const std::string& newName);
+		/// Set whether the resource is being loaded in the background. Called by the resource cache.
+		void SetBackgroundLoading(bool enable) { _backgroundLoading = enable; }
+		/// Set approximate memory use in bytes, separately for CPU and GPU memory. Called by subclasses when loading.
+		void SetMemoryUse(uint64_t cpuBytes, uint64_t gpuBytes = 0);
+		/// Mark the resource used. Called by the resource cache for least recently used eviction.
+		void SetLastUse(uint64_t stamp) { _lastUse = stamp; }
 
 		/// Return name of the resource.
 		const std::string& GetName() const { return _name; }
 		/// Return name hash of the resource.
 		const StringHash& GetNameHash() const { return _nameHash; }
+		/// Return whether the resource is being loaded in the background. If true, BeginLoad() should queue dependencies with ResourceCache::BackgroundLoadResource().
+		bool IsBackgroundLoading() const { return _backgroundLoading; }
+		/// Return approximate CPU memory use in bytes.
+		uint64_t GetCPUMemoryUse() const { return _cpuMemoryUse; }
+		/// Return approximate GPU memory use in bytes.
+		uint64_t GetGPUMemoryUse() const { return _gpuMemoryUse; }
+		/// Return approximate total memory use in bytes.
+		uint64_t GetMemoryUse() const { return _cpuMemoryUse + _gpuMemoryUse; }
+		/// Return the resource cache use stamp. Larger is more recent.
+		uint64_t GetLastUse() const { return _lastUse; }
 
 	private:
 		/// Resource name.
 		std::string _name;
 		/// Resource name hash.
 		StringHash _nameHash;
+		/// Background loading flag.
+		bool _backgroundLoading = false;
+		/// CPU memory use in bytes.
+		uint64_t _cpuMemoryUse = 0;
+		/// GPU memory use in bytes.
+		uint64_t _gpuMemoryUse = 0;
+		/// Last use stamp.
+		uint64_t _lastUse = 0;
 	};
 
 	/// Return name from a resource pointer.
@@ -21,25 +21,40 @@
 // THE SOFTWARE.
 //
 
+#include "../Base/Timer.h"
 #include "../Debug/Log.h"
 #include "../Debug/Profiler.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
+#include "../IO/MappedFile.h"
+#include "../IO/PackageFile.h"
 #include "Image.h"
 #include "JSONFile.h"
 #include "ResourceCache.h"
 
+#include <algorithm>
+
 using namespace std;
 
 namespace Alimer
 {
-	ResourceCache::ResourceCache()
+	ResourceCache::ResourceCache() :
+		useStamp(0),
+		memoryMapping(false),
+		mainThreadId(this_thread::get_id()),
+		backgroundLoadBudget(5)
 	{
 		RegisterSubsystem(this);
 	}
 
 	ResourceCache::~ResourceCache()
 	{
+		// Background jobs refer to the load items, so they must finish first
+		JobSystem* jobSystem = GetSubsystem<JobSystem>();
+		if (jobSystem)
+			jobSystem->Wait(&backgroundJobs);
+		backgroundLoadItems.clear();
+
 		UnloadAllResources(true);
 		RemoveSubsystem(this);
 	}
@@ -55,6 +70,7 @@ namespace Alimer
 		}
 
 		string fixedPath = SanitateResourceDirName(pathName);
+		unique_lock<shared_mutex> lock(searchPathMutex);
 
 		// Check that the same path does not already exist
 		for (size_t i = 0; i < resourceDirs.size(); ++i)
@@ -86,7 +102,7 @@ namespace Alimer
 			return false;
 		}
 
-		resources[std::make_pair(resource->GetType(), StringHash(resource->GetName()))] = resource;
+		StoreResource(MakeResourceKey(resource->GetType(), resource->GetNameHash()), resource);
 		return true;
 	}
 
@@ -94,6 +110,7 @@ namespace Alimer
 	{
 		// Convert path to absolute
 		string fixedPath = SanitateResourceDirName(pathName);
+		unique_lock<shared_mutex> lock(searchPathMutex);
 
 		for (size_t i = 0; i < resourceDirs.size(); ++i)
 		{
@@ -106,16 +123,80 @@ namespace Alimer
 		}
 	}
 
+	bool ResourceCache::AddPackageFile(PackageFile* package, bool addFirst)
+	{
+		if (!package || !package->IsOpen())
+		{
+			ALIMER_LOGERROR("Could not add unopened package file");
+			return false;
+		}
+
+		unique_lock<shared_mutex> lock(searchPathMutex);
+
+		for (auto it = packageFiles.begin(); it != packageFiles.end(); ++it)
+		{
+			if (*it == package)
+				return true;
+		}
+
+		if (addFirst)
+			packageFiles.insert(packageFiles.begin(), SharedPtr<PackageFile>(package));
+		else
+			packageFiles.push_back(SharedPtr<PackageFile>(package));
+
+		ALIMER_LOGINFO("Added resource package '{}'", package->GetName());
+		return true;
+	}
+
+	bool ResourceCache::AddPackageFile(const string& fileName, bool addFirst)
+	{
+		SharedPtr<PackageFile> package(new PackageFile());
+		if (!package->Open(fileName))
+			return false;
+
+		return AddPackageFile(package, addFirst);
+	}
+
+	void ResourceCache::RemovePackageFile(PackageFile* package)
+	{
+		unique_lock<shared_mutex> lock(searchPathMutex);
+
+		for (auto it = packageFiles.begin(); it != packageFiles.end(); ++it)
+		{
+			if (*it == package)
+			{
+				ALIMER_LOGINFO("Removed resource package " + package->GetName());
+				packageFiles.erase(it);
+				return;
+			}
+		}
+	}
+
+	void ResourceCache::RemovePackageFile(const string& fileName)
+	{
+		unique_lock<shared_mutex> lock(searchPathMutex);
+
+		for (auto it = packageFiles.begin(); it != packageFiles.end(); ++it)
+		{
+			if (!str::Compare((*it)->GetName(), fileName, false))
+			{
+				ALIMER_LOGINFO("Removed resource package " + (*it)->GetName());
+				packageFiles.erase(it);
+				return;
+			}
+		}
+	}
+
 	void ResourceCache::UnloadResource(StringHash type, const string& name, bool force)
 	{
-		auto key = std::make_pair(type, StringHash(name));
+		ResourceKey key = MakeResourceKey(type, StringHash(name));
 		auto it = resources.find(key);
 		if (it == resources.end())
 			return;
 
 		Resource* resource = it->second;
 		if (resource->Refs() == 1 || force)
-			resources.erase(key);
+			EraseResource(it);
 	}
 
 	void ResourceCache::UnloadResources(StringHash type, bool force)
@@ -128,12 +209,12 @@ namespace Alimer
 			for (auto it = resources.begin(); it != resources.end();)
 			{
 				auto current = it++;
-				if (current->first.first == type)
+				if (GetResourceKeyType(current->first) == type)
 				{
 					Resource* resource = current->second;
 					if (resource->Refs() == 1 || force)
 					{
-						resources.erase(current);
+						EraseResource(current);
 						++unloaded;
 					}
 				}
@@ -154,12 +235,12 @@ namespace Alimer
 			for (auto it = resources.begin(); it != resources.end();)
 			{
 				auto current = it++;
-				if (current->first.first == type)
+				if (GetResourceKeyType(current->first) == type)
 				{
 					Resource* resource = current->second;
 					if (str::StartsWith(resource->GetName(), partialName) && (resource->Refs() == 1 || force))
 					{
-						resources.erase(current);
+						EraseResource(current);
 						++unloaded;
 					}
 				}
@@ -183,7 +264,7 @@ namespace Alimer
 				Resource* resource = current->second;
 				if (str::StartsWith(resource->GetName(), partialName) && (!resource->Refs() == 1 || force))
 				{
-					resources.erase(current);
+					EraseResource(current);
 					++unloaded;
 				}
 			}
@@ -206,7 +287,7 @@ namespace Alimer
 				Resource* resource = current->second;
 				if (resource->Refs() == 1 || force)
 				{
-					resources.erase(current);
+					EraseResource(current);
 					++unloaded;
 				}
 			}
@@ -222,7 +303,135 @@ namespace Alimer
 			return false;
 
 		std::unique_ptr<Stream> stream = OpenResource(resource->GetName());
-		return stream ? resource->Load(*stream) : false;
+		if (!stream)
+			return false;
+
+		// Account the memory use again, as it may change with the new data
+		ResourceKey key = MakeResourceKey(resource->GetType(), resource->GetNameHash());
+		auto it = resources.find(key);
+		bool cached = it != resources.end() && it->second == resource;
+		SharedPtr<Resource> guard(resource);
+		if (cached)
+			EraseResource(it);
+
+		bool success = resource->Load(*stream);
+
+		if (cached)
+			StoreResource(key, resource);
+		return success;
+	}
+
+	void ResourceCache::SetMemoryBudget(StringHash type, uint64_t budget)
+	{
+		resourceGroups[type].memoryBudget = budget;
+	}
+
+	void ResourceCache::LogMemoryUse() const
+	{
+		for (auto it = resourceGroups.begin(); it != resourceGroups.end(); ++it)
+		{
+			const ResourceGroup& group = it->second;
+			ALIMER_LOGINFO("{}: {} resources, {} KB CPU, {} KB GPU, budget {} KB, {} evicted",
+				Object::GetTypeNameFromType(it->first),
+				group.numResources,
+				group.cpuMemoryUse / 1024,
+				group.gpuMemoryUse / 1024,
+				group.memoryBudget / 1024,
+				group.numEvicted);
+		}
+
+		ALIMER_LOGINFO("Total: {} KB", GetTotalMemoryUse() / 1024);
+	}
+
+	uint64_t ResourceCache::GetMemoryBudget(StringHash type) const
+	{
+		auto it = resourceGroups.find(type);
+		return it != resourceGroups.end() ? it->second.memoryBudget : 0;
+	}
+
+	uint64_t ResourceCache::GetMemoryUse(StringHash type) const
+	{
+		auto it = resourceGroups.find(type);
+		return it != resourceGroups.end() ? it->second.GetMemoryUse() : 0;
+	}
+
+	uint64_t ResourceCache::GetTotalMemoryUse() const
+	{
+		uint64_t total = 0;
+		for (auto it = resourceGroups.begin(); it != resourceGroups.end(); ++it)
+			total += it->second.GetMemoryUse();
+		return total;
+	}
+
+	void ResourceCache::StoreResource(ResourceKey key, Resource* resource)
+	{
+		auto it = resources.find(key);
+		if (it != resources.end())
+		{
+			if (it->second == resource)
+				return;
+			EraseResource(it);
+		}
+
+		resources[key] = resource;
+
+		ResourceGroup& group = resourceGroups[resource->GetType()];
+		group.cpuMemoryUse += resource->GetCPUMemoryUse();
+		group.gpuMemoryUse += resource->GetGPUMemoryUse();
+		++group.numResources;
+
+		TouchResource(resource);
+	}
+
+	ResourceMap::Iterator ResourceCache::EraseResource(const ResourceMap::Iterator& it)
+	{
+		Resource* resource = it->second;
+		ResourceGroup& group = resourceGroups[resource->GetType()];
+		group.cpuMemoryUse -= std::min(group.cpuMemoryUse, resource->GetCPUMemoryUse());
+		group.gpuMemoryUse -= std::min(group.gpuMemoryUse, resource->GetGPUMemoryUse());
+		--group.numResources;
+
+		return resources.erase(it);
+	}
+
+	void ResourceCache::CheckMemoryBudget(StringHash type)
+	{
+		auto groupIt = resourceGroups.find(type);
+		if (groupIt == resourceGroups.end())
+			return;
+
+		ResourceGroup& group = groupIt->second;
+		if (!group.memoryBudget || group.GetMemoryUse() <= group.memoryBudget)
+			return;
+
+		ALIMER_PROFILE(EvictResources);
+
+		// Only resources referenced by the cache alone can be unloaded. Oldest use first
+		std::vector<std::pair<uint64_t, ResourceKey> > candidates;
+		for (auto it = resources.begin(); it != resources.end(); ++it)
+		{
+			Resource* resource = it->second;
+			if (resource->GetType() == type && resource->Refs() == 1)
+				candidates.push_back(std::make_pair(resource->GetLastUse(), it->first));
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		for (auto it = candidates.begin(); it != candidates.end() && group.GetMemoryUse() > group.memoryBudget; ++it)
+		{
+			auto resourceIt = resources.find(it->second);
+			if (resourceIt == resources.end())
+				continue;
+
+			ALIMER_LOGDEBUG("Unloading resource {} to stay within memory budget", resourceIt->second->GetName());
+			EraseResource(resourceIt);
+			++group.numEvicted;
+		}
+	}
+
+	Resource* ResourceCache::TouchResource(Resource* resource)
+	{
+		resource->SetLastUse(++useStamp);
+		return resource;
 	}
 
 	std::unique_ptr<Stream> ResourceCache::OpenResource(const string& nameIn)
@@ -230,20 +439,31 @@ namespace Alimer
 		string name = SanitateResourceName(nameIn);
 		std::unique_ptr<Stream> ret;
 
+		// Called from worker threads during background loading, while the main thread may add or remove search paths
+		shared_lock<shared_mutex> lock(searchPathMutex);
+
+		// Packages first, as their lookup does not touch the filesystem
+		for (size_t i = 0; i < packageFiles.size(); ++i)
+		{
+			ret = packageFiles[i]->OpenEntry(name);
+			if (ret)
+				return ret;
+		}
+
 		for (size_t i = 0; i < resourceDirs.size(); ++i)
 		{
 			if (FileExists(resourceDirs[i] + name))
 			{
 				// Construct the file first with full path, then rename it to not contain the resource path,
 				// so that the file's name can be used in further OpenResource() calls (for example over the network)
-				ret = std::make_unique<File>(resourceDirs[i] + name);
+				ret = OpenFile(resourceDirs[i] + name);
 				break;
 			}
 		}
 
 		// Fallback using absolute path
 		if (!ret)
-			ret = std::make_unique<File>(name);
+			ret = OpenFile(name);
 
 		if (!ret->IsReadable())
 		{
@@ -254,10 +474,34 @@ namespace Alimer
 		return ret;
 	}
 
+	void ResourceCache::SetMemoryMapping(bool enable)
+	{
+		// Read by OpenFile() on worker threads
+		unique_lock<shared_mutex> lock(searchPathMutex);
+		memoryMapping = enable;
+	}
+
+	std::unique_ptr<Stream> ResourceCache::OpenFile(const string& fileName) const
+	{
+		if (memoryMapping)
+		{
+			std::unique_ptr<MappedFile> mappedFile = std::make_unique<MappedFile>(fileName);
+			if (mappedFile->IsOpen())
+				return mappedFile;
+		}
+
+		return std::make_unique<File>(fileName);
+	}
+
 	Resource* ResourceCache::LoadResource(
 		StringHash type,
 		const std::string& name_)
 	{
+		// Resources are stored by their sanitated name, so if the name is found as is, sanitation can be skipped
+		auto it = resources.find(MakeResourceKey(type, StringHash(name_)));
+		if (it != resources.end())
+			return TouchResource(it->second);
+
 		std::string name = SanitateResourceName(name_);
 
 		// If empty name, return null pointer immediately without logging an error
@@ -265,23 +509,22 @@ namespace Alimer
 			return nullptr;
 
 		// Check for existing resource
-		auto key = std::make_pair(type, StringHash(name));
-		auto it = resources.find(key);
+		ResourceKey key = MakeResourceKey(type, StringHash(name));
+		it = resources.find(key);
 		if (it != resources.end())
-			return it->second;
+			return TouchResource(it->second);
 
-		SharedPtr<Object> newObject = Create(type);
-		if (!newObject)
+		// If loading in the background, finish the load now
+		if (backgroundLoadItems.find(key) != backgroundLoadItems.end())
 		{
-			ALIMER_LOGERROR("Could not load unknown resource type {}", Object::GetTypeNameFromType(type));
-			return nullptr;
+			WaitForBackgroundResource(key);
+			it = resources.find(key);
+			return it != resources.end() ? TouchResource(it->second) : nullptr;
 		}
-		Resource* newResource = dynamic_cast<Resource*>(newObject.Get());
+
+		SharedPtr<Resource> newResource = CreateResource(type);
 		if (!newResource)
-		{
-			ALIMER_LOGERROR("Type {} is not a resource", Object::GetTypeNameFromType(type));
 			return nullptr;
-		}
 
 		// Attempt to load the resource
 		std::unique_ptr<Stream> stream = OpenResource(name);
@@ -294,10 +537,259 @@ namespace Alimer
 			return nullptr;
 
 		// Store to cache
-		resources[key] = newResource;
+		StoreResource(key, newResource);
+		return newResource;
+	}
+
+	Resource* ResourceCache::LoadResource(StringHash type, StringHash nameHash)
+	{
+		ResourceKey key = MakeResourceKey(type, nameHash);
+		auto it = resources.find(key);
+		if (it != resources.end())
+			return TouchResource(it->second);
+
+		if (backgroundLoadItems.find(key) != backgroundLoadItems.end())
+		{
+			WaitForBackgroundResource(key);
+			it = resources.find(key);
+			if (it != resources.end())
+				return TouchResource(it->second);
+		}
+
+		return nullptr;
+	}
+
+	bool ResourceCache::BackgroundLoadResource(StringHash type, const string& nameIn, Resource* caller)
+	{
+		// Resources request their dependencies from BeginLoad() in worker threads. Queue for the main thread, which owns the cache
+		if (this_thread::get_id() != mainThreadId)
+		{
+			lock_guard<mutex> lock(backgroundMutex);
+			backgroundRequests.push_back({ type, nameIn, caller });
+			return true;
+		}
+
+		string name = SanitateResourceName(nameIn);
+		if (name.empty())
+			return false;
+
+		ResourceKey key = MakeResourceKey(type, StringHash(name));
+		if (resources.find(key) != resources.end())
+			return true;
+
+		auto it = backgroundLoadItems.find(key);
+		if (it == backgroundLoadItems.end())
+		{
+			SharedPtr<Resource> newResource = CreateResource(type);
+			if (!newResource)
+				return false;
+
+			ALIMER_LOGDEBUG("Background loading resource {}", name);
+			newResource->SetName(name);
+			newResource->SetBackgroundLoading(true);
+
+			std::unique_ptr<BackgroundLoadItem> newItem = std::make_unique<BackgroundLoadItem>();
+			newItem->cache = this;
+			newItem->resource = newResource;
+			BackgroundLoadItem* item = newItem.get();
+			it = backgroundLoadItems.insert(std::make_pair(key, std::move(newItem))).first;
+
+			// Without a job system, BeginLoad() runs immediately and only EndLoad() is deferred
+			JobSystem* jobSystem = GetSubsystem<JobSystem>();
+			if (jobSystem)
+				jobSystem->Submit(Job(&ResourceCache::BackgroundLoadJob, item), &backgroundJobs);
+			else
+				BackgroundLoadJob(item, 0, 0);
+		}
+
+		// Delay the caller's EndLoad() until this resource has finished
+		if (caller)
+		{
+			ResourceKey callerKey = MakeResourceKey(caller->GetType(), caller->GetNameHash());
+			auto callerIt = backgroundLoadItems.find(callerKey);
+			if (callerIt != backgroundLoadItems.end() && callerKey != key && !it->second->dependencies.count(callerKey))
+			{
+				callerIt->second->dependencies.insert(key);
+				it->second->dependents.insert(callerKey);
+			}
+		}
+
+		return true;
+	}
+
+	void ResourceCache::FinishBackgroundResources()
+	{
+		if (backgroundLoadItems.empty())
+			return;
+
+		ALIMER_PROFILE(FinishBackgroundResources);
+
+		// Without worker threads the jobs run only when waited on
+		JobSystem* jobSystem = GetSubsystem<JobSystem>();
+		if (jobSystem && jobSystem->GetNumThreads() <= 1)
+			jobSystem->Wait(&backgroundJobs);
+
+		ProcessBackgroundResources(static_cast<uint64_t>(backgroundLoadBudget) * 1000);
+	}
+
+	void ResourceCache::Update()
+	{
+		// Unload before finishing new resources, so that resources finished this frame survive until the next Update()
+		// even if nothing has referenced them yet
+		for (auto it = resourceGroups.begin(); it != resourceGroups.end(); ++it)
+			CheckMemoryBudget(it->first);
+
+		FinishBackgroundResources();
+	}
+
+	void ResourceCache::SetBackgroundLoadBudget(int milliseconds)
+	{
+		backgroundLoadBudget = milliseconds > 0 ? milliseconds : 0;
+	}
+
+	SharedPtr<Resource> ResourceCache::CreateResource(StringHash type)
+	{
+		SharedPtr<Object> newObject = Create(type);
+		if (!newObject)
+		{
+			ALIMER_LOGERROR("Could not load unknown resource type {}", Object::GetTypeNameFromType(type));
+			return nullptr;
+		}
+		Resource* newResource = dynamic_cast<Resource*>(newObject.Get());
+		if (!newResource)
+		{
+			ALIMER_LOGERROR("Type {} is not a resource", Object::GetTypeNameFromType(type));
+			return nullptr;
+		}
+
 		return newResource;
 	}
 
+	size_t ResourceCache::ProcessBackgroundResources(uint64_t maxMicroseconds)
+	{
+		Timer timer;
+
+		std::vector<BackgroundLoadRequest> requests;
+		std::vector<BackgroundLoadItem*> completed;
+		{
+			lock_guard<mutex> lock(backgroundMutex);
+			requests.swap(backgroundRequests);
+			completed.swap(backgroundCompleted);
+		}
+
+		// Register the dependencies before marking their callers loaded. A caller signals completion after its requests, so
+		// the requests of every completed item are in this or an earlier batch
+		for (auto it = requests.begin(); it != requests.end(); ++it)
+			BackgroundLoadResource(it->type, it->name, it->caller);
+		for (auto it = completed.begin(); it != completed.end(); ++it)
+			(*it)->loaded = true;
+
+		// Finishing a resource may make its dependents ready, so repeat until nothing is finished. Collect the keys first,
+		// as EndLoad() may load further resources and modify the items
+		size_t numFinished = 0;
+		std::vector<ResourceKey> ready;
+		for (;;)
+		{
+			ready.clear();
+			for (auto it = backgroundLoadItems.begin(); it != backgroundLoadItems.end(); ++it)
+			{
+				if (it->second->loaded && it->second->dependencies.empty())
+					ready.push_back(it->first);
+			}
+
+			if (ready.empty())
+				return numFinished;
+
+			for (auto it = ready.begin(); it != ready.end(); ++it)
+			{
+				FinishBackgroundResource(*it);
+				++numFinished;
+
+				if (maxMicroseconds && timer.GetMicroseconds() >= maxMicroseconds)
+					return numFinished;
+			}
+		}
+	}
+
+	void ResourceCache::FinishBackgroundResource(ResourceKey key)
+	{
+		auto it = backgroundLoadItems.find(key);
+		if (it == backgroundLoadItems.end())
+			return;
+
+		std::unique_ptr<BackgroundLoadItem> item = std::move(it->second);
+		backgroundLoadItems.erase(it);
+
+		SharedPtr<Resource> resource = item->resource;
+		resource->SetBackgroundLoading(false);
+
+		bool success = item->success;
+		if (success)
+		{
+			ALIMER_PROFILE(FinishBackgroundResource);
+			success = resource->EndLoad();
+		}
+
+		if (success)
+			StoreResource(key, resource);
+		else
+			ALIMER_LOGERROR("Failed to load resource {}", resource->GetName());
+
+		// Release the dependents, even on failure, so that they fall back to their own error handling
+		for (auto depIt = item->dependents.begin(); depIt != item->dependents.end(); ++depIt)
+		{
+			auto dependentIt = backgroundLoadItems.find(*depIt);
+			if (dependentIt != backgroundLoadItems.end())
+				dependentIt->second->dependencies.erase(key);
+		}
+
+		resourceLoadedEvent.resource = resource;
+		resourceLoadedEvent.success = success;
+		resourceLoadedEvent.Send(this);
+	}
+
+	void ResourceCache::WaitForBackgroundResource(ResourceKey key)
+	{
+		ALIMER_PROFILE(WaitForBackgroundResource);
+
+		JobSystem* jobSystem = GetSubsystem<JobSystem>();
+		for (;;)
+		{
+			bool idle = backgroundJobs.IsDone();
+			size_t numFinished = ProcessBackgroundResources(0);
+			auto it = backgroundLoadItems.find(key);
+			if (it == backgroundLoadItems.end())
+				break;
+
+			// If no jobs were running and nothing could be finished, the remaining items wait for each other
+			if (idle && !numFinished)
+			{
+				ALIMER_LOGWARN("Circular background load dependency, finishing {} without its dependencies", it->second->resource->GetName());
+				it->second->dependencies.clear();
+				continue;
+			}
+
+			// The main thread helps with the remaining jobs, including dependencies queued by this round
+			if (jobSystem)
+				jobSystem->Wait(&backgroundJobs);
+		}
+	}
+
+	void ResourceCache::BackgroundLoadJob(void* data, size_t, size_t)
+	{
+		ALIMER_PROFILE(BackgroundLoadResource);
+
+		BackgroundLoadItem* item = static_cast<BackgroundLoadItem*>(data);
+		ResourceCache* cache = item->cache;
+		Resource* resource = item->resource;
+
+		std::unique_ptr<Stream> stream = cache->OpenResource(resource->GetName());
+		item->success = stream && resource->BeginLoad(*stream);
+
+		lock_guard<mutex> lock(cache->backgroundMutex);
+		cache->backgroundCompleted.push_back(item);
+	}
+
 	void ResourceCache::ResourcesByType(std::vector<Resource*>& result, StringHash type) const
 	{
 		result.clear();
@@ -314,6 +806,13 @@ namespace Alimer
 	bool ResourceCache::Exists(const string& nameIn) const
 	{
 		string name = SanitateResourceName(nameIn);
+		shared_lock<shared_mutex> lock(searchPathMutex);
+
+		for (size_t i = 0; i < packageFiles.size(); ++i)
+		{
+			if (packageFiles[i]->Exists(name))
+				return true;
+		}
 
 		for (size_t i = 0; i < resourceDirs.size(); ++i)
 		{
@@ -327,6 +826,8 @@ namespace Alimer
 
 	string ResourceCache::ResourceFileName(const string& name) const
 	{
+		shared_lock<shared_mutex> lock(searchPathMutex);
+
 		for (size_t i = 0; i < resourceDirs.size(); ++i)
 		{
 			if (FileExists(resourceDirs[i] + name))
@@ -343,6 +844,8 @@ namespace Alimer
 		name = str::Replace(name, "../", "");
 		name = str::Replace(name, "./", "");
 
+		shared_lock<shared_mutex> lock(searchPathMutex);
+
 		// If the path refers to one of the resource directories, normalize the resource name
 		if (resourceDirs.size())
 		{
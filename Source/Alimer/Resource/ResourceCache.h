@@ -23,14 +23,63 @@
 
 #pragma once
 
+#include "../Base/HashMap.h"
 #include "../Object/Object.h"
+#include "../Threading/JobSystem.h"
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <thread>
 
 namespace Alimer
 {
+	class PackageFile;
 	class Resource;
 	class Stream;
 
-	using ResourceMap = std::map<std::pair<StringHash, StringHash>, SharedPtr<Resource> >;
+	/// Resource key, combined from the type hash in the high bits and the name hash in the low bits.
+	using ResourceKey = Hash;
+	using ResourceMap = OpenHashMap<SharedPtr<Resource> >;
+
+	/// Make a resource key from type and name hashes.
+	inline ResourceKey MakeResourceKey(StringHash type, StringHash nameHash)
+	{
+		return (static_cast<ResourceKey>(type.Value()) << 32) | nameHash.Value();
+	}
+
+	/// Return the type hash of a resource key.
+	inline StringHash GetResourceKeyType(ResourceKey key)
+	{
+		return StringHash(static_cast<uint32_t>(key >> 32));
+	}
+
+	/// Memory use and budget of one resource type.
+	struct ALIMER_API ResourceGroup
+	{
+		/// Memory budget in bytes. Zero is unlimited.
+		uint64_t memoryBudget = 0;
+		/// CPU memory use in bytes.
+		uint64_t cpuMemoryUse = 0;
+		/// GPU memory use in bytes.
+		uint64_t gpuMemoryUse = 0;
+		/// Number of resources.
+		size_t numResources = 0;
+		/// Number of resources evicted to stay within the budget.
+		uint64_t numEvicted = 0;
+
+		/// Return total memory use in bytes.
+		uint64_t GetMemoryUse() const { return cpuMemoryUse + gpuMemoryUse; }
+	};
+
+	/// Background resource load finished event.
+	class ALIMER_API ResourceLoadedEvent : public Event
+	{
+	public:
+		/// The resource. If loading failed, the cache does not store it, but an event handler may take ownership.
+		Resource* resource;
+		/// Success flag.
+		bool success;
+	};
 
 	/// %Resource cache subsystem. Loads resources on demand and stores them for later access.
 	class ALIMER_API ResourceCache : public Object
@@ -49,10 +98,32 @@ namespace Alimer
 		bool AddManualResource(Resource* resource);
 		/// Remove a resource directory.
 		void RemoveResourceDir(const std::string& pathName);
-		/// Open a resource file stream from the resource directories. Return a pointer to the stream, or null if not found.
+		/// Add a package file. Packages are searched before the resource directories. Return true on success.
+		bool AddPackageFile(PackageFile* package, bool addFirst = false);
+		/// Open and add a package file. Return true on success.
+		bool AddPackageFile(const std::string& fileName, bool addFirst = false);
+		/// Remove a package file.
+		void RemovePackageFile(PackageFile* package);
+		/// Remove a package file by name.
+		void RemovePackageFile(const std::string& fileName);
+		/// Open a resource file stream from the package files or resource directories. Return a pointer to the stream, or null if not found.
 		std::unique_ptr<Stream> OpenResource(const std::string& name);
-		/// Load and return a resource.
+		/// Set whether to memory map resource files, so that loaders can borrow their data without copying. Default false. A mapped file must not be truncated or replaced in place while resources borrow its data, as accessing the lost pages raises SIGBUS on POSIX systems.
+		void SetMemoryMapping(bool enable);
+		/// Load and return a resource. If the resource is being loaded in the background, wait for it to finish.
 		Resource* LoadResource(StringHash type, const std::string& name);
+		/// Load and return a resource, C string version.
+		Resource* LoadResource(StringHash type, const char* name) { return LoadResource(type, std::string(name)); }
+		/// Return an already loaded resource by name hash, skipping name sanitation. If the resource is being loaded in the background, wait for it to finish. Return null if the resource has not been requested by name.
+		Resource* LoadResource(StringHash type, StringHash nameHash);
+		/// Queue a resource to be loaded in the background. BeginLoad() runs in a worker thread and EndLoad() later in FinishBackgroundResources(). A resource loading in the background can pass itself as the caller to delay its EndLoad() until the dependency has finished. Can be called from worker threads. Return true if queued, already queued or already loaded.
+		bool BackgroundLoadResource(StringHash type, const std::string& name, Resource* caller = nullptr);
+		/// Finish background loaded resources whose BeginLoad() and dependencies have completed, until the time budget is used.
+		void FinishBackgroundResources();
+		/// Unload least recently used resources of types over their memory budget, then finish background loaded resources. Called from the main thread once per frame. Resources are only unloaded here, so a pointer returned by LoadResource() stays valid until the next Update() even if only the cache references it.
+		void Update();
+		/// Set the time budget in milliseconds for finishing background loaded resources per frame. Zero finishes all ready resources.
+		void SetBackgroundLoadBudget(int milliseconds);
 		/// Unload resource. Optionally force removal even if referenced.
 		void UnloadResource(StringHash type, const std::string& name, bool force = false);
 		/// Unload all resources of type.
@@ -65,14 +136,42 @@ namespace Alimer
 		void UnloadAllResources(bool force = false);
 		/// Reload an existing resource. Return true on success.
 		bool ReloadResource(Resource* resource);
+		/// Set memory budget in bytes for a resource type. When exceeded, least recently used resources of the type that are only referenced by the cache are unloaded in the next Update(). Zero is unlimited.
+		void SetMemoryBudget(StringHash type, uint64_t budget);
+		/// Log memory use and budget of each resource type.
+		void LogMemoryUse() const;
 		/// Load and return a resource, template version.
 		template <class T> T* LoadResource(const std::string& name) { return static_cast<T*>(LoadResource(T::GetTypeStatic(), name)); }
+		/// Load and return a resource, template C string version.
+		template <class T> T* LoadResource(const char* name) { return static_cast<T*>(LoadResource(T::GetTypeStatic(), std::string(name))); }
+		/// Return an already loaded resource by name hash, template version.
+		template <class T> T* LoadResource(StringHash nameHash) { return static_cast<T*>(LoadResource(T::GetTypeStatic(), nameHash)); }
+		/// Queue a resource to be loaded in the background, template version.
+		template <class T> bool BackgroundLoadResource(const std::string& name, Resource* caller = nullptr) { return BackgroundLoadResource(T::GetTypeStatic(), name, caller); }
 
 		/// Return resources by type.
 		void ResourcesByType(std::vector<Resource*>& result, StringHash type) const;
-		/// Return resource directories.
+		/// Return resource directories. Call only from the main thread.
 		const std::vector<std::string>& GetResourceDirs() const { return resourceDirs; }
-		/// Return whether a file exists in the resource directories.
+		/// Return package files. Call only from the main thread.
+		const std::vector<SharedPtr<PackageFile> >& GetPackageFiles() const { return packageFiles; }
+		/// Return whether resource files are memory mapped.
+		bool GetMemoryMapping() const { return memoryMapping; }
+		/// Return number of loaded resources.
+		size_t GetNumResources() const { return resources.size(); }
+		/// Return memory budget in bytes for a resource type.
+		uint64_t GetMemoryBudget(StringHash type) const;
+		/// Return memory use in bytes of a resource type.
+		uint64_t GetMemoryUse(StringHash type) const;
+		/// Return memory use in bytes of all resources.
+		uint64_t GetTotalMemoryUse() const;
+		/// Return memory use and budget of all resource types.
+		const std::map<StringHash, ResourceGroup>& GetResourceGroups() const { return resourceGroups; }
+		/// Return number of resources being loaded in the background.
+		size_t GetNumBackgroundLoadResources() const { return backgroundLoadItems.size(); }
+		/// Return the time budget for finishing background loaded resources per frame.
+		int GetBackgroundLoadBudget() const { return backgroundLoadBudget; }
+		/// Return whether a file exists in the package files or resource directories.
 		bool Exists(const std::string& name) const;
 		/// Return an absolute filename from a resource name.
 		std::string ResourceFileName(const std::string& name) const;
@@ -97,9 +196,85 @@ namespace Alimer
 		/// Normalize and remove unsupported constructs from a resource directory name.
 		std::string SanitateResourceDirName(const std::string& name) const;
 
+		/// Background resource load finished event.
+		ResourceLoadedEvent resourceLoadedEvent;
+
 	private:
+		/// State of a resource being loaded in the background.
+		struct BackgroundLoadItem
+		{
+			/// Owning resource cache.
+			ResourceCache* cache;
+			/// The resource.
+			SharedPtr<Resource> resource;
+			/// Resources that must finish before this one.
+			std::set<ResourceKey> dependencies;
+			/// Resources waiting for this one to finish.
+			std::set<ResourceKey> dependents;
+			/// BeginLoad() result. Written by the worker thread.
+			bool success = false;
+			/// BeginLoad() finished flag. Set in the main thread after the worker has signaled completion.
+			bool loaded = false;
+		};
+
+		/// Background load request made from a worker thread.
+		struct BackgroundLoadRequest
+		{
+			/// Resource type.
+			StringHash type;
+			/// Resource name.
+			std::string name;
+			/// Resource that depends on the requested resource.
+			Resource* caller;
+		};
+
+		/// Open a file, memory mapped if enabled.
+		std::unique_ptr<Stream> OpenFile(const std::string& fileName) const;
+		/// Store a resource to the cache and account its memory use. Does not unload other resources.
+		void StoreResource(ResourceKey key, Resource* resource);
+		/// Remove a resource from the cache and its memory use from the accounting. Return iterator to the next resource.
+		ResourceMap::Iterator EraseResource(const ResourceMap::Iterator& it);
+		/// Unload least recently used resources of a type until within its memory budget.
+		void CheckMemoryBudget(StringHash type);
+		/// Mark a resource used and return it.
+		Resource* TouchResource(Resource* resource);
+		/// Create a resource object of the given type. Log an error and return null on failure.
+		SharedPtr<Resource> CreateResource(StringHash type);
+		/// Handle worker thread requests and completed BeginLoad() calls, then finish ready resources. Stop when the time budget in microseconds is used; zero is unlimited. Return number of resources finished.
+		size_t ProcessBackgroundResources(uint64_t maxMicroseconds);
+		/// Finish a resource whose BeginLoad() and dependencies have completed, store it if successful and send the loaded event.
+		void FinishBackgroundResource(ResourceKey key);
+		/// Wait for a background loaded resource and its dependencies to finish.
+		void WaitForBackgroundResource(ResourceKey key);
+		/// Job function that runs BeginLoad() for a background loaded resource.
+		static void BackgroundLoadJob(void* data, size_t begin, size_t end);
+
 		ResourceMap resources;
 		std::vector<std::string> resourceDirs;
+		/// Mounted package files.
+		std::vector<SharedPtr<PackageFile> > packageFiles;
+		/// Resource directory and package file mutex. Worker threads read them when opening resources, the main thread modifies them.
+		mutable std::shared_mutex searchPathMutex;
+		/// Memory use and budgets by resource type.
+		std::map<StringHash, ResourceGroup> resourceGroups;
+		/// Use stamp counter for least recently used eviction.
+		uint64_t useStamp;
+		/// Memory mapping flag.
+		bool memoryMapping;
+		/// Resources being loaded in the background. Accessed only from the main thread.
+		std::map<ResourceKey, std::unique_ptr<BackgroundLoadItem> > backgroundLoadItems;
+		/// Requests from worker threads, guarded by the background mutex.
+		std::vector<BackgroundLoadRequest> backgroundRequests;
+		/// Items whose BeginLoad() has completed, guarded by the background mutex.
+		std::vector<BackgroundLoadItem*> backgroundCompleted;
+		/// Background loading mutex.
+		std::mutex backgroundMutex;
+		/// Counter of background loading jobs in flight.
+		JobCounter backgroundJobs;
+		/// Main thread id, used to detect requests from worker threads.
+		std::thread::id mainThreadId;
+		/// Time budget in milliseconds for finishing background loaded resources per frame.
+		int backgroundLoadBudget;
 	};
 
 	/// Register Resource related object factories and attributes.
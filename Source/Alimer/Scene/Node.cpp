@@ -156,7 +156,10 @@ namespace Alimer
 	void Node::SetLayer(uint8_t newLayer)
 	{
 		if (_layer < 32)
+		{
 			_layer = newLayer;
+			OnSetLayer(newLayer);
+		}
 		else
 			ALIMER_LOGERROR("Can not set layer 32 or higher");
 	}
@@ -600,4 +603,8 @@ namespace Alimer
 	{
 	}
 
+	void Node::OnSetLayer(uint8_t)
+	{
+	}
+
 }
@@ -198,6 +198,8 @@ namespace Alimer
 		virtual void OnSceneSet(Scene* newScene, Scene* oldScene);
 		/// Handle the enabled status changing.
 		virtual void OnSetEnabled(bool newEnabled);
+		/// Handle the layer changing.
+		virtual void OnSetLayer(uint8_t newLayer);
 
 	private:
 		/// Parent node.
@@ -0,0 +1,259 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "JobSystem.h"
+#include <algorithm>
+#include <cassert>
+using namespace std;
+
+namespace Alimer
+{
+	/// Index of the current thread within the job system. Zero for the main thread and foreign threads.
+	static thread_local uint32_t threadIndex = 0;
+
+	JobCounter::JobCounter()
+		: _value(0)
+	{
+	}
+
+	JobCounter::~JobCounter()
+	{
+		assert(_value.load() == 0);
+	}
+
+	JobSystem::JobSystem(uint32_t numWorkerThreads)
+		: _numQueuedJobs(0)
+		, _shutdown(false)
+	{
+#ifdef ALIMER_THREADING
+		if (!numWorkerThreads)
+		{
+			uint32_t numCores = thread::hardware_concurrency();
+			numWorkerThreads = numCores > 1 ? numCores - 1 : 0;
+		}
+#else
+		numWorkerThreads = 0;
+#endif
+
+		for (uint32_t i = 0; i < numWorkerThreads + 1; ++i)
+			_queues.emplace_back(new WorkQueue());
+
+		for (uint32_t i = 0; i < numWorkerThreads; ++i)
+			_threads.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+
+		RegisterSubsystem(this);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			lock_guard<mutex> lock(_sleepMutex);
+			_shutdown = true;
+		}
+		_wakeCondition.notify_all();
+
+		for (auto it = _threads.begin(); it != _threads.end(); ++it)
+			it->join();
+
+		RemoveSubsystem(this);
+	}
+
+	void JobSystem::Submit(const Job& job, JobCounter* counter, JobCounter* dependency)
+	{
+		Submit(&job, 1, counter, dependency);
+	}
+
+	void JobSystem::Submit(const Job* jobs, size_t count, JobCounter* counter, JobCounter* dependency)
+	{
+		if (!jobs || !count)
+			return;
+
+		if (counter)
+			counter->_value.fetch_add(static_cast<uint32_t>(count), memory_order_acq_rel);
+
+		// If the dependency has not finished, park the jobs into it. The check happens under the counter's lock so that
+		// the jobs are either released by the finishing job or queued here, never both
+		if (dependency)
+		{
+			lock_guard<mutex> lock(dependency->_mutex);
+			if (dependency->_value.load(memory_order_acquire))
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					dependency->_dependents.push_back(jobs[i]);
+					dependency->_dependents.back().counter = counter;
+				}
+				return;
+			}
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			Job job = jobs[i];
+			job.counter = counter;
+			Push(job);
+		}
+	}
+
+	void JobSystem::Wait(JobCounter* counter)
+	{
+		if (!counter)
+			return;
+
+		uint32_t index = threadIndex;
+		while (counter->GetValue())
+		{
+			Job job;
+			if (Pop(index, job))
+				Execute(job);
+			else
+				this_thread::yield();
+		}
+
+		// Synchronize with the thread that finished the last job, so that the counter can be destroyed safely after return
+		lock_guard<mutex> lock(counter->_mutex);
+	}
+
+	void JobSystem::ParallelFor(size_t count, size_t grainSize, JobFunction function, void* data)
+	{
+		if (!count || !function)
+			return;
+
+		if (!grainSize)
+			grainSize = 1;
+
+		// Execute directly if there is nothing to split or no threads to split to
+		if (count <= grainSize || _threads.empty())
+		{
+			function(data, 0, count);
+			return;
+		}
+
+		JobCounter counter;
+		for (size_t begin = 0; begin < count; begin += grainSize)
+			Submit(Job(function, data, begin, std::min(begin + grainSize, count)), &counter);
+
+		Wait(&counter);
+	}
+
+	uint32_t JobSystem::GetThreadIndex()
+	{
+		return threadIndex;
+	}
+
+	void JobSystem::WorkerLoop(uint32_t index)
+	{
+		threadIndex = index;
+
+		while (!_shutdown.load(memory_order_acquire))
+		{
+			Job job;
+			if (Pop(index, job))
+			{
+				Execute(job);
+				continue;
+			}
+
+			unique_lock<mutex> lock(_sleepMutex);
+			_wakeCondition.wait(lock, [this]() { return _shutdown.load() || _numQueuedJobs.load() > 0; });
+		}
+	}
+
+	void JobSystem::Push(const Job& job)
+	{
+		WorkQueue& queue = *_queues[threadIndex < _queues.size() ? threadIndex : 0];
+		{
+			lock_guard<mutex> lock(queue.mutex);
+			queue.jobs.push_back(job);
+		}
+
+		_numQueuedJobs.fetch_add(1, memory_order_acq_rel);
+
+		// Take the sleep mutex so that a worker which just found the queues empty can not miss the notification
+		if (!_threads.empty())
+		{
+			{
+				lock_guard<mutex> lock(_sleepMutex);
+			}
+			_wakeCondition.notify_one();
+		}
+	}
+
+	bool JobSystem::Pop(uint32_t index, Job& job)
+	{
+		if (!_numQueuedJobs.load(memory_order_acquire))
+			return false;
+
+		size_t numQueues = _queues.size();
+		if (index >= numQueues)
+			index = 0;
+
+		// Newest job from own queue first for cache locality
+		{
+			WorkQueue& own = *_queues[index];
+			lock_guard<mutex> lock(own.mutex);
+			if (!own.jobs.empty())
+			{
+				job = own.jobs.back();
+				own.jobs.pop_back();
+				_numQueuedJobs.fetch_sub(1, memory_order_acq_rel);
+				return true;
+			}
+		}
+
+		// Steal the oldest job from another thread
+		for (size_t i = 1; i < numQueues; ++i)
+		{
+			WorkQueue& victim = *_queues[(index + i) % numQueues];
+			lock_guard<mutex> lock(victim.mutex);
+			if (!victim.jobs.empty())
+			{
+				job = victim.jobs.front();
+				victim.jobs.pop_front();
+				_numQueuedJobs.fetch_sub(1, memory_order_acq_rel);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void JobSystem::Execute(const Job& job)
+	{
+		job.function(job.data, job.begin, job.end);
+
+		JobCounter* counter = job.counter;
+		if (!counter)
+			return;
+
+		std::vector<Job> released;
+		{
+			lock_guard<mutex> lock(counter->_mutex);
+			if (counter->_value.fetch_sub(1, memory_order_acq_rel) == 1)
+				released.swap(counter->_dependents);
+		}
+
+		for (auto it = released.begin(); it != released.end(); ++it)
+			Push(*it);
+	}
+}
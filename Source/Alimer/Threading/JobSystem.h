@@ -0,0 +1,166 @@
+//
+// Alimer is based on the Turso3D codebase.
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Object/Object.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace Alimer
+{
+	class JobCounter;
+
+	/// Job work function. Receives the user data pointer and the index range to process.
+	typedef void(*JobFunction)(void* data, size_t begin, size_t end);
+
+	/// Description of a unit of work.
+	struct ALIMER_API Job
+	{
+		/// Construct undefined.
+		Job() = default;
+
+		/// Construct with function, user data and range.
+		Job(JobFunction function_, void* data_, size_t begin_ = 0, size_t end_ = 0) :
+			function(function_),
+			data(data_),
+			begin(begin_),
+			end(end_)
+		{
+		}
+
+		/// Work function.
+		JobFunction function{ nullptr };
+		/// User data pointer.
+		void* data{ nullptr };
+		/// Range start.
+		size_t begin{ 0 };
+		/// Range end (exclusive.)
+		size_t end{ 0 };
+		/// Counter to decrement on completion. Assigned by the job system.
+		JobCounter* counter{ nullptr };
+	};
+
+	/// Counter of unfinished jobs. Can be waited on, or used as a dependency for further jobs.
+	class ALIMER_API JobCounter
+	{
+		friend class JobSystem;
+
+	public:
+		/// Construct with zero pending jobs.
+		JobCounter();
+		/// Destruct. The counter must not have pending jobs.
+		~JobCounter();
+
+		/// Return number of pending jobs.
+		uint32_t GetValue() const { return _value.load(std::memory_order_acquire); }
+		/// Return whether all jobs associated with the counter have finished.
+		bool IsDone() const { return GetValue() == 0; }
+
+	private:
+		/// Prevent copy construction.
+		JobCounter(const JobCounter&) = delete;
+		/// Prevent assignment.
+		JobCounter& operator = (const JobCounter&) = delete;
+
+		/// Pending job count.
+		std::atomic<uint32_t> _value;
+		/// Mutex for the dependent jobs.
+		std::mutex _mutex;
+		/// Jobs waiting for this counter to reach zero.
+		std::vector<Job> _dependents;
+	};
+
+	/// Job system subsystem. Executes jobs on per-core worker threads, which steal work from each other when idle.
+	class ALIMER_API JobSystem : public Object
+	{
+		ALIMER_OBJECT(JobSystem, Object);
+
+	public:
+		/// Construct and register subsystem. Zero worker threads means one less than the number of CPU cores.
+		JobSystem(uint32_t numWorkerThreads = 0);
+		/// Destruct. Wait for the worker threads to finish and unregister subsystem.
+		~JobSystem();
+
+		/// Submit a job. Optionally increment a counter that is decremented on completion, and defer execution until a dependency counter reaches zero.
+		void Submit(const Job& job, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+		/// Submit several jobs at once.
+		void Submit(const Job* jobs, size_t count, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+		/// Wait until a counter reaches zero. The calling thread executes pending jobs meanwhile.
+		void Wait(JobCounter* counter);
+		/// Split an index range into jobs of at most grainSize indices, execute them in parallel and wait for completion.
+		void ParallelFor(size_t count, size_t grainSize, JobFunction function, void* data);
+
+		/// Split an index range into jobs and execute in parallel, template version. The function object is called with (begin, end).
+		template <class T> void ParallelFor(size_t count, size_t grainSize, const T& function)
+		{
+			ParallelFor(count, grainSize, &InvokeRange<T>, const_cast<T*>(&function));
+		}
+
+		/// Return number of threads including the main thread.
+		uint32_t GetNumThreads() const { return static_cast<uint32_t>(_threads.size()) + 1; }
+		/// Return index of the calling thread. The main thread and threads outside the job system return 0, worker threads 1 to GetNumThreads() - 1.
+		static uint32_t GetThreadIndex();
+
+	private:
+		/// Per-thread job deque. The owner pushes and pops at the back, thieves take from the front.
+		struct WorkQueue
+		{
+			/// Jobs.
+			std::deque<Job> jobs;
+			/// Queue access mutex.
+			std::mutex mutex;
+		};
+
+		/// Worker thread entry point.
+		void WorkerLoop(uint32_t index);
+		/// Push a ready job to the calling thread's queue.
+		void Push(const Job& job);
+		/// Take a job from the own queue, or steal one from another thread. Return true if found.
+		bool Pop(uint32_t index, Job& job);
+		/// Execute a job, decrement its counter and queue any jobs that were waiting for the counter to reach zero.
+		void Execute(const Job& job);
+
+		/// Invoke a function object over a range.
+		template <class T> static void InvokeRange(void* data, size_t begin, size_t end)
+		{
+			(*static_cast<T*>(data))(begin, end);
+		}
+
+		/// Worker threads.
+		std::vector<std::thread> _threads;
+		/// Job queues. Index 0 belongs to the main thread.
+		std::vector<std::unique_ptr<WorkQueue>> _queues;
+		/// Number of jobs in all queues.
+		std::atomic<uint32_t> _numQueuedJobs;
+		/// Mutex for sleeping workers.
+		std::mutex _sleepMutex;
+		/// Condition for waking up sleeping workers.
+		std::condition_variable _wakeCondition;
+		/// Shutdown flag.
+		std::atomic<bool> _shutdown;
+	};
+}
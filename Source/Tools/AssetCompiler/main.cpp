@@ -22,8 +22,15 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstdio>
+#include <cstring>
+#include "Debug/Log.h"
+#include "IO/File.h"
 #include "IO/FileSystem.h"
+#include "IO/PackageFile.h"
+#include "Assets/Importers/ModelImporter.hpp"
 #include "Assets/Importers/ShaderImporter.hpp"
+#include "Assets/PackageBuilder.hpp"
 using namespace Alimer;
 
 class TestAssetImporterContext final : public Alimer::IAssetImporterContext
@@ -79,22 +86,94 @@ std::vector<uint8_t> ReadFile(const std::string& path)
 	return result;
 }
 
+int BuildPackage(int argc, char** argv)
+{
+	if (argc < 4)
+	{
+		std::cout << "Usage: AlimerAssetCompiler package [inputPath] [outFile] [-c]" << std::endl;
+		return 1;
+	}
+
+	PackageBuilder builder;
+	builder.SetCompression(argc > 4 && !strcmp(argv[4], "-c"));
+	if (!builder.AddDirectory(argv[2]) || !builder.Save(argv[3]))
+		return 1;
+
+	PackageFile package(argv[3]);
+	if (!package.IsOpen())
+		return 1;
+
+	size_t numCompressed = 0;
+	for (const PackageEntry& entry : package.GetEntries())
+	{
+		if (entry.IsCompressed())
+			++numCompressed;
+	}
+
+	std::cout << "Packaged " << package.GetNumEntries() << " files (" << numCompressed << " compressed), "
+		<< package.GetTotalSize() << " bytes to " << File(argv[3]).Size() << " bytes" << std::endl;
+	return EXIT_SUCCESS;
+}
+
 int main(int argc, char** argv)
 {
-	if (argc < 2)
+	Log log;
+
+	if (argc >= 2 && !strcmp(argv[1], "package"))
+		return BuildPackage(argc, argv);
+
+	if (argc < 3)
 	{
-		std::cout << "Usage: AlimerAssetCompiler [file/path] [outPath]" << std::endl;
+		std::cout << "Usage: AlimerAssetCompiler [file/path] [outPath] [-lod ratio:distance]... [-lodError error]" << std::endl;
+		std::cout << "       AlimerAssetCompiler package [inputPath] [outFile] [-c]" << std::endl;
 		return 1;
 	}
 
 	std::string inputFile = argv[1];
 	std::string outputPath = argv[2];
+
+	ShaderImporter shaderImporter;
+	ModelImporter modelImporter;
+	std::vector<ModelLodLevel> lodLevels;
+	for (int i = 3; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-lod"))
+		{
+			ModelLodLevel level;
+			if (sscanf(argv[i + 1], "%f:%f", &level.ratio, &level.distance) != 2)
+			{
+				std::cout << "Invalid LOD level " << argv[i + 1] << ", expected ratio:distance" << std::endl;
+				return 1;
+			}
+			lodLevels.push_back(level);
+		}
+		else if (!strcmp(argv[i], "-lodError"))
+			modelImporter.SetLodTargetError((float)atof(argv[i + 1]));
+	}
+	modelImporter.SetLodLevels(lodLevels);
+
+	IAssetImporter* importers[] = { &shaderImporter, &modelImporter };
+	IAssetImporter* importer = nullptr;
+	for (IAssetImporter* candidate : importers)
+	{
+		if (candidate->CanImport(GetExtension(inputFile)))
+		{
+			importer = candidate;
+			break;
+		}
+	}
+
+	if (!importer)
+	{
+		std::cout << "No importer for " << inputFile << std::endl;
+		return 1;
+	}
+
 	TestAssetImporterContext context(outputPath);
 	Asset asset;
-	asset.assetId = ReplaceExtension(GetFileName(inputFile), ".bin");
+	asset.assetId = ReplaceExtension(GetFileName(inputFile), importer->GetOutputExtension());
 	asset.inputFiles.emplace_back(AssetFile(inputFile, ReadFile(inputFile)));
-	ShaderImporter importer;
-	importer.Import(asset, context);
+	importer->Import(asset, context);
 
 	std::cout << "Usage: AlimerAssetCompiler" << " " << argv[1];
 	return EXIT_SUCCESS;
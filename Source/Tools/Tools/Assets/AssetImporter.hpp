@@ -68,5 +68,7 @@ namespace Alimer
 
 		virtual bool CanImport(const std::string& fileExt) const = 0;
 		virtual void Import(const Asset& asset, IAssetImporterContext& context) = 0;
+		/// Return the extension of the imported asset.
+		virtual const char* GetOutputExtension() const { return ".bin"; }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "ModelImporter.hpp"
+#include "../MeshOptimizer.hpp"
+#include "../ModelData.hpp"
+#include "Debug/Log.h"
+#include "IO/MemoryBuffer.h"
+#include "IO/VectorBuffer.h"
+
+namespace Alimer
+{
+	bool ModelImporter::CanImport(const std::string& fileExt) const
+	{
+		return fileExt.compare(".mdl") == 0 || fileExt.compare(".amdl") == 0;
+	}
+
+	void ModelImporter::Import(const Asset& asset, IAssetImporterContext& context)
+	{
+		if (asset.inputFiles.empty())
+			return;
+
+		const AssetFile& input = asset.inputFiles.front();
+		MemoryBuffer source(input.data);
+		source.SetName(input.name);
+
+		ModelData model;
+		if (!model.Load(source))
+			return;
+
+		MeshOptimizationReport report = OptimizeModel(model);
+		ALIMER_LOGINFO("Optimized model {}: vertices {} -> {}, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+			input.name, report.verticesBefore, report.verticesAfter,
+			report.before.GetACMR(), report.after.GetACMR(), report.before.GetATVR(), report.after.GetATVR());
+		if (report.skippedVertexBuffers)
+			ALIMER_LOGWARN("Skipped optimizing {} vertex buffers of model {} with shared or invalid index ranges", report.skippedVertexBuffers, input.name);
+
+		if (!_lodLevels.empty())
+		{
+			if (!GenerateModelLods(model, _lodLevels, _lodTargetError))
+				return;
+
+			for (size_t i = 0; i < model.geometries.size(); ++i)
+			{
+				const std::vector<GeometryDesc>& lodLevels = model.geometries[i];
+				std::string triangleCounts;
+				for (size_t j = 0; j < lodLevels.size(); ++j)
+					triangleCounts += (j ? " / " : "") + std::to_string(lodLevels[j].drawCount / 3);
+				ALIMER_LOGINFO("Geometry {} of model {}: {} LOD levels, triangles {}", i, input.name, lodLevels.size(), triangleCounts);
+			}
+		}
+
+		VectorBuffer output;
+		if (!model.Save(output))
+			return;
+
+		context.Output(asset.assetId, output.Buffer());
+	}
+}
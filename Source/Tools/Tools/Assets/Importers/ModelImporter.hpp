@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../AssetImporter.hpp"
+#include "../MeshSimplifier.hpp"
+
+namespace Alimer
+{
+	/**
+	* Model importer. Converts models to the Alimer model format, optionally generating LOD levels.
+	*/
+	class ModelImporter final : public IAssetImporter
+	{
+	public:
+		bool CanImport(const std::string& fileExt) const override;
+		void Import(const Asset& asset, IAssetImporterContext& context) override;
+		const char* GetOutputExtension() const override { return ".amdl"; }
+
+		/// Set LOD levels to generate for geometries without LODs.
+		void SetLodLevels(const std::vector<ModelLodLevel>& levels) { _lodLevels = levels; }
+		/// Set maximum LOD simplification error, relative to the mesh extents.
+		void SetLodTargetError(float error) { _lodTargetError = error; }
+
+		/// Return LOD levels to generate.
+		const std::vector<ModelLodLevel>& GetLodLevels() const { return _lodLevels; }
+		/// Return maximum LOD simplification error.
+		float GetLodTargetError() const { return _lodTargetError; }
+
+	private:
+		/// LOD levels to generate.
+		std::vector<ModelLodLevel> _lodLevels;
+		/// Maximum LOD simplification error.
+		float _lodTargetError = DEFAULT_LOD_TARGET_ERROR;
+	};
+}
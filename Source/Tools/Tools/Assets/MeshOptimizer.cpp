@@ -0,0 +1,706 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "MeshOptimizer.hpp"
+#include "ModelData.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <tuple>
+using namespace std;
+
+namespace Alimer
+{
+	/// Cache size used for scoring in the vertex cache optimization.
+	static const unsigned SCORING_CACHE_SIZE = 16;
+	/// Number of live triangle counts with a precomputed valence score.
+	static const unsigned MAX_SCORED_VALENCE = 32;
+	/// Marker for no vertex or triangle.
+	static const uint32_t INVALID_INDEX = ~0u;
+
+	/// Precomputed vertex scores by cache position and number of live triangles, following Forsyth.
+	struct VertexScoreTable
+	{
+		VertexScoreTable()
+		{
+			for (unsigned i = 0; i < SCORING_CACHE_SIZE; ++i)
+			{
+				// The three vertices of the last triangle score the same, so that its neighbours are not favored by order
+				cache[i] = i < 3 ? 0.75f : powf(1.0f - (float)(i - 3) / (SCORING_CACHE_SIZE - 3), 1.5f);
+			}
+
+			valence[0] = 0.0f;
+			for (unsigned i = 1; i < MAX_SCORED_VALENCE; ++i)
+				valence[i] = 2.0f * powf((float)i, -0.5f);
+		}
+
+		float Score(int cachePosition, uint32_t liveTriangles) const
+		{
+			if (!liveTriangles)
+				return -1.0f;
+
+			float score = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+			return score + valence[min(liveTriangles, MAX_SCORED_VALENCE - 1)];
+		}
+
+		float cache[SCORING_CACHE_SIZE];
+		float valence[MAX_SCORED_VALENCE];
+	};
+
+	/// Simulated FIFO post-transform vertex cache.
+	class FifoVertexCache
+	{
+	public:
+		/// Construct for a vertex count.
+		FifoVertexCache(size_t vertexCount, unsigned cacheSize = DEFAULT_VERTEX_CACHE_SIZE) :
+			timestamps(vertexCount, 0),
+			timestamp(cacheSize + 1),
+			size(cacheSize)
+		{
+		}
+
+		/// Transform a vertex. Return true on a cache miss.
+		bool Miss(uint32_t vertex)
+		{
+			// A vertex is in the cache if fewer than size vertices have been transformed after it
+			if (timestamp - timestamps[vertex] <= size)
+				return false;
+
+			timestamps[vertex] = timestamp++;
+			return true;
+		}
+
+		/// Transform the vertices of a triangle. Return the number of cache misses.
+		unsigned Misses(const uint32_t* triangle)
+		{
+			return (unsigned)Miss(triangle[0]) + (unsigned)Miss(triangle[1]) + (unsigned)Miss(triangle[2]);
+		}
+
+		/// Empty the cache.
+		void Flush() { timestamp += size + 1; }
+
+	private:
+		/// Timestamp of each vertex when last transformed.
+		vector<uint32_t> timestamps;
+		/// Current timestamp.
+		uint32_t timestamp;
+		/// Cache size.
+		unsigned size;
+	};
+
+	static bool ValidateIndices(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+	{
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			if (indices[i] >= vertexCount)
+				return false;
+		}
+
+		return true;
+	}
+
+	static void ReadPosition(float* dest, const uint8_t* vertexData, size_t vertexSize, size_t positionOffset, uint32_t vertex)
+	{
+		memcpy(dest, vertexData + vertex * vertexSize + positionOffset, 3 * sizeof(float));
+	}
+
+	VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize)
+	{
+		VertexCacheStatistics ret;
+		ret.triangles = static_cast<uint32_t>(indexCount / 3);
+
+		FifoVertexCache cache(vertexCount, cacheSize);
+		vector<bool> used(vertexCount, false);
+
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			uint32_t vertex = indices[i];
+			if (vertex >= vertexCount)
+				continue;
+
+			if (cache.Miss(vertex))
+				++ret.verticesTransformed;
+			if (!used[vertex])
+			{
+				used[vertex] = true;
+				++ret.uniqueVertices;
+			}
+		}
+
+		return ret;
+	}
+
+	void OptimizeVertexCache(uint32_t* dest, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+	{
+		size_t triangleCount = indexCount / 3;
+		if (!triangleCount || !ValidateIndices(indices, triangleCount * 3, vertexCount))
+		{
+			if (indexCount)
+				memcpy(dest, indices, indexCount * sizeof(uint32_t));
+			return;
+		}
+
+		static const VertexScoreTable scoreTable;
+
+		// Build vertex to triangle adjacency. The first liveTriangles entries of each list are the triangles not yet emitted
+		vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			++liveTriangles[indices[i]];
+
+		vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t i = 0; i < vertexCount; ++i)
+			adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangles[i];
+
+		vector<uint32_t> adjacency(triangleCount * 3);
+		{
+			vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < triangleCount * 3; ++i)
+				adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		vector<int> cachePositions(vertexCount, -1);
+		vector<float> vertexScores(vertexCount);
+		for (size_t i = 0; i < vertexCount; ++i)
+			vertexScores[i] = scoreTable.Score(-1, liveTriangles[i]);
+
+		vector<float> triangleScores(triangleCount);
+		for (size_t i = 0; i < triangleCount; ++i)
+			triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+
+		vector<bool> emitted(triangleCount, false);
+		vector<uint32_t> cache;
+		vector<uint32_t> newCache;
+		cache.reserve(SCORING_CACHE_SIZE + 3);
+		newCache.reserve(SCORING_CACHE_SIZE + 3);
+
+		size_t inputCursor = 0;
+		size_t outputIndex = 0;
+		uint32_t current = 0;
+
+		while (current != INVALID_INDEX)
+		{
+			const uint32_t* triangle = &indices[current * 3];
+			dest[outputIndex++] = triangle[0];
+			dest[outputIndex++] = triangle[1];
+			dest[outputIndex++] = triangle[2];
+			emitted[current] = true;
+
+			// Move the triangle's vertices to the front of the LRU cache
+			newCache.assign(triangle, triangle + 3);
+			for (auto it = cache.begin(); it != cache.end(); ++it)
+			{
+				if (*it != triangle[0] && *it != triangle[1] && *it != triangle[2])
+					newCache.push_back(*it);
+			}
+
+			// Remove the triangle from the live adjacency of its vertices
+			for (unsigned k = 0; k < 3; ++k)
+			{
+				uint32_t vertex = triangle[k];
+				uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+				uint32_t count = liveTriangles[vertex];
+				for (uint32_t j = 0; j < count; ++j)
+				{
+					if (list[j] == current)
+					{
+						list[j] = list[count - 1];
+						list[count - 1] = current;
+						--liveTriangles[vertex];
+						break;
+					}
+				}
+			}
+
+			// Rescore the vertices whose cache position changed, and their triangles
+			for (size_t i = 0; i < newCache.size(); ++i)
+			{
+				uint32_t vertex = newCache[i];
+				int position = i < SCORING_CACHE_SIZE ? (int)i : -1;
+				cachePositions[vertex] = position;
+
+				float score = scoreTable.Score(position, liveTriangles[vertex]);
+				float delta = score - vertexScores[vertex];
+				vertexScores[vertex] = score;
+
+				const uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+				for (uint32_t j = 0; j < liveTriangles[vertex]; ++j)
+					triangleScores[list[j]] += delta;
+			}
+
+			if (newCache.size() > SCORING_CACHE_SIZE)
+				newCache.resize(SCORING_CACHE_SIZE);
+			cache.swap(newCache);
+
+			// The next triangle is the best scoring one that uses a cached vertex
+			current = INVALID_INDEX;
+			float bestScore = -1.0f;
+			for (auto it = cache.begin(); it != cache.end(); ++it)
+			{
+				const uint32_t* list = &adjacency[adjacencyOffsets[*it]];
+				for (uint32_t j = 0; j < liveTriangles[*it]; ++j)
+				{
+					if (triangleScores[list[j]] > bestScore)
+					{
+						bestScore = triangleScores[list[j]];
+						current = list[j];
+					}
+				}
+			}
+
+			// Otherwise continue from the next triangle in input order
+			if (current == INVALID_INDEX)
+			{
+				while (inputCursor < triangleCount && emitted[inputCursor])
+					++inputCursor;
+				if (inputCursor < triangleCount)
+					current = static_cast<uint32_t>(inputCursor);
+			}
+		}
+
+		// Copy a trailing partial triangle as is
+		for (size_t i = triangleCount * 3; i < indexCount; ++i)
+			dest[i] = indices[i];
+	}
+
+	void OptimizeOverdraw(uint32_t* dest, const uint32_t* indices, size_t indexCount, const uint8_t* vertexData, size_t vertexCount, size_t vertexSize, size_t positionOffset, float threshold)
+	{
+		size_t triangleCount = indexCount / 3;
+		if (indexCount)
+			memcpy(dest, indices, indexCount * sizeof(uint32_t));
+		if (triangleCount < 2 || !vertexData || !ValidateIndices(indices, triangleCount * 3, vertexCount))
+			return;
+
+		// Hard boundaries where the cache is cold in the current order
+		FifoVertexCache cache(vertexCount);
+		vector<size_t> hardStarts;
+		for (size_t i = 0; i < triangleCount; ++i)
+		{
+			if (cache.Misses(&indices[i * 3]) == 3)
+				hardStarts.push_back(i);
+		}
+		hardStarts.push_back(triangleCount);
+
+		// Soft boundaries inside each where the miss ratio of the cluster so far, starting from a cold cache, is close to the whole cluster's
+		vector<size_t> clusterStarts;
+		for (size_t c = 0; c + 1 < hardStarts.size(); ++c)
+		{
+			size_t hardStart = hardStarts[c];
+			size_t hardEnd = hardStarts[c + 1];
+
+			cache.Flush();
+			uint32_t clusterMisses = 0;
+			for (size_t i = hardStart; i < hardEnd; ++i)
+				clusterMisses += cache.Misses(&indices[i * 3]);
+			float clusterACMR = (float)clusterMisses / (hardEnd - hardStart);
+
+			cache.Flush();
+			clusterStarts.push_back(hardStart);
+			uint32_t runMisses = 0;
+			size_t runStart = hardStart;
+			for (size_t i = hardStart; i + 1 < hardEnd; ++i)
+			{
+				runMisses += cache.Misses(&indices[i * 3]);
+				if ((float)runMisses / (i + 1 - runStart) <= threshold * clusterACMR)
+				{
+					clusterStarts.push_back(i + 1);
+					cache.Flush();
+					runMisses = 0;
+					runStart = i + 1;
+				}
+			}
+		}
+		clusterStarts.push_back(triangleCount);
+
+		// Area-weighted centroid and average normal of each cluster and of the whole mesh
+		size_t clusterCount = clusterStarts.size() - 1;
+		vector<float> clusterData(clusterCount * 7, 0.0f);
+		float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+		float meshArea = 0.0f;
+
+		for (size_t c = 0; c < clusterCount; ++c)
+		{
+			float* data = &clusterData[c * 7];
+			for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+			{
+				float p0[3], p1[3], p2[3];
+				ReadPosition(p0, vertexData, vertexSize, positionOffset, indices[t * 3]);
+				ReadPosition(p1, vertexData, vertexSize, positionOffset, indices[t * 3 + 1]);
+				ReadPosition(p2, vertexData, vertexSize, positionOffset, indices[t * 3 + 2]);
+
+				float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+				float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				float area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+				for (unsigned k = 0; k < 3; ++k)
+				{
+					float center = (p0[k] + p1[k] + p2[k]) / 3.0f;
+					data[k] += center * area;
+					data[3 + k] += normal[k];
+					meshCentroid[k] += center * area;
+				}
+				data[6] += area;
+				meshArea += area;
+			}
+		}
+
+		if (meshArea > 0.0f)
+		{
+			for (unsigned k = 0; k < 3; ++k)
+				meshCentroid[k] /= meshArea;
+		}
+
+		// Sort clusters by how much they face away from the mesh center, so that the silhouette occludes the rest
+		vector<float> sortKeys(clusterCount, 0.0f);
+		for (size_t c = 0; c < clusterCount; ++c)
+		{
+			const float* data = &clusterData[c * 7];
+			float area = data[6];
+			float normalLength = sqrtf(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+			if (area <= 0.0f || normalLength <= 0.0f)
+				continue;
+
+			float key = 0.0f;
+			for (unsigned k = 0; k < 3; ++k)
+				key += (data[k] / area - meshCentroid[k]) * (data[3 + k] / normalLength);
+			sortKeys[c] = key;
+		}
+
+		vector<uint32_t> clusterOrder(clusterCount);
+		for (size_t c = 0; c < clusterCount; ++c)
+			clusterOrder[c] = static_cast<uint32_t>(c);
+		stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t lhs, uint32_t rhs)
+		{
+			return sortKeys[lhs] > sortKeys[rhs];
+		});
+
+		size_t outputIndex = 0;
+		for (size_t c = 0; c < clusterCount; ++c)
+		{
+			size_t start = clusterStarts[clusterOrder[c]] * 3;
+			size_t end = clusterStarts[clusterOrder[c] + 1] * 3;
+			memcpy(dest + outputIndex, indices + start, (end - start) * sizeof(uint32_t));
+			outputIndex += end - start;
+		}
+	}
+
+	size_t GenerateDuplicateVertexRemap(uint32_t* remap, const uint8_t* vertexData, size_t vertexCount, size_t vertexSize)
+	{
+		size_t tableSize = 1;
+		while (tableSize < vertexCount * 2)
+			tableSize <<= 1;
+		vector<uint32_t> table(tableSize, INVALID_INDEX);
+
+		size_t uniqueCount = 0;
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			const uint8_t* vertex = vertexData + i * vertexSize;
+
+			// FNV-1a over the vertex bytes
+			uint32_t hash = 2166136261u;
+			for (size_t j = 0; j < vertexSize; ++j)
+				hash = (hash ^ vertex[j]) * 16777619u;
+
+			size_t slot = hash & (tableSize - 1);
+			for (;;)
+			{
+				uint32_t existing = table[slot];
+				if (existing == INVALID_INDEX)
+				{
+					table[slot] = static_cast<uint32_t>(i);
+					remap[i] = static_cast<uint32_t>(i);
+					++uniqueCount;
+					break;
+				}
+				if (!memcmp(vertexData + existing * vertexSize, vertex, vertexSize))
+				{
+					remap[i] = existing;
+					break;
+				}
+				slot = (slot + 1) & (tableSize - 1);
+			}
+		}
+
+		return uniqueCount;
+	}
+
+	size_t GenerateVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+	{
+		for (size_t i = 0; i < vertexCount; ++i)
+			remap[i] = INVALID_INDEX;
+
+		uint32_t nextVertex = 0;
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			uint32_t vertex = indices[i];
+			if (vertex < vertexCount && remap[vertex] == INVALID_INDEX)
+				remap[vertex] = nextVertex++;
+		}
+
+		return nextVertex;
+	}
+
+	size_t GetVertexLayout(const VertexBufferDesc& desc, size_t& positionOffset)
+	{
+		// Elements with all zero offsets are packed in order
+		bool autoOffset = true;
+		for (auto it = desc.vertexElements.begin(); it != desc.vertexElements.end(); ++it)
+		{
+			if (it->offset)
+				autoOffset = false;
+		}
+
+		size_t vertexSize = 0;
+		positionOffset = NO_VERTEX_POSITION;
+		for (auto it = desc.vertexElements.begin(); it != desc.vertexElements.end(); ++it)
+		{
+			size_t offset = autoOffset ? vertexSize : it->offset;
+			if (!strcmp(it->semanticName, VertexElementSemantic::POSITION) && !it->semanticIndex && it->format == VertexFormat::Float3)
+				positionOffset = offset;
+			vertexSize += GetVertexFormatSize(it->format);
+		}
+
+		return vertexSize;
+	}
+
+	/// Index range of a geometry LOD level.
+	struct IndexRange
+	{
+		/// Index buffer.
+		uint32_t ibRef;
+		/// First index.
+		uint32_t start;
+		/// Number of indices.
+		uint32_t count;
+		/// Whether is a triangle list that can be reordered.
+		bool triangleList;
+	};
+
+	static void AddStatistics(VertexCacheStatistics& dest, const VertexCacheStatistics& src)
+	{
+		dest.verticesTransformed += src.verticesTransformed;
+		dest.triangles += src.triangles;
+		dest.uniqueVertices += src.uniqueVertices;
+	}
+
+	MeshOptimizationReport OptimizeModel(ModelData& model)
+	{
+		MeshOptimizationReport report;
+		size_t numVertexBuffers = model.vertexBuffers.size();
+		size_t numIndexBuffers = model.indexBuffers.size();
+
+		// Collect the distinct index ranges drawn from each vertex buffer. A range shared by several vertex buffers, or overlapping another range, can not be remapped safely
+		vector<vector<IndexRange> > vbRanges(numVertexBuffers);
+		vector<bool> skip(numVertexBuffers, false);
+		map<tuple<uint32_t, uint32_t, uint32_t>, uint32_t> rangeOwners;
+
+		for (auto geomIt = model.geometries.begin(); geomIt != model.geometries.end(); ++geomIt)
+		{
+			for (auto lodIt = geomIt->begin(); lodIt != geomIt->end(); ++lodIt)
+			{
+				const GeometryDesc& desc = *lodIt;
+				if (desc.vbRef >= numVertexBuffers)
+					continue;
+				if (desc.ibRef >= numIndexBuffers || (uint64_t)desc.drawStart + desc.drawCount > model.indexBuffers[desc.ibRef].indexCount)
+				{
+					skip[desc.vbRef] = true;
+					continue;
+				}
+
+				auto key = make_tuple(desc.ibRef, desc.drawStart, desc.drawCount);
+				auto ownerIt = rangeOwners.find(key);
+				if (ownerIt != rangeOwners.end())
+				{
+					if (ownerIt->second != desc.vbRef)
+						skip[ownerIt->second] = skip[desc.vbRef] = true;
+					continue;
+				}
+
+				rangeOwners[key] = desc.vbRef;
+				bool triangleList = desc.primitiveType == TRIANGLE_LIST && desc.drawCount % 3 == 0;
+				vbRanges[desc.vbRef].push_back(IndexRange{ desc.ibRef, desc.drawStart, desc.drawCount, triangleList });
+			}
+		}
+
+		// The map is ordered by index buffer and start. A long range can contain ranges that are not its neighbours, so compare
+		// each start against the furthest end seen so far in the same index buffer
+		uint32_t currentIb = 0;
+		uint64_t furthestEnd = 0;
+		uint32_t furthestOwner = 0;
+		for (auto it = rangeOwners.begin(); it != rangeOwners.end(); ++it)
+		{
+			uint32_t ibRef = get<0>(it->first);
+			uint64_t start = get<1>(it->first);
+			uint64_t end = start + get<2>(it->first);
+
+			if (it == rangeOwners.begin() || ibRef != currentIb)
+			{
+				currentIb = ibRef;
+				furthestEnd = end;
+				furthestOwner = it->second;
+				continue;
+			}
+
+			if (start < furthestEnd)
+				skip[it->second] = skip[furthestOwner] = true;
+			if (end > furthestEnd)
+			{
+				furthestEnd = end;
+				furthestOwner = it->second;
+			}
+		}
+
+		// Work on 32-bit copies of the index buffers
+		vector<vector<uint32_t> > indices(numIndexBuffers);
+		for (size_t i = 0; i < numIndexBuffers; ++i)
+		{
+			const IndexBufferDesc& ibDesc = model.indexBuffers[i];
+			indices[i].resize(ibDesc.indexCount);
+			if (ibDesc.indexType == IndexType::UInt16)
+			{
+				const uint16_t* src = reinterpret_cast<const uint16_t*>(ibDesc.indexData.get());
+				for (uint32_t j = 0; j < ibDesc.indexCount; ++j)
+					indices[i][j] = src[j];
+			}
+			else if (ibDesc.indexCount)
+				memcpy(indices[i].data(), ibDesc.indexData.get(), ibDesc.indexCount * sizeof(uint32_t));
+		}
+
+		vector<bool> ibModified(numIndexBuffers, false);
+		vector<uint32_t> remap;
+		vector<uint32_t> temp;
+
+		for (size_t i = 0; i < numVertexBuffers; ++i)
+		{
+			VertexBufferDesc& vbDesc = model.vertexBuffers[i];
+			vector<IndexRange>& ranges = vbRanges[i];
+			uint32_t vertexCount = vbDesc.vertexCount;
+			report.verticesBefore += vertexCount;
+
+			size_t positionOffset;
+			size_t vertexSize = GetVertexLayout(vbDesc, positionOffset);
+
+			bool valid = !skip[i] && vertexSize;
+			for (auto it = ranges.begin(); valid && it != ranges.end(); ++it)
+				valid = ValidateIndices(&indices[it->ibRef][it->start], it->count, vertexCount);
+
+			if (!valid || ranges.empty())
+			{
+				if (!valid)
+					++report.skippedVertexBuffers;
+				report.verticesAfter += vertexCount;
+				continue;
+			}
+
+			for (auto it = ranges.begin(); it != ranges.end(); ++it)
+			{
+				if (it->triangleList)
+					AddStatistics(report.before, AnalyzeVertexCache(&indices[it->ibRef][it->start], it->count, vertexCount));
+			}
+
+			// Point duplicate vertices to the first copy
+			const uint8_t* vertexData = vbDesc.vertexData.get();
+			remap.resize(vertexCount);
+			GenerateDuplicateVertexRemap(remap.data(), vertexData, vertexCount, vertexSize);
+			for (auto it = ranges.begin(); it != ranges.end(); ++it)
+			{
+				uint32_t* rangeIndices = &indices[it->ibRef][it->start];
+				for (uint32_t j = 0; j < it->count; ++j)
+					rangeIndices[j] = remap[rangeIndices[j]];
+				ibModified[it->ibRef] = true;
+			}
+
+			// Reorder triangles for the vertex cache, then clusters for overdraw
+			for (auto it = ranges.begin(); it != ranges.end(); ++it)
+			{
+				if (!it->triangleList)
+					continue;
+
+				uint32_t* rangeIndices = &indices[it->ibRef][it->start];
+				temp.resize(it->count);
+				OptimizeVertexCache(temp.data(), rangeIndices, it->count, vertexCount);
+				// Keep the original order if it was already better, e.g. from a stronger offline optimizer
+				if (AnalyzeVertexCache(rangeIndices, it->count, vertexCount).verticesTransformed <
+					AnalyzeVertexCache(temp.data(), it->count, vertexCount).verticesTransformed)
+					memcpy(temp.data(), rangeIndices, it->count * sizeof(uint32_t));
+				if (positionOffset != NO_VERTEX_POSITION)
+					OptimizeOverdraw(rangeIndices, temp.data(), it->count, vertexData, vertexCount, vertexSize, positionOffset);
+				else
+					memcpy(rangeIndices, temp.data(), it->count * sizeof(uint32_t));
+			}
+
+			// Order vertices by first use over all ranges, dropping duplicates and unused vertices
+			temp.clear();
+			for (auto it = ranges.begin(); it != ranges.end(); ++it)
+				temp.insert(temp.end(), indices[it->ibRef].begin() + it->start, indices[it->ibRef].begin() + it->start + it->count);
+			uint32_t newVertexCount = static_cast<uint32_t>(GenerateVertexFetchRemap(remap.data(), temp.data(), temp.size(), vertexCount));
+
+			shared_ptr<uint8_t> newVertexData(new uint8_t[newVertexCount * vertexSize], default_delete<uint8_t[]>());
+			for (uint32_t j = 0; j < vertexCount; ++j)
+			{
+				if (remap[j] != INVALID_INDEX)
+					memcpy(newVertexData.get() + remap[j] * vertexSize, vertexData + j * vertexSize, vertexSize);
+			}
+
+			for (auto it = ranges.begin(); it != ranges.end(); ++it)
+			{
+				uint32_t* rangeIndices = &indices[it->ibRef][it->start];
+				for (uint32_t j = 0; j < it->count; ++j)
+					rangeIndices[j] = remap[rangeIndices[j]];
+
+				if (it->triangleList)
+					AddStatistics(report.after, AnalyzeVertexCache(rangeIndices, it->count, newVertexCount));
+			}
+
+			vbDesc.vertexData = newVertexData;
+			vbDesc.vertexCount = newVertexCount;
+			report.verticesAfter += newVertexCount;
+		}
+
+		for (size_t i = 0; i < numIndexBuffers; ++i)
+		{
+			if (!ibModified[i])
+				continue;
+
+			IndexBufferDesc& ibDesc = model.indexBuffers[i];
+			if (ibDesc.indexType == IndexType::UInt16)
+			{
+				shared_ptr<uint8_t> data(new uint8_t[ibDesc.indexCount * sizeof(uint16_t)], default_delete<uint8_t[]>());
+				uint16_t* dest = reinterpret_cast<uint16_t*>(data.get());
+				for (uint32_t j = 0; j < ibDesc.indexCount; ++j)
+					dest[j] = static_cast<uint16_t>(indices[i][j]);
+				ibDesc.indexData = data;
+			}
+			else
+			{
+				shared_ptr<uint8_t> data(new uint8_t[ibDesc.indexCount * sizeof(uint32_t)], default_delete<uint8_t[]>());
+				if (ibDesc.indexCount)
+					memcpy(data.get(), indices[i].data(), ibDesc.indexCount * sizeof(uint32_t));
+				ibDesc.indexData = data;
+			}
+		}
+
+		return report;
+	}
+}
@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Alimer
+{
+	class ModelData;
+	struct VertexBufferDesc;
+
+	/// Post-transform vertex cache statistics of an index buffer.
+	struct VertexCacheStatistics
+	{
+		/// Number of vertices transformed, i.e. cache misses.
+		uint32_t verticesTransformed = 0;
+		/// Number of triangles.
+		uint32_t triangles = 0;
+		/// Number of distinct vertices referenced.
+		uint32_t uniqueVertices = 0;
+
+		/// Return average cache miss ratio, transformed vertices per triangle. 0.5 is ideal for a regular grid, 3 is the worst.
+		float GetACMR() const { return triangles ? (float)verticesTransformed / triangles : 0.0f; }
+		/// Return average transformed to vertex ratio. 1 is ideal.
+		float GetATVR() const { return uniqueVertices ? (float)verticesTransformed / uniqueVertices : 0.0f; }
+	};
+
+	/// Statistics of a model optimization pass.
+	struct MeshOptimizationReport
+	{
+		/// Cache statistics of the triangle lists before optimization.
+		VertexCacheStatistics before;
+		/// Cache statistics of the triangle lists after optimization.
+		VertexCacheStatistics after;
+		/// Total vertex count before optimization.
+		uint32_t verticesBefore = 0;
+		/// Total vertex count after deduplication and removal of unused vertices.
+		uint32_t verticesAfter = 0;
+		/// Number of vertex buffers that could not be optimized.
+		uint32_t skippedVertexBuffers = 0;
+	};
+
+	/// Default size of the simulated FIFO post-transform vertex cache.
+	static const unsigned DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+	/// Position offset returned for vertices without a Float3 position.
+	static const size_t NO_VERTEX_POSITION = ~(size_t)0;
+
+	/// Return the vertex size of a vertex buffer and the offset of its Float3 position, or NO_VERTEX_POSITION if it has none.
+	size_t GetVertexLayout(const VertexBufferDesc& desc, size_t& positionOffset);
+	/// Simulate a FIFO post-transform vertex cache over a triangle list and return the statistics.
+	VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+	/// Reorder triangles for post-transform vertex cache efficiency, using Forsyth's linear-speed algorithm. Destination and source may not overlap.
+	void OptimizeVertexCache(uint32_t* dest, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+	/// Reorder clusters of a vertex cache optimized triangle list to reduce overdraw, drawing outward facing clusters first. Clusters split where the cache is cold, or where the miss ratio stays within threshold times the original. Destination and source may not overlap.
+	void OptimizeOverdraw(uint32_t* dest, const uint32_t* indices, size_t indexCount, const uint8_t* vertexData, size_t vertexCount, size_t vertexSize, size_t positionOffset, float threshold = 1.05f);
+	/// Generate a remap table that maps each vertex to the first byte-identical vertex. Return the number of unique vertices.
+	size_t GenerateDuplicateVertexRemap(uint32_t* remap, const uint8_t* vertexData, size_t vertexCount, size_t vertexSize);
+	/// Generate a remap table that orders vertices by first use in the index buffer, mapping unused vertices to ~0. Return the number of used vertices.
+	size_t GenerateVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	/// Deduplicate vertices, optimize the vertex cache and overdraw of triangle lists, and reorder vertices for fetch locality in all vertex and index buffers of a model.
+	MeshOptimizationReport OptimizeModel(ModelData& model);
+}
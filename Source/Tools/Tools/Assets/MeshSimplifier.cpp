@@ -0,0 +1,567 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "MeshSimplifier.hpp"
+#include "MeshOptimizer.hpp"
+#include "ModelData.hpp"
+#include "Debug/Log.h"
+#include "Math/Math.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+using namespace std;
+
+namespace Alimer
+{
+	/// Weight of the planes that keep open borders in place, relative to the triangle planes.
+	static const float BORDER_WEIGHT = 10.0f;
+
+	/// Marker for no vertex.
+	static const uint32_t INVALID_VERTEX = ~0u;
+
+	/// Squared cosine of the largest allowed change of a triangle normal by a collapse.
+	static const float MAX_NORMAL_COS_SQUARED = 0.25f * 0.25f;
+
+	/// Simplification freedom of a vertex.
+	enum class SimplifyVertexKind : uint8_t
+	{
+		/// Interior vertex, can collapse onto any neighbour. On an attribute seam, only along the seam.
+		Manifold,
+		/// Vertex on an open border, can collapse onto a neighbour along the border.
+		Border,
+		/// Vertex on a non-manifold edge, can not collapse.
+		Locked
+	};
+
+	/// Symmetric 4x4 matrix that sums the squared distances to a set of planes.
+	struct Quadric
+	{
+		/// Add a plane ax + by + cz + d = 0 with unit normal and weight.
+		void AddPlane(double a, double b, double c, double d, double weight)
+		{
+			a2 += weight * a * a;
+			b2 += weight * b * b;
+			c2 += weight * c * c;
+			d2 += weight * d * d;
+			ab += weight * a * b;
+			ac += weight * a * c;
+			ad += weight * a * d;
+			bc += weight * b * c;
+			bd += weight * b * d;
+			cd += weight * c * d;
+		}
+
+		/// Add another quadric.
+		void Add(const Quadric& rhs)
+		{
+			a2 += rhs.a2;
+			b2 += rhs.b2;
+			c2 += rhs.c2;
+			d2 += rhs.d2;
+			ab += rhs.ab;
+			ac += rhs.ac;
+			ad += rhs.ad;
+			bc += rhs.bc;
+			bd += rhs.bd;
+			cd += rhs.cd;
+		}
+
+		/// Return the weighted sum of squared distances from a point to the planes.
+		double Error(const float* p) const
+		{
+			double x = p[0], y = p[1], z = p[2];
+			double error = a2 * x * x + b2 * y * y + c2 * z * z + d2 +
+				2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z);
+			return error > 0.0 ? error : 0.0;
+		}
+
+		double a2 = 0.0, b2 = 0.0, c2 = 0.0, d2 = 0.0;
+		double ab = 0.0, ac = 0.0, ad = 0.0, bc = 0.0, bd = 0.0, cd = 0.0;
+	};
+
+	/// Edge collapse candidate.
+	struct EdgeCollapse
+	{
+		/// Vertex to remove.
+		uint32_t from;
+		/// Vertex to keep.
+		uint32_t to;
+		/// Quadric error of the result.
+		double error;
+
+		/// Sort by error.
+		bool operator < (const EdgeCollapse& rhs) const { return error < rhs.error; }
+	};
+
+	static void Cross(float* dest, const float* p0, const float* p1, const float* p2)
+	{
+		float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		dest[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		dest[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		dest[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+	static uint64_t EdgeKey(uint32_t from, uint32_t to)
+	{
+		return ((uint64_t)from << 32) | to;
+	}
+
+	/// Collect the directed edges between vertices, and count the uses of each directed edge between positions.
+	static void CollectEdges(unordered_set<uint64_t>& vertexEdges, unordered_map<uint64_t, uint32_t>& positionEdges, const vector<uint32_t>& indices, const vector<uint32_t>& positionIds)
+	{
+		vertexEdges.clear();
+		positionEdges.clear();
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (unsigned k = 0; k < 3; ++k)
+			{
+				uint32_t from = indices[i + k];
+				uint32_t to = indices[i + (k + 1) % 3];
+				vertexEdges.insert(EdgeKey(from, to));
+				++positionEdges[EdgeKey(positionIds[from], positionIds[to])];
+			}
+		}
+	}
+
+	size_t SimplifyMesh(uint32_t* dest, const uint32_t* indices, size_t indexCount, const uint8_t* vertexData, size_t vertexCount, size_t vertexSize, size_t positionOffset, size_t targetIndexCount, float targetError, float* resultError)
+	{
+		if (resultError)
+			*resultError = 0.0f;
+
+		vector<uint32_t> result(indices, indices + indexCount / 3 * 3);
+		for (size_t i = 0; i < result.size(); ++i)
+		{
+			if (result[i] >= vertexCount)
+			{
+				memmove(dest, indices, indexCount * sizeof(uint32_t));
+				return indexCount;
+			}
+		}
+
+		// Read positions and scale them to the unit cube, so that the error is relative to the extents
+		vector<float> positions(vertexCount * 3);
+		for (size_t i = 0; i < vertexCount; ++i)
+			memcpy(&positions[i * 3], vertexData + i * vertexSize + positionOffset, 3 * sizeof(float));
+
+		float minimum[3] = { M_INFINITY, M_INFINITY, M_INFINITY };
+		float maximum[3] = { -M_INFINITY, -M_INFINITY, -M_INFINITY };
+		for (size_t i = 0; i < result.size(); ++i)
+		{
+			const float* p = &positions[result[i] * 3];
+			for (unsigned k = 0; k < 3; ++k)
+			{
+				minimum[k] = min(minimum[k], p[k]);
+				maximum[k] = max(maximum[k], p[k]);
+			}
+		}
+
+		float extent = 0.0f;
+		for (unsigned k = 0; k < 3; ++k)
+			extent = max(extent, maximum[k] - minimum[k]);
+		float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			for (unsigned k = 0; k < 3; ++k)
+				positions[i * 3 + k] = (positions[i * 3 + k] - minimum[k]) * scale;
+		}
+
+		// Identify positions by their first vertex, and link the referenced vertices of each position into a ring. Several vertices share a position on attribute seams
+		vector<uint32_t> positionIds(vertexCount);
+		vector<uint32_t> wedges(vertexCount);
+		{
+			vector<bool> referenced(vertexCount, false);
+			for (size_t i = 0; i < result.size(); ++i)
+				referenced[result[i]] = true;
+
+			unordered_map<string, uint32_t> firstVertices;
+			vector<uint32_t> lastWedges(vertexCount, INVALID_VERTEX);
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				string key(reinterpret_cast<const char*>(&positions[i * 3]), 3 * sizeof(float));
+				uint32_t positionId = firstVertices.insert(make_pair(key, static_cast<uint32_t>(i))).first->second;
+				positionIds[i] = positionId;
+				wedges[i] = static_cast<uint32_t>(i);
+
+				if (referenced[i])
+				{
+					uint32_t& last = lastWedges[positionId];
+					if (last != INVALID_VERTEX)
+					{
+						wedges[i] = wedges[last];
+						wedges[last] = static_cast<uint32_t>(i);
+					}
+					last = static_cast<uint32_t>(i);
+				}
+			}
+		}
+
+		// Classify positions by their edges. An edge without a reverse is on an open border, an edge used twice in the same direction is non-manifold
+		unordered_set<uint64_t> vertexEdges;
+		unordered_map<uint64_t, uint32_t> positionEdges;
+		CollectEdges(vertexEdges, positionEdges, result, positionIds);
+
+		vector<SimplifyVertexKind> kinds(vertexCount, SimplifyVertexKind::Manifold);
+		for (auto it = positionEdges.begin(); it != positionEdges.end(); ++it)
+		{
+			uint32_t from = static_cast<uint32_t>(it->first >> 32);
+			uint32_t to = static_cast<uint32_t>(it->first);
+			if (it->second > 1)
+				kinds[from] = kinds[to] = SimplifyVertexKind::Locked;
+			else if (positionEdges.find(EdgeKey(to, from)) == positionEdges.end())
+			{
+				kinds[from] = max(kinds[from], SimplifyVertexKind::Border);
+				kinds[to] = max(kinds[to], SimplifyVertexKind::Border);
+			}
+		}
+
+		// Accumulate the planes of the triangles around each position, and planes perpendicular to the triangles along open borders and attribute seams
+		vector<Quadric> quadrics(vertexCount);
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			const uint32_t* triangle = &result[i];
+			const float* p[3] = { &positions[triangle[0] * 3], &positions[triangle[1] * 3], &positions[triangle[2] * 3] };
+
+			float normal[3];
+			Cross(normal, p[0], p[1], p[2]);
+			float area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (area <= 0.0f)
+				continue;
+			for (unsigned k = 0; k < 3; ++k)
+				normal[k] /= area;
+
+			Quadric plane;
+			plane.AddPlane(normal[0], normal[1], normal[2], -(normal[0] * p[0][0] + normal[1] * p[0][1] + normal[2] * p[0][2]), area);
+			for (unsigned k = 0; k < 3; ++k)
+				quadrics[positionIds[triangle[k]]].Add(plane);
+
+			for (unsigned k = 0; k < 3; ++k)
+			{
+				uint32_t from = triangle[k];
+				uint32_t to = triangle[(k + 1) % 3];
+				if (vertexEdges.find(EdgeKey(to, from)) != vertexEdges.end())
+					continue;
+
+				const float* p0 = p[k];
+				const float* p1 = p[(k + 1) % 3];
+				float edge[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				float length = sqrtf(edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2]);
+				if (length <= 0.0f)
+					continue;
+
+				float side[3] = { edge[1] * normal[2] - edge[2] * normal[1], edge[2] * normal[0] - edge[0] * normal[2], edge[0] * normal[1] - edge[1] * normal[0] };
+				for (unsigned j = 0; j < 3; ++j)
+					side[j] /= length;
+
+				Quadric border;
+				border.AddPlane(side[0], side[1], side[2], -(side[0] * p0[0] + side[1] * p0[1] + side[2] * p0[2]), length * length * BORDER_WEIGHT);
+				quadrics[positionIds[from]].Add(border);
+				quadrics[positionIds[to]].Add(border);
+			}
+		}
+
+		double errorLimit = (double)targetError * targetError;
+		double maxError = 0.0;
+		targetIndexCount = targetIndexCount / 3 * 3;
+
+		vector<EdgeCollapse> collapses;
+		vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+		vector<uint32_t> adjacency;
+		vector<uint32_t> remap(vertexCount);
+		vector<uint32_t> partners;
+		vector<bool> touched(vertexCount);
+
+		// Collapse edges in passes, each collapse in a pass touching a disjoint neighbourhood
+		while (result.size() > targetIndexCount)
+		{
+			collapses.clear();
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				for (unsigned k = 0; k < 3; ++k)
+				{
+					uint32_t v0 = result[i + k];
+					uint32_t v1 = result[i + (k + 1) % 3];
+					bool borderEdge = positionEdges.find(EdgeKey(positionIds[v1], positionIds[v0])) == positionEdges.end();
+
+					for (unsigned j = 0; j < 2; ++j)
+					{
+						uint32_t from = j ? v1 : v0;
+						uint32_t to = j ? v0 : v1;
+						SimplifyVertexKind kind = kinds[positionIds[from]];
+						if (kind == SimplifyVertexKind::Locked || (kind == SimplifyVertexKind::Border && !borderEdge))
+							continue;
+
+						Quadric quadric = quadrics[positionIds[from]];
+						quadric.Add(quadrics[positionIds[to]]);
+						double error = quadric.Error(&positions[to * 3]);
+						if (error <= errorLimit)
+							collapses.push_back(EdgeCollapse{ from, to, error });
+					}
+				}
+			}
+
+			if (collapses.empty())
+				break;
+			sort(collapses.begin(), collapses.end());
+
+			// Triangles around each vertex
+			fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (size_t i = 0; i < result.size(); ++i)
+				++adjacencyOffsets[result[i] + 1];
+			for (size_t i = 0; i < vertexCount; ++i)
+				adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+			adjacency.resize(result.size());
+			{
+				vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (size_t i = 0; i < result.size(); ++i)
+					adjacency[fillOffsets[result[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+
+			for (size_t i = 0; i < vertexCount; ++i)
+				remap[i] = static_cast<uint32_t>(i);
+			fill(touched.begin(), touched.end(), false);
+
+			size_t removeTriangles = (result.size() - targetIndexCount) / 3;
+			size_t removedTriangles = 0;
+
+			for (auto it = collapses.begin(); it != collapses.end() && removedTriangles < removeTriangles; ++it)
+			{
+				uint32_t from = it->from;
+				uint32_t to = it->to;
+
+				// Each vertex at the removed position must move to a vertex it shares an edge with, so that attribute seams collapse along themselves
+				bool valid = true;
+				partners.clear();
+				uint32_t wedge = from;
+				do
+				{
+					uint32_t partner = INVALID_VERTEX;
+					uint32_t candidate = to;
+					do
+					{
+						if (vertexEdges.find(EdgeKey(wedge, candidate)) != vertexEdges.end() || vertexEdges.find(EdgeKey(candidate, wedge)) != vertexEdges.end())
+						{
+							partner = candidate;
+							break;
+						}
+						candidate = wedges[candidate];
+					} while (candidate != to);
+
+					if (partner == INVALID_VERTEX || touched[wedge] || touched[partner])
+					{
+						valid = false;
+						break;
+					}
+					partners.push_back(partner);
+					wedge = wedges[wedge];
+				} while (wedge != from);
+
+				if (!valid)
+					continue;
+
+				// Reject collapses that would flip or sharply turn a remaining triangle
+				const float* newPosition = &positions[to * 3];
+				size_t collapsedTriangles = 0;
+				wedge = from;
+				do
+				{
+					for (uint32_t j = adjacencyOffsets[wedge]; valid && j < adjacencyOffsets[wedge + 1]; ++j)
+					{
+						const uint32_t* triangle = &result[adjacency[j] * 3];
+						if (positionIds[triangle[0]] == positionIds[to] || positionIds[triangle[1]] == positionIds[to] || positionIds[triangle[2]] == positionIds[to])
+						{
+							++collapsedTriangles;
+							continue;
+						}
+
+						const float* p[3] = { &positions[triangle[0] * 3], &positions[triangle[1] * 3], &positions[triangle[2] * 3] };
+						float oldNormal[3], newNormal[3];
+						Cross(oldNormal, p[0], p[1], p[2]);
+						for (unsigned k = 0; k < 3; ++k)
+						{
+							if (triangle[k] == wedge)
+								p[k] = newPosition;
+						}
+						Cross(newNormal, p[0], p[1], p[2]);
+
+						float dot = oldNormal[0] * newNormal[0] + oldNormal[1] * newNormal[1] + oldNormal[2] * newNormal[2];
+						float lengthSquared = (oldNormal[0] * oldNormal[0] + oldNormal[1] * oldNormal[1] + oldNormal[2] * oldNormal[2]) *
+							(newNormal[0] * newNormal[0] + newNormal[1] * newNormal[1] + newNormal[2] * newNormal[2]);
+						if (dot <= 0.0f || dot * dot < MAX_NORMAL_COS_SQUARED * lengthSquared)
+							valid = false;
+					}
+					wedge = wedges[wedge];
+				} while (valid && wedge != from);
+
+				if (!valid)
+					continue;
+
+				quadrics[positionIds[to]].Add(quadrics[positionIds[from]]);
+				maxError = max(maxError, it->error);
+				removedTriangles += collapsedTriangles;
+
+				size_t partnerIndex = 0;
+				wedge = from;
+				do
+				{
+					remap[wedge] = partners[partnerIndex++];
+					for (uint32_t j = adjacencyOffsets[wedge]; j < adjacencyOffsets[wedge + 1]; ++j)
+					{
+						const uint32_t* triangle = &result[adjacency[j] * 3];
+						touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+					}
+					wedge = wedges[wedge];
+				} while (wedge != from);
+
+				wedge = to;
+				do
+				{
+					touched[wedge] = true;
+					wedge = wedges[wedge];
+				} while (wedge != to);
+			}
+
+			if (!removedTriangles)
+				break;
+
+			// Remap and drop the triangles that became degenerate
+			size_t writeIndex = 0;
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				uint32_t v0 = remap[result[i]];
+				uint32_t v1 = remap[result[i + 1]];
+				uint32_t v2 = remap[result[i + 2]];
+				if (positionIds[v0] == positionIds[v1] || positionIds[v1] == positionIds[v2] || positionIds[v0] == positionIds[v2])
+					continue;
+
+				result[writeIndex++] = v0;
+				result[writeIndex++] = v1;
+				result[writeIndex++] = v2;
+			}
+			result.resize(writeIndex);
+			CollectEdges(vertexEdges, positionEdges, result, positionIds);
+		}
+
+		if (resultError)
+			*resultError = static_cast<float>(sqrt(maxError));
+		if (!result.empty())
+			memcpy(dest, result.data(), result.size() * sizeof(uint32_t));
+		return result.size();
+	}
+
+	bool GenerateModelLods(ModelData& model, const vector<ModelLodLevel>& levels, float targetError)
+	{
+		for (size_t i = 0; i < levels.size(); ++i)
+		{
+			if (levels[i].ratio <= 0.0f || levels[i].ratio >= 1.0f || (i > 0 && (levels[i].ratio >= levels[i - 1].ratio ||
+				levels[i].distance <= levels[i - 1].distance)))
+			{
+				ALIMER_LOGERROR("LOD levels must have decreasing ratios between 0 and 1 and increasing distances");
+				return false;
+			}
+		}
+
+		vector<vector<uint32_t> > addedIndices(model.indexBuffers.size());
+		vector<uint32_t> indices;
+		vector<uint32_t> lodIndices;
+
+		for (auto geomIt = model.geometries.begin(); geomIt != model.geometries.end(); ++geomIt)
+		{
+			if (geomIt->size() != 1)
+				continue;
+
+			GeometryDesc desc = geomIt->front();
+			if (desc.primitiveType != TRIANGLE_LIST || desc.vbRef >= model.vertexBuffers.size() || desc.ibRef >= model.indexBuffers.size())
+				continue;
+
+			const VertexBufferDesc& vbDesc = model.vertexBuffers[desc.vbRef];
+			const IndexBufferDesc& ibDesc = model.indexBuffers[desc.ibRef];
+			if ((uint64_t)desc.drawStart + desc.drawCount > ibDesc.indexCount)
+				continue;
+
+			size_t positionOffset;
+			size_t vertexSize = GetVertexLayout(vbDesc, positionOffset);
+			if (positionOffset == NO_VERTEX_POSITION)
+				continue;
+
+			indices.resize(desc.drawCount);
+			for (uint32_t i = 0; i < desc.drawCount; ++i)
+			{
+				indices[i] = ibDesc.indexType == IndexType::UInt16 ? reinterpret_cast<const uint16_t*>(ibDesc.indexData.get())[desc.drawStart + i] :
+					reinterpret_cast<const uint32_t*>(ibDesc.indexData.get())[desc.drawStart + i];
+			}
+
+			// Simplify each level from the previous one
+			size_t triangleCount = desc.drawCount / 3;
+			for (auto levelIt = levels.begin(); levelIt != levels.end(); ++levelIt)
+			{
+				size_t targetIndexCount = max((size_t)(triangleCount * levelIt->ratio), (size_t)1) * 3;
+				size_t indexCount = SimplifyMesh(indices.data(), indices.data(), indices.size(), vbDesc.vertexData.get(), vbDesc.vertexCount,
+					vertexSize, positionOffset, targetIndexCount, targetError);
+				if (!indexCount || indexCount >= indices.size())
+					break;
+
+				indices.resize(indexCount);
+				lodIndices.resize(indexCount);
+				OptimizeVertexCache(lodIndices.data(), indices.data(), indexCount, vbDesc.vertexCount);
+
+				vector<uint32_t>& added = addedIndices[desc.ibRef];
+				GeometryDesc lodDesc = desc;
+				lodDesc.lodDistance = levelIt->distance;
+				lodDesc.drawStart = static_cast<unsigned>(ibDesc.indexCount + added.size());
+				lodDesc.drawCount = static_cast<unsigned>(indexCount);
+				geomIt->push_back(lodDesc);
+				added.insert(added.end(), lodIndices.begin(), lodIndices.end());
+			}
+		}
+
+		for (size_t i = 0; i < model.indexBuffers.size(); ++i)
+		{
+			const vector<uint32_t>& added = addedIndices[i];
+			if (added.empty())
+				continue;
+
+			IndexBufferDesc& ibDesc = model.indexBuffers[i];
+			size_t indexSize = ibDesc.indexType == IndexType::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+			shared_ptr<uint8_t> data(new uint8_t[(ibDesc.indexCount + added.size()) * indexSize], default_delete<uint8_t[]>());
+			if (ibDesc.indexCount)
+				memcpy(data.get(), ibDesc.indexData.get(), ibDesc.indexCount * indexSize);
+
+			if (ibDesc.indexType == IndexType::UInt16)
+			{
+				uint16_t* dest = reinterpret_cast<uint16_t*>(data.get()) + ibDesc.indexCount;
+				for (size_t j = 0; j < added.size(); ++j)
+					dest[j] = static_cast<uint16_t>(added[j]);
+			}
+			else
+				memcpy(reinterpret_cast<uint32_t*>(data.get()) + ibDesc.indexCount, added.data(), added.size() * sizeof(uint32_t));
+
+			ibDesc.indexData = data;
+			ibDesc.indexCount += static_cast<uint32_t>(added.size());
+		}
+
+		return true;
+	}
+}
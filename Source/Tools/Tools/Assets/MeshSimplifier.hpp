@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Alimer
+{
+	class ModelData;
+
+	/// Description of a LOD level to generate.
+	struct ModelLodLevel
+	{
+		/// Target triangle count relative to the full detail geometry.
+		float ratio;
+		/// LOD distance from which the level is used.
+		float distance;
+	};
+
+	/// Default maximum simplification error, relative to the mesh extents.
+	static const float DEFAULT_LOD_TARGET_ERROR = 0.01f;
+
+	/// Simplify a triangle list by collapsing edges in order of quadric error. Open borders and attribute seams only collapse along themselves. Stop at the target index count or before exceeding the target error, relative to the mesh extents. Return the new index count and optionally the error reached. Destination may be the same as the source.
+	size_t SimplifyMesh(uint32_t* dest, const uint32_t* indices, size_t indexCount, const uint8_t* vertexData, size_t vertexCount, size_t vertexSize, size_t positionOffset, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+	/// Generate LOD levels for the triangle list geometries of a model that only have full detail, appending the indices to their index buffers. Levels must have decreasing ratios and increasing distances. Levels that would not reduce the triangle count within the target error are left out. Return true on success.
+	bool GenerateModelLods(ModelData& model, const std::vector<ModelLodLevel>& levels, float targetError = DEFAULT_LOD_TARGET_ERROR);
+}
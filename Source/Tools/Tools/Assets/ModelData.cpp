@@ -0,0 +1,239 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "ModelData.hpp"
+#include "Debug/Log.h"
+#include "IO/Stream.h"
+#include "Renderer/ModelFormat.h"
+#include <cstring>
+using namespace std;
+
+namespace Alimer
+{
+	static bool GetModelFileSemantic(const char* semanticName, ModelFileSemantic& semantic)
+	{
+		for (size_t i = 0; i < static_cast<size_t>(ModelFileSemantic::Count); ++i)
+		{
+			if (!strcmp(semanticName, modelFileSemantics[i]))
+			{
+				semantic = static_cast<ModelFileSemantic>(i);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/// Align the offset for a block of the given size, advance past the block and return its start.
+	static uint64_t AddModelFileBlock(uint64_t& offset, uint64_t size)
+	{
+		offset = AlignModelFileOffset(offset);
+		uint64_t start = offset;
+		offset += size;
+		return start;
+	}
+
+	/// Write zeros until the stream is at an offset relative to the file start.
+	static void WritePadding(Stream& dest, size_t fileStart, uint64_t offset)
+	{
+		static const uint8_t padding[MODEL_FILE_ALIGNMENT] = { 0 };
+		size_t position = dest.Position() - fileStart;
+		if (offset > position)
+			dest.Write(padding, static_cast<size_t>(offset - position));
+	}
+
+	template <class T> static void WriteModelFileBlock(Stream& dest, size_t fileStart, const vector<T>& records)
+	{
+		WritePadding(dest, fileStart, AlignModelFileOffset(dest.Position() - fileStart));
+		if (records.size())
+			dest.Write(records.data(), records.size() * sizeof(T));
+	}
+
+	bool ModelData::Load(Stream& source)
+	{
+		Model model;
+		if (!model.BeginLoad(source))
+			return false;
+
+		vertexBuffers = model.GetVertexBufferDescs();
+		indexBuffers = model.GetIndexBufferDescs();
+		geometries = model.GetGeometryDescs();
+		boneMappings = model.GetBoneMappings();
+		bones = model.GetBones();
+		boundingBox = model.LocalBoundingBox();
+		return true;
+	}
+
+	bool ModelData::Save(Stream& dest) const
+	{
+		ModelFileHeader header;
+		memset(&header, 0, sizeof header);
+		memcpy(header.fileID, MODEL_FILE_ID, sizeof header.fileID);
+		header.version = MODEL_FILE_VERSION;
+		memcpy(&header.boundingBox[0], boundingBox.min.Data(), 3 * sizeof(float));
+		memcpy(&header.boundingBox[3], boundingBox.max.Data(), 3 * sizeof(float));
+
+		vector<ModelFileVertexBuffer> vbRecords(vertexBuffers.size());
+		vector<ModelFileVertexElement> elementRecords;
+		for (size_t i = 0; i < vertexBuffers.size(); ++i)
+		{
+			const VertexBufferDesc& vbDesc = vertexBuffers[i];
+			ModelFileVertexBuffer& record = vbRecords[i];
+
+			// Zero offsets for all elements mean that they are packed in order
+			bool autoOffset = true;
+			for (auto it = vbDesc.vertexElements.begin(); it != vbDesc.vertexElements.end(); ++it)
+			{
+				if (it->offset)
+					autoOffset = false;
+			}
+
+			record.vertexCount = vbDesc.vertexCount;
+			record.vertexSize = 0;
+			record.firstElement = static_cast<uint32_t>(elementRecords.size());
+			record.numElements = static_cast<uint32_t>(vbDesc.vertexElements.size());
+
+			for (auto it = vbDesc.vertexElements.begin(); it != vbDesc.vertexElements.end(); ++it)
+			{
+				ModelFileVertexElement element;
+				if (!GetModelFileSemantic(it->semanticName, element.semantic))
+				{
+					ALIMER_LOGERROR("Unsupported vertex element semantic " + std::string(it->semanticName));
+					return false;
+				}
+
+				element.semanticIndex = static_cast<uint8_t>(it->semanticIndex);
+				element.format = static_cast<uint8_t>(it->format);
+				element.padding = 0;
+				element.offset = autoOffset ? record.vertexSize : it->offset;
+				elementRecords.push_back(element);
+				record.vertexSize += GetVertexFormatSize(it->format);
+			}
+		}
+
+		vector<ModelFileIndexBuffer> ibRecords(indexBuffers.size());
+		for (size_t i = 0; i < indexBuffers.size(); ++i)
+		{
+			ibRecords[i].indexCount = indexBuffers[i].indexCount;
+			ibRecords[i].indexSize = indexBuffers[i].indexType == IndexType::UInt16 ? 2 : 4;
+		}
+
+		vector<ModelFileGeometry> geometryRecords(geometries.size());
+		vector<GeometryDesc> lodLevels;
+		vector<uint32_t> boneMappingIndices;
+		for (size_t i = 0; i < geometries.size(); ++i)
+		{
+			ModelFileGeometry& record = geometryRecords[i];
+			record.firstLodLevel = static_cast<uint32_t>(lodLevels.size());
+			record.numLodLevels = static_cast<uint32_t>(geometries[i].size());
+			lodLevels.insert(lodLevels.end(), geometries[i].begin(), geometries[i].end());
+
+			record.firstBoneMapping = static_cast<uint32_t>(boneMappingIndices.size());
+			record.numBoneMappings = 0;
+			if (i < boneMappings.size())
+			{
+				record.numBoneMappings = static_cast<uint32_t>(boneMappings[i].size());
+				for (auto it = boneMappings[i].begin(); it != boneMappings[i].end(); ++it)
+					boneMappingIndices.push_back(static_cast<uint32_t>(*it));
+			}
+		}
+
+		vector<ModelFileBone> boneRecords(bones.size());
+		vector<char> boneNames;
+		for (size_t i = 0; i < bones.size(); ++i)
+		{
+			const Bone& bone = bones[i];
+			ModelFileBone& record = boneRecords[i];
+
+			record.nameOffset = static_cast<uint32_t>(boneNames.size());
+			boneNames.insert(boneNames.end(), bone.name.begin(), bone.name.end());
+			boneNames.push_back(0);
+
+			record.parentIndex = static_cast<uint32_t>(bone.parentIndex);
+			memcpy(record.initialPosition, bone.initialPosition.Data(), sizeof record.initialPosition);
+			record.initialRotation[0] = bone.initialRotation.x;
+			record.initialRotation[1] = bone.initialRotation.y;
+			record.initialRotation[2] = bone.initialRotation.z;
+			record.initialRotation[3] = bone.initialRotation.w;
+			memcpy(record.initialScale, bone.initialScale.Data(), sizeof record.initialScale);
+			memcpy(record.offsetMatrix, bone.offsetMatrix.Data(), sizeof record.offsetMatrix);
+			record.radius = bone.radius;
+			memcpy(&record.boundingBox[0], bone.boundingBox.min.Data(), 3 * sizeof(float));
+			memcpy(&record.boundingBox[3], bone.boundingBox.max.Data(), 3 * sizeof(float));
+		}
+
+		header.numVertexBuffers = static_cast<uint32_t>(vbRecords.size());
+		header.numVertexElements = static_cast<uint32_t>(elementRecords.size());
+		header.numIndexBuffers = static_cast<uint32_t>(ibRecords.size());
+		header.numGeometries = static_cast<uint32_t>(geometryRecords.size());
+		header.numLodLevels = static_cast<uint32_t>(lodLevels.size());
+		header.numBoneMappings = static_cast<uint32_t>(boneMappingIndices.size());
+		header.numBones = static_cast<uint32_t>(boneRecords.size());
+		header.boneNamesSize = static_cast<uint32_t>(boneNames.size());
+
+		// Lay out the descriptor blocks, then the data blocks
+		uint64_t offset = sizeof header;
+		AddModelFileBlock(offset, vbRecords.size() * sizeof(ModelFileVertexBuffer));
+		AddModelFileBlock(offset, elementRecords.size() * sizeof(ModelFileVertexElement));
+		AddModelFileBlock(offset, ibRecords.size() * sizeof(ModelFileIndexBuffer));
+		AddModelFileBlock(offset, geometryRecords.size() * sizeof(ModelFileGeometry));
+		AddModelFileBlock(offset, lodLevels.size() * sizeof(GeometryDesc));
+		AddModelFileBlock(offset, boneMappingIndices.size() * sizeof(uint32_t));
+		AddModelFileBlock(offset, boneRecords.size() * sizeof(ModelFileBone));
+		AddModelFileBlock(offset, boneNames.size());
+		for (size_t i = 0; i < vbRecords.size(); ++i)
+			vbRecords[i].dataOffset = AddModelFileBlock(offset, (uint64_t)vbRecords[i].vertexCount * vbRecords[i].vertexSize);
+		for (size_t i = 0; i < ibRecords.size(); ++i)
+			ibRecords[i].dataOffset = AddModelFileBlock(offset, (uint64_t)ibRecords[i].indexCount * ibRecords[i].indexSize);
+
+		size_t fileStart = dest.Position();
+		dest.Write(&header, sizeof header);
+		WriteModelFileBlock(dest, fileStart, vbRecords);
+		WriteModelFileBlock(dest, fileStart, elementRecords);
+		WriteModelFileBlock(dest, fileStart, ibRecords);
+		WriteModelFileBlock(dest, fileStart, geometryRecords);
+		WriteModelFileBlock(dest, fileStart, lodLevels);
+		WriteModelFileBlock(dest, fileStart, boneMappingIndices);
+		WriteModelFileBlock(dest, fileStart, boneRecords);
+		WriteModelFileBlock(dest, fileStart, boneNames);
+
+		for (size_t i = 0; i < vbRecords.size(); ++i)
+		{
+			WritePadding(dest, fileStart, vbRecords[i].dataOffset);
+			dest.Write(vertexBuffers[i].vertexData.get(), static_cast<size_t>((uint64_t)vbRecords[i].vertexCount * vbRecords[i].vertexSize));
+		}
+		for (size_t i = 0; i < ibRecords.size(); ++i)
+		{
+			WritePadding(dest, fileStart, ibRecords[i].dataOffset);
+			dest.Write(indexBuffers[i].indexData.get(), static_cast<size_t>((uint64_t)ibRecords[i].indexCount * ibRecords[i].indexSize));
+		}
+
+		if (dest.Position() - fileStart != offset)
+		{
+			ALIMER_LOGERROR("Could not write model file " + dest.GetName());
+			return false;
+		}
+
+		return true;
+	}
+}
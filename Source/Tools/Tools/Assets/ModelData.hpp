@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Renderer/Model.h"
+#include <vector>
+
+namespace Alimer
+{
+	class Stream;
+
+	/// Editable model data for asset processing. Loads any model format the engine supports and saves the Alimer model format.
+	class ModelData
+	{
+	public:
+		/// Load from a stream. Return true on success.
+		bool Load(Stream& source);
+		/// Save in the Alimer model format. Return true on success.
+		bool Save(Stream& dest) const;
+
+		/// Vertex buffers.
+		std::vector<VertexBufferDesc> vertexBuffers;
+		/// Index buffers.
+		std::vector<IndexBufferDesc> indexBuffers;
+		/// LOD levels of each geometry.
+		std::vector<std::vector<GeometryDesc> > geometries;
+		/// Bone mappings of each geometry.
+		std::vector<std::vector<size_t> > boneMappings;
+		/// Bones.
+		std::vector<Bone> bones;
+		/// Local space bounding box.
+		BoundingBox boundingBox;
+	};
+}
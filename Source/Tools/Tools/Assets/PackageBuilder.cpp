@@ -0,0 +1,188 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "PackageBuilder.hpp"
+#include "Base/StringHash.h"
+#include "Debug/Log.h"
+#include "IO/Compression.h"
+#include "IO/File.h"
+#include "IO/FileSystem.h"
+#include "IO/PackageFile.h"
+#include <algorithm>
+using namespace std;
+
+namespace Alimer
+{
+	bool PackageBuilder::AddFile(const string& name, vector<uint8_t>&& data)
+	{
+		string fixedName = NormalizePath(name);
+		while (str::StartsWith(fixedName, "./") || str::StartsWith(fixedName, "/"))
+			fixedName = fixedName.substr(fixedName.find('/') + 1);
+
+		if (fixedName.empty())
+		{
+			ALIMER_LOGERROR("Can not add a package file entry with an empty name");
+			return false;
+		}
+
+		// Names are looked up by case-insensitive hash only, so a collision can not be stored
+		StringHash nameHash(fixedName);
+		for (auto it = _files.begin(); it != _files.end(); ++it)
+		{
+			if (StringHash(it->name) == nameHash)
+			{
+				ALIMER_LOGERROR("Package file entry " + fixedName + " has the same name hash as " + it->name);
+				return false;
+			}
+		}
+
+		if (data.size() > 0xffffffffu)
+		{
+			ALIMER_LOGERROR("Package file entry " + fixedName + " is too large");
+			return false;
+		}
+
+		_files.push_back(File{ fixedName, move(data) });
+		return true;
+	}
+
+	bool PackageBuilder::AddDirectory(const string& pathName)
+	{
+		if (!DirectoryExists(pathName))
+		{
+			ALIMER_LOGERROR("Could not open directory " + pathName);
+			return false;
+		}
+
+		string path = AddTrailingSlash(pathName);
+		vector<string> fileNames;
+		ScanDir(fileNames, path, "*.*", SCAN_FILES, true);
+		sort(fileNames.begin(), fileNames.end());
+
+		for (auto it = fileNames.begin(); it != fileNames.end(); ++it)
+		{
+			Alimer::File file(path + *it);
+			if (!file.IsOpen())
+			{
+				ALIMER_LOGERROR("Could not open file " + path + *it);
+				return false;
+			}
+
+			vector<uint8_t> data(file.Size());
+			if (file.Read(data.data(), data.size()) != data.size())
+			{
+				ALIMER_LOGERROR("Could not read file " + path + *it);
+				return false;
+			}
+
+			if (!AddFile(*it, move(data)))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool PackageBuilder::Save(const string& fileName) const
+	{
+		// Sort by name hash for binary search when loading
+		vector<const File*> files;
+		for (auto it = _files.begin(); it != _files.end(); ++it)
+			files.push_back(&(*it));
+		sort(files.begin(), files.end(), [](const File* lhs, const File* rhs)
+		{
+			return StringHash(lhs->name).Value() < StringHash(rhs->name).Value();
+		});
+
+		// Compress first to know the stored sizes
+		vector<vector<uint8_t> > packedData(files.size());
+		if (_compress)
+		{
+			for (size_t i = 0; i < files.size(); ++i)
+			{
+				const vector<uint8_t>& data = files[i]->data;
+				vector<uint8_t>& packed = packedData[i];
+				packed.resize(EstimateCompressBound(data.size()));
+				packed.resize(CompressData(packed.data(), data.data(), data.size()));
+				if (packed.size() >= data.size())
+					packed.clear();
+			}
+		}
+
+		uint32_t namesSize = 0;
+		for (size_t i = 0; i < files.size(); ++i)
+			namesSize += static_cast<uint32_t>(files[i]->name.length() + 1);
+
+		uint64_t dataOffset = PACKAGE_HEADER_SIZE + files.size() * PACKAGE_INDEX_ENTRY_SIZE + namesSize;
+
+		Alimer::File file(fileName, FileMode::Write);
+		if (!file.IsOpen())
+		{
+			ALIMER_LOGERROR("Could not open package file " + fileName + " for writing");
+			return false;
+		}
+
+		file.WriteFileID(PACKAGE_FILE_ID);
+		file.WriteUInt(PACKAGE_FILE_VERSION);
+		file.WriteUInt(static_cast<uint32_t>(files.size()));
+		file.WriteUInt(namesSize);
+
+		vector<uint64_t> offsets(files.size());
+		uint32_t nameOffset = 0;
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			const vector<uint8_t>& data = files[i]->data;
+			uint32_t packedSize = static_cast<uint32_t>(packedData[i].size() ? packedData[i].size() : data.size());
+
+			dataOffset = (dataOffset + PACKAGE_DATA_ALIGNMENT - 1) & ~(uint64_t)(PACKAGE_DATA_ALIGNMENT - 1);
+			offsets[i] = dataOffset;
+
+			file.WriteUInt(StringHash(files[i]->name).Value());
+			file.WriteUInt(nameOffset);
+			file.WriteUInt64(dataOffset);
+			file.WriteUInt(static_cast<uint32_t>(data.size()));
+			file.WriteUInt(packedSize);
+
+			nameOffset += static_cast<uint32_t>(files[i]->name.length() + 1);
+			dataOffset += packedSize;
+		}
+
+		for (size_t i = 0; i < files.size(); ++i)
+			file.Write(files[i]->name.c_str(), files[i]->name.length() + 1);
+
+		// Pad each entry to its aligned offset, so that borrowed data is aligned in memory
+		static const uint8_t padding[PACKAGE_DATA_ALIGNMENT] = { 0 };
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			file.Write(padding, static_cast<size_t>(offsets[i] - file.Position()));
+
+			const vector<uint8_t>& data = packedData[i].size() ? packedData[i] : files[i]->data;
+			if (file.Write(data.data(), data.size()) != data.size())
+			{
+				ALIMER_LOGERROR("Could not write package file " + fileName);
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
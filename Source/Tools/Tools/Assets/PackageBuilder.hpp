@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Alimer
+{
+	/// Builds package files that can be mounted to the resource cache.
+	class PackageBuilder
+	{
+	public:
+		/// Constructor.
+		PackageBuilder() = default;
+
+		/// Add a file under a resource name. Return false if the name is empty or already used.
+		bool AddFile(const std::string& name, std::vector<uint8_t>&& data);
+		/// Add all files from a directory recursively, named relative to the directory. Return false if the directory can not be read.
+		bool AddDirectory(const std::string& pathName);
+		/// Set whether to LZ4 compress entries. Entries that do not get smaller are stored uncompressed.
+		void SetCompression(bool enable) { _compress = enable; }
+		/// Write the package file. Return true on success.
+		bool Save(const std::string& fileName) const;
+
+		/// Return number of files added.
+		size_t GetNumFiles() const { return _files.size(); }
+
+	private:
+		struct File
+		{
+			std::string name;
+			std::vector<uint8_t> data;
+		};
+
+		std::vector<File> _files;
+		bool _compress = false;
+	};
+}